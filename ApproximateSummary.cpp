@@ -0,0 +1,241 @@
+//ApproximateSummary.cpp
+//Implementation of ApproximateSummary class
+
+#include "ApproximateSummary.h"
+#include "BoundedHeap.h"
+#include "Hash.h"
+
+#include <deque>
+#include <unordered_map>
+using std::deque;
+using std::unordered_map;
+
+
+//the seeds for hashing the names, so that a server and an owner with the same name are different keys
+const unsigned long long SERVER_SEED = 1;
+const unsigned long long OWNER_SEED = 2;
+
+const size_t COUNTER_BYTES = 160; //about the memory taken by a heavy hitter, with its slot, index entry and name
+const unsigned SKETCH_DEPTH = 5; //the rows of each count-min sketch, so an estimate is within its error bound 99.3% of the time
+const unsigned SERVER_PRECISION = 8; //of the distinct owners on each server (256 bytes, 6.5% standard error)
+const unsigned TOTAL_PRECISION = 14; //of the distinct servers and owners overall (16 KB, 0.8% standard error)
+
+//the shares of the memory budget, in percent
+const size_t SERVERS_SHARE = 15;
+const size_t OWNERS_SHARE = 15;
+const size_t PAIRS_SHARE = 40;
+const size_t CRITICAL_SHARE = 5;
+const size_t SERVER_SKETCH_SHARE = 5;
+const size_t OWNER_SKETCH_SHARE = 5;
+const size_t PAIR_SKETCH_SHARE = 15;
+
+
+bool more_estimated::operator()(const estimated_count& count1, const estimated_count& count2) const{
+	if(count1.high != count2.high){
+		return (count1.high > count2.high);
+	}
+	else{
+		return (count1.name > count2.name);
+	}
+}
+
+//the number of items of item_bytes which fit in share percent of budget
+static size_t share_of(size_t budget, size_t share, size_t item_bytes){
+	return (budget / 100) * share / item_bytes;
+}
+
+//set the name of the slot, which is new if it's past the end of names
+static void keep_name(vector<string>& names, size_t slot, bool replaced, string_view name){
+	if(slot == names.size()){
+		names.push_back(string(name));
+	}
+	else if(replaced){
+		names[slot] = name;
+	}
+}
+
+
+ApproximateSummary::ApproximateSummary(size_t memory_budget) :
+	memory_budget(memory_budget), files(0),
+	servers(share_of(memory_budget, SERVERS_SHARE, COUNTER_BYTES + ((size_t)1 << SERVER_PRECISION))),
+	owners(share_of(memory_budget, OWNERS_SHARE, COUNTER_BYTES)),
+	pairs(share_of(memory_budget, PAIRS_SHARE, COUNTER_BYTES + sizeof(string))),
+	critical(share_of(memory_budget, CRITICAL_SHARE, COUNTER_BYTES)),
+	server_sketch(share_of(memory_budget, SERVER_SKETCH_SHARE, sizeof(unsigned long long) * SKETCH_DEPTH), SKETCH_DEPTH),
+	owner_sketch(share_of(memory_budget, OWNER_SKETCH_SHARE, sizeof(unsigned long long) * SKETCH_DEPTH), SKETCH_DEPTH),
+	pair_sketch(share_of(memory_budget, PAIR_SKETCH_SHARE, sizeof(unsigned long long) * SKETCH_DEPTH), SKETCH_DEPTH),
+	all_servers(TOTAL_PRECISION), all_owners(TOTAL_PRECISION)
+{
+}
+
+void ApproximateSummary::add(const WWFStore& store){
+
+	for(symbol s = 0; s < store.num_servers(); s++){
+
+		const deque<WWF_data>& server_pairs = store.server_pairs(s);
+		if(server_pairs.empty()) continue;
+
+		const string_view server_name = store.server_name(s);
+		const unsigned long long server_key = hash_bytes(server_name, SERVER_SEED);
+
+		unsigned long long server_files = 0, server_critical = 0;
+		for(deque<WWF_data>::const_iterator i = server_pairs.begin(); i != server_pairs.end(); i++){
+			server_files += i->count;
+			server_critical += i->critical;
+		}
+
+		bool replaced;
+		const size_t server_slot = servers.add(server_key, server_files, replaced);
+		keep_name(server_names, server_slot, replaced, server_name);
+
+		//a server which takes over a slot starts counting its owners again
+		if(server_slot == server_owners.size()){
+			server_owners.push_back(HyperLogLog(SERVER_PRECISION));
+		}
+		else if(replaced){
+			server_owners[server_slot].clear();
+		}
+
+		server_sketch.add(server_key, server_files);
+		all_servers.add(server_key);
+
+		for(deque<WWF_data>::const_iterator i = server_pairs.begin(); i != server_pairs.end(); i++){
+
+			const string_view owner_name = store.owner_name(i->owner);
+			const unsigned long long owner_key = hash_bytes(owner_name, OWNER_SEED);
+
+			const size_t owner_slot = owners.add(owner_key, i->count, replaced);
+			keep_name(owner_names, owner_slot, replaced, owner_name);
+			owner_sketch.add(owner_key, i->count);
+
+			const unsigned long long pair_key = hash_combine(server_key, owner_key);
+			const size_t pair_slot = pairs.add(pair_key, i->count, replaced);
+			keep_name(pair_servers, pair_slot, replaced, server_name);
+			keep_name(pair_owners, pair_slot, replaced, owner_name);
+			pair_sketch.add(pair_key, i->count);
+
+			server_owners[server_slot].add(owner_key);
+			all_owners.add(owner_key);
+		}
+
+		if(server_critical > 0){
+			const size_t critical_slot = critical.add(server_key, server_critical, replaced);
+			keep_name(critical_names, critical_slot, replaced, server_name);
+		}
+
+		files += server_files;
+	}
+}
+
+bool ApproximateSummary::empty() const{
+	return (files == 0);
+}
+
+size_t ApproximateSummary::memory() const{
+	return memory_budget;
+}
+
+unsigned long long ApproximateSummary::total_files() const{
+	return files;
+}
+
+double ApproximateSummary::distinct_servers() const{
+	return all_servers.estimate();
+}
+
+double ApproximateSummary::distinct_owners() const{
+	return all_owners.estimate();
+}
+
+double ApproximateSummary::owners_error() const{
+	return HyperLogLog(SERVER_PRECISION).standard_error();
+}
+
+//the range of the count in the slot
+//the heavy hitter count is never less than the true count, and neither is the sketch's estimate, so the smaller one is the upper bound
+estimated_count ApproximateSummary::estimate(const HeavyHitters& counts, const CountMinSketch* sketch, size_t slot, const string& name) const{
+
+	estimated_count count;
+
+	count.name = name;
+	count.high = counts.count(slot);
+	count.low = count.high - counts.error(slot);
+	count.owners = 0;
+
+	if(sketch != NULL){
+		const unsigned long long sketch_estimate = sketch->estimate(counts.key(slot));
+		if(sketch_estimate < count.high) count.high = sketch_estimate;
+	}
+
+	return count;
+}
+
+void ApproximateSummary::top_servers(size_t limit, size_t owners_limit, vector<estimated_count>& top, vector<vector<estimated_count> >& top_owners) const{
+
+	BoundedHeap<estimated_count, more_estimated> top_counts(limit);
+	for(size_t slot = 0; slot < servers.size(); slot++){
+		estimated_count count = estimate(servers, &server_sketch, slot, server_names[slot]);
+		count.owners = server_owners[slot].estimate();
+		top_counts.push(count);
+	}
+
+	top = top_counts.sorted();
+
+	//the owners of each of the top servers, found in a single pass over the pairs
+	unordered_map<string_view, size_t> position;
+	for(size_t i = 0; i < top.size(); i++){
+		position[top[i].name] = i;
+	}
+
+	vector<BoundedHeap<estimated_count, more_estimated> > owner_counts(top.size(), BoundedHeap<estimated_count, more_estimated>(owners_limit));
+	for(size_t slot = 0; slot < pairs.size(); slot++){
+		unordered_map<string_view, size_t>::iterator i = position.find(pair_servers[slot]);
+		if(i != position.end()){
+			owner_counts[i->second].push(estimate(pairs, &pair_sketch, slot, pair_owners[slot]));
+		}
+	}
+
+	top_owners.clear();
+	for(size_t i = 0; i < owner_counts.size(); i++){
+		top_owners.push_back(owner_counts[i].sorted());
+	}
+}
+
+void ApproximateSummary::top_owners(size_t limit, size_t servers_limit, vector<estimated_count>& top, vector<vector<estimated_count> >& top_servers) const{
+
+	BoundedHeap<estimated_count, more_estimated> top_counts(limit);
+	for(size_t slot = 0; slot < owners.size(); slot++){
+		top_counts.push(estimate(owners, &owner_sketch, slot, owner_names[slot]));
+	}
+
+	top = top_counts.sorted();
+
+	//the servers of each of the top owners, found in a single pass over the pairs
+	unordered_map<string_view, size_t> position;
+	for(size_t i = 0; i < top.size(); i++){
+		position[top[i].name] = i;
+	}
+
+	vector<BoundedHeap<estimated_count, more_estimated> > server_counts(top.size(), BoundedHeap<estimated_count, more_estimated>(servers_limit));
+	for(size_t slot = 0; slot < pairs.size(); slot++){
+		unordered_map<string_view, size_t>::iterator i = position.find(pair_owners[slot]);
+		if(i != position.end()){
+			server_counts[i->second].push(estimate(pairs, &pair_sketch, slot, pair_servers[slot]));
+		}
+	}
+
+	top_servers.clear();
+	for(size_t i = 0; i < server_counts.size(); i++){
+		top_servers.push_back(server_counts[i].sorted());
+	}
+}
+
+vector<estimated_count> ApproximateSummary::critical_servers() const{
+
+	BoundedHeap<estimated_count, more_estimated> top_counts(critical.size());
+	for(size_t slot = 0; slot < critical.size(); slot++){
+		top_counts.push(estimate(critical, NULL, slot, critical_names[slot]));
+	}
+
+	return top_counts.sorted();
+}
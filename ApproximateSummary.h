@@ -0,0 +1,97 @@
+/*
+
+ApproximateSummary.h
+
+ApproximateSummary is a class which holds what the summary report needs to know about the owner/server pairs in a fixed amount of memory,
+for when there are too many pairs to keep them all in a WWFStore (e.g. a scan of every server in the estate)
+
+The servers, owners and pairs with the most files are kept in HeavyHitters, and every one is counted in a CountMinSketch too,
+so the number of files of a kept one is known to be in a range:
+at least its heavy hitter count less that count's error, and at most the smaller of the count and the sketch's estimate
+When everything fits in the memory, the ranges are the exact counts
+
+The number of distinct owners on each kept server, and of servers and owners overall, are estimated with HyperLogLogs
+
+*/
+
+#ifndef _APPROXIMATESUMMARY_H_
+#define _APPROXIMATESUMMARY_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "WWFStore.h"
+#include "HeavyHitters.h"
+#include "CountMinSketch.h"
+#include "HyperLogLog.h"
+using std::string;
+using std::string_view;
+using std::vector;
+
+
+//the estimated number of files of a server, owner, or owner on a server
+struct estimated_count{
+	string name; //the name of the server or owner
+	unsigned long long low; //the true count is at least low
+	unsigned long long high; //and at most high
+	double owners; //the estimated number of distinct owners, for a server (0 otherwise)
+};
+
+//used to sort estimated counts, like occurrences
+//ordered by high, then by name
+//more_estimated()(count1, count2) is true iff count1 comes before count2 when sorting descending
+struct more_estimated{
+	bool operator()(const estimated_count& count1, const estimated_count& count2) const;
+};
+
+
+class ApproximateSummary{
+
+	size_t memory_budget; //about the most bytes to use
+	unsigned long long files; //the total number of WWFs, which is exact
+
+	HeavyHitters servers, owners, pairs, critical;
+	CountMinSketch server_sketch, owner_sketch, pair_sketch;
+
+	//the names of the kept keys, by slot
+	vector<string> server_names, owner_names, critical_names;
+	vector<string> pair_servers, pair_owners;
+
+	vector<HyperLogLog> server_owners; //the distinct owners on each kept server, by slot
+	HyperLogLog all_servers, all_owners;
+
+	estimated_count estimate(const HeavyHitters& counts, const CountMinSketch* sketch, size_t slot, const string& name) const;
+
+	//an approximate summary can't be copied
+	ApproximateSummary(const ApproximateSummary&);
+	ApproximateSummary& operator=(const ApproximateSummary&);
+
+public:
+	//the memory is split among the sketches, so that all of them together take about memory_budget bytes
+	ApproximateSummary(size_t memory_budget);
+
+	//add the pairs of the store (e.g. the results of a report)
+	void add(const WWFStore& store);
+
+	bool empty() const; //returns true iff no WWFs have been added
+
+	size_t memory() const; //the memory budget
+	unsigned long long total_files() const;
+	double distinct_servers() const;
+	double distinct_owners() const;
+	double owners_error() const; //the standard error of the number of distinct owners on a server, as a fraction of it
+
+	//the (at most limit) servers with the most files, sorted by more_estimated,
+	//and for each of them, the (at most owners_limit) owners with the most files on it
+	void top_servers(size_t limit, size_t owners_limit, vector<estimated_count>& top, vector<vector<estimated_count> >& top_owners) const;
+
+	//the (at most limit) owners with the most files, sorted by more_estimated,
+	//and for each of them, the (at most servers_limit) servers with the most of their files
+	void top_owners(size_t limit, size_t servers_limit, vector<estimated_count>& top, vector<vector<estimated_count> >& top_servers) const;
+
+	//the servers with critical files, sorted by more_estimated
+	vector<estimated_count> critical_servers() const;
+};
+
+
+#endif
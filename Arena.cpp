@@ -0,0 +1,84 @@
+//Arena.cpp
+//Implementation of Arena class
+
+#include "Arena.h"
+
+#include <cstring>
+#include <utility>
+
+
+Arena::Arena(size_t block_size) : block_size(block_size){
+	position = NULL;
+	available = 0;
+	used = 0;
+	reserved = 0;
+}
+
+Arena::~Arena(){
+	reset();
+}
+
+//copy str into the arena
+string_view Arena::store(string_view str){
+
+	if(str.empty()) return string_view();
+
+	//if the string doesn't fit in the current block, start a new one
+	if(str.size() > available){
+
+		//a string longer than a normal block gets a block of its own, so the current block can still be filled
+		if(str.size() > block_size / 4){
+			char* block = new char[str.size()];
+			blocks.push_back(block);
+			memcpy(block, str.data(), str.size());
+			used += str.size();
+			reserved += str.size();
+			return string_view(block, str.size());
+		}
+
+		position = new char[block_size];
+		available = block_size;
+		reserved += block_size;
+		blocks.push_back(position);
+	}
+
+	char* copy = position;
+	memcpy(copy, str.data(), str.size());
+
+	position += str.size();
+	available -= str.size();
+	used += str.size();
+
+	return string_view(copy, str.size());
+}
+
+//free every string stored
+void Arena::reset(){
+
+	for(vector<char*>::iterator i = blocks.begin(); i != blocks.end(); i++){
+		delete[] *i;
+	}
+
+	blocks.clear();
+	position = NULL;
+	available = 0;
+	used = 0;
+	reserved = 0;
+}
+
+void Arena::swap(Arena& other){
+	blocks.swap(other.blocks);
+	std::swap(block_size, other.block_size);
+	std::swap(position, other.position);
+	std::swap(available, other.available);
+	std::swap(used, other.used);
+	std::swap(reserved, other.reserved);
+}
+
+size_t Arena::bytes_used() const{
+	return used;
+}
+
+size_t Arena::bytes_reserved() const{
+	return reserved;
+}
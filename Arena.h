@@ -0,0 +1,50 @@
+/*
+
+Arena.h
+
+Arena is a class which stores strings in large blocks of memory
+
+Copying a string into the arena is usually just a copy into the current block,
+and all of the strings are freed at once when the arena is reset or destroyed
+
+*/
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <string_view>
+#include <vector>
+using std::string_view;
+using std::vector;
+
+
+class Arena{
+
+	vector<char*> blocks;
+	size_t block_size; //the size of a normal block, longer strings get blocks of their own
+	char* position; //the next free byte in the current block
+	size_t available; //the number of free bytes in the current block
+	size_t used; //the number of bytes stored
+	size_t reserved; //the number of bytes in the blocks
+
+	//an arena can't be copied, since the views into it would be to the original's blocks
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+
+public:
+	Arena(size_t block_size = 64 * 1024);
+	~Arena();
+
+	//copy str into the arena
+	//the returned view is valid until the arena is reset or destroyed
+	string_view store(string_view str);
+
+	void reset(); //free every string stored
+	void swap(Arena& other);
+
+	size_t bytes_used() const; //the number of bytes stored
+	size_t bytes_reserved() const; //the number of bytes in the blocks
+};
+
+
+#endif
@@ -0,0 +1,139 @@
+/*
+
+BoundedHeap.h
+
+BoundedHeap is a class template which keeps the best items pushed to it, up to a limit
+
+Better(a, b) is true iff a comes before b (e.g. greater<occurrences> to keep the largest)
+Only limit items are ever stored, so finding the top items doesn't require sorting all of them
+
+*/
+
+#ifndef _BOUNDEDHEAP_H_
+#define _BOUNDEDHEAP_H_
+
+#include <vector>
+#include <algorithm>
+using std::vector;
+
+
+template <class T, class Better>
+class BoundedHeap{
+
+	vector<T> heap; //the kept items, with the worst of them at the front
+	size_t limit; //the max number of items to keep
+	unsigned long long pushed; //the number of items pushed, including those which were not kept
+	Better better;
+	bool in_order; //true iff the kept items are sorted worst first (which is still a heap)
+
+public:
+	BoundedHeap(size_t limit, Better better = Better()) : limit(limit), pushed(0), better(better), in_order(true) {}
+
+	//returns true iff the item would be kept if it was pushed now
+	bool would_keep(const T& item) const{
+		return (heap.size() < limit) || ((limit > 0) && better(item, heap.front()));
+	}
+
+	//keep the item if it's one of the best limit items pushed so far
+	void push(const T& item){
+
+		pushed++;
+
+		if(heap.size() < limit){
+			heap.push_back(item);
+			std::push_heap(heap.begin(), heap.end(), better);
+			in_order = false;
+		}
+		else if((limit > 0) && better(item, heap.front())){
+			//replace the worst item
+			std::pop_heap(heap.begin(), heap.end(), better);
+			heap.back() = item;
+			std::push_heap(heap.begin(), heap.end(), better);
+			in_order = false;
+		}
+	}
+
+	//sort the kept items worst first, so that they can be read in order with items() without sorting a copy
+	//items can still be pushed afterwards, since a sorted vector is still a heap
+	void sort(){
+		if(in_order) return;
+
+		std::sort_heap(heap.begin(), heap.end(), better);
+		std::reverse(heap.begin(), heap.end());
+		in_order = true;
+	}
+
+	//returns true iff the kept items are sorted worst first
+	bool sorted_in_place() const{
+		return in_order;
+	}
+
+	//the kept items, in heap order (or worst first after sort())
+	const vector<T>& items() const{
+		return heap;
+	}
+
+	size_t size() const{
+		return heap.size();
+	}
+
+	//returns true iff limit items are kept, so a new item is only kept if it's better than the worst
+	bool full() const{
+		return (heap.size() >= limit);
+	}
+
+	//the worst of the kept items (there must be at least one)
+	const T& worst() const{
+		return heap.front();
+	}
+
+	//the number of items pushed, including those which were not kept
+	unsigned long long count() const{
+		return pushed;
+	}
+
+	//apply f to each of the kept items, f must not change how they're ordered
+	template <class F>
+	void for_each(F f){
+		for(typename vector<T>::iterator i = heap.begin(); i != heap.end(); i++){
+			f(*i);
+		}
+	}
+
+	//remove the kept items for which f is true, the others stay in the same order (so they stay sorted after sort())
+	template <class F>
+	void remove_if(F f){
+		typename vector<T>::iterator last = std::remove_if(heap.begin(), heap.end(), f);
+		if(last == heap.end()) return;
+
+		heap.erase(last, heap.end());
+		if(!in_order) std::make_heap(heap.begin(), heap.end(), better);
+	}
+
+	//change the max number of items to keep, dropping the worst of them if more are kept
+	void set_limit(size_t new_limit){
+		limit = new_limit;
+		if(heap.size() <= limit) return;
+
+		sort();
+		heap.erase(heap.begin(), heap.begin() + (heap.size() - limit));
+	}
+
+	//remove the kept items and free their memory, the count of items pushed is kept
+	void clear(){
+		vector<T>().swap(heap);
+		in_order = true;
+	}
+
+	//the kept items, best first
+	vector<T> sorted() const{
+		if(in_order) return vector<T>(heap.rbegin(), heap.rend());
+
+		vector<T> items = heap;
+		std::sort_heap(items.begin(), items.end(), better);
+		return items;
+	}
+};
+
+
+#endif
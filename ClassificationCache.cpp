@@ -0,0 +1,145 @@
+//ClassificationCache.cpp
+//Implementation of ClassificationCache class
+
+#include "ClassificationCache.h"
+
+#include <algorithm>
+
+
+const size_t MAX_TRIE_NODES = 1 << 16; //the trie is cleared when it has this many directories, to bound its memory
+
+
+ClassificationCache::ClassificationCache(const FileClassifier& classifier) : classifier(classifier), dfa(classifier.automaton()){
+	lookups = hits = decided = 0;
+	clear();
+}
+
+//empty the trie, leaving only the root
+void ClassificationCache::clear(){
+
+	nodes.clear();
+	nodes.push_back(trie_node());
+	nodes[0].state = 0;
+
+	components.reset();
+
+	last_directory.clear();
+	path_ends.assign(1, 0);
+	path_nodes.assign(1, 0);
+}
+
+//find (or add) the node for the directory, which ends with a '/' or is empty, and return its state
+unsigned ClassificationCache::directory_state(string_view directory){
+
+	//most files are in the same directory as the last one
+	if(directory == last_directory){
+		hits++;
+		return nodes[path_nodes.back()].state;
+	}
+
+	//if the directories might not fit in the trie, start again with an empty one
+	//(the path's length bounds its depth, so the '/'s are only counted when the trie is nearly full,
+	//and a directory which could never fit is read without the trie)
+	if(nodes.size() + directory.size() > MAX_TRIE_NODES){
+		const size_t depth = std::count(directory.begin(), directory.end(), '/');
+
+		if(nodes.size() + depth > MAX_TRIE_NODES) clear();
+
+		if(depth >= MAX_TRIE_NODES){
+			unsigned state = 0;
+			for(string_view::iterator c = directory.begin(); c != directory.end(); c++){
+				state = dfa.transitions[state * dfa.num_classes + dfa.byte_class[(unsigned char)*c]];
+			}
+			return state;
+		}
+	}
+
+	//otherwise start from the deepest directory which the path shares with the last one
+	size_t common = 0;
+	const size_t shorter = (directory.size() < last_directory.size()) ? directory.size() : last_directory.size();
+	while((common < shorter) && (directory[common] == last_directory[common])) common++;
+
+	while(path_ends.back() > common){
+		path_ends.pop_back();
+		path_nodes.pop_back();
+	}
+
+	//follow the rest of the path, adding the directories which aren't in the trie yet
+	bool found = true;
+	size_t start = path_ends.back();
+	unsigned node = path_nodes.back();
+
+	while(start < directory.size()){
+
+		const size_t end = directory.find('/', start) + 1;
+		const string_view component = directory.substr(start, end - start);
+
+		unordered_map<string_view, unsigned>::iterator child = nodes[node].children.find(component);
+		if(child != nodes[node].children.end()){
+			node = child->second;
+		}
+		else{
+			found = false;
+
+			unsigned state = nodes[node].state;
+			for(string_view::iterator c = component.begin(); c != component.end(); c++){
+				state = dfa.transitions[state * dfa.num_classes + dfa.byte_class[(unsigned char)*c]];
+			}
+
+			trie_node new_node;
+			new_node.state = state;
+			nodes.push_back(new_node);
+
+			nodes[node].children[components.store(component)] = nodes.size() - 1;
+			node = nodes.size() - 1;
+		}
+
+		path_ends.push_back(end);
+		path_nodes.push_back(node);
+		start = end;
+	}
+
+	last_directory.assign(directory.data(), directory.size());
+
+	if(found) hits++;
+	return nodes[node].state;
+}
+
+//returns true iff the rules make the file have the classification
+bool ClassificationCache::satisfies(string_view file_name){
+
+	lookups++;
+
+	//start from the state after the file's directory
+	const size_t directory_end = file_name.rfind('/') + 1; //0 if there's no directory
+	unsigned state = directory_state(file_name.substr(0, directory_end));
+
+	//a rule may already have matched, or none may be able to
+	//(the rules which couldn't be combined into the automaton are only checked when it doesn't match)
+	if(dfa.matches[state] || dfa.dead[state]){
+		decided++;
+		return dfa.matches[state] || classifier.satisfies_uncombined(file_name);
+	}
+
+	//then read the file name like FileClassifier::satisfies()
+	const string_view name = file_name.substr(directory_end);
+	for(string_view::iterator c = name.begin(); c != name.end(); c++){
+		state = dfa.transitions[state * dfa.num_classes + dfa.byte_class[(unsigned char)*c]];
+
+		if(dfa.matches[state]) return true;
+	}
+
+	return dfa.matches_at_end[state] || classifier.satisfies_uncombined(file_name);
+}
+
+unsigned long long ClassificationCache::lookup_count() const{
+	return lookups;
+}
+
+unsigned long long ClassificationCache::hit_count() const{
+	return hits;
+}
+
+unsigned long long ClassificationCache::decided_count() const{
+	return decided;
+}
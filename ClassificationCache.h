@@ -0,0 +1,77 @@
+/*
+
+ClassificationCache.h
+
+ClassificationCache is a class which classifies files like FileClassifier::satisfies(),
+remembering what the rules have read for each directory, so that a directory's path is only read once
+
+The files in a report are clustered, e.g. thousands of files under the same /tmp/build/... directory,
+and the rules' automaton is in the same state after reading a directory whichever file in it is being checked
+The state after each directory is kept in a trie of the path components,
+so only the file name (and any directories not seen before) is read for each file,
+and if the state after a directory already decides the classification, not even that
+
+A cache is used by one thread, e.g. each report being analyzed has its own
+
+*/
+
+#ifndef _CLASSIFICATIONCACHE_H_
+#define _CLASSIFICATIONCACHE_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include "FileClassifier.h"
+#include "Arena.h"
+using std::string;
+using std::string_view;
+using std::vector;
+using std::unordered_map;
+
+
+class ClassificationCache{
+
+	const FileClassifier& classifier;
+	const rule_dfa& dfa;
+
+	//a directory, the components of its path are the edges from the root
+	struct trie_node{
+		unsigned state; //the state of the automaton after reading the path up to and including the directory's '/'
+		unordered_map<string_view, unsigned> children; //component (with its '/') -> index of the child node
+	};
+
+	vector<trie_node> nodes; //nodes[0] is the root, for the empty path
+	Arena components; //the text of the components in the trie
+
+	//the directory of the last file, and the nodes along its path
+	//(path_nodes[i] is the node for the directory ending at path_ends[i])
+	string last_directory;
+	vector<size_t> path_ends;
+	vector<unsigned> path_nodes;
+
+	unsigned long long lookups; //the number of files classified
+	unsigned long long hits; //files whose directory's state was found in the cache
+	unsigned long long decided; //files whose classification was decided by their directory alone
+
+	unsigned directory_state(string_view directory);
+	void clear();
+
+	//a cache can't be copied, since the trie's keys are views into its arena
+	ClassificationCache(const ClassificationCache&);
+	ClassificationCache& operator=(const ClassificationCache&);
+
+public:
+	//the classifier must not change or be compiled again while the cache is used
+	ClassificationCache(const FileClassifier& classifier);
+
+	//returns true iff the rules make the file have the classification, the same as classifier.satisfies()
+	bool satisfies(string_view file_name);
+
+	unsigned long long lookup_count() const;
+	unsigned long long hit_count() const;
+	unsigned long long decided_count() const;
+};
+
+
+#endif
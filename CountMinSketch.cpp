@@ -0,0 +1,46 @@
+//CountMinSketch.cpp
+//Implementation of CountMinSketch class
+
+#include "CountMinSketch.h"
+#include "Hash.h"
+
+#include <cmath>
+
+
+CountMinSketch::CountMinSketch(size_t width, unsigned depth) : width(width > 0 ? width : 1), depth(depth > 0 ? depth : 1), total_count(0){
+	counters.assign(this->width * this->depth, 0);
+}
+
+void CountMinSketch::add(unsigned long long key, unsigned long long count){
+
+	//each row has its own hash of the key, so keys which share a counter in one row rarely do in the others
+	for(unsigned row = 0; row < depth; row++){
+		counters[row * width + hash_combine(key, row) % width] += count;
+	}
+
+	total_count += count;
+}
+
+unsigned long long CountMinSketch::estimate(unsigned long long key) const{
+
+	unsigned long long smallest = counters[hash_combine(key, 0) % width];
+
+	for(unsigned row = 1; row < depth; row++){
+		const unsigned long long counter = counters[row * width + hash_combine(key, row) % width];
+		if(counter < smallest) smallest = counter;
+	}
+
+	return smallest;
+}
+
+unsigned long long CountMinSketch::total() const{
+	return total_count;
+}
+
+double CountMinSketch::error_fraction() const{
+	return std::exp(1.0) / width;
+}
+
+double CountMinSketch::confidence() const{
+	return 1.0 - std::exp(-(double)depth);
+}
@@ -0,0 +1,47 @@
+/*
+
+CountMinSketch.h
+
+CountMinSketch is a class which estimates the count of every key added to it in a fixed amount of memory
+
+Each key is counted in one counter of each row, chosen by hashing, and the estimate is the smallest of those counters,
+so an estimate is never less than the true count, and other keys sharing the counters only make it larger
+With width w and depth d, an estimate is at most e/w of the total of every count larger than the true count,
+with probability 1 - e^-d
+
+*/
+
+#ifndef _COUNTMINSKETCH_H_
+#define _COUNTMINSKETCH_H_
+
+#include <cstddef>
+#include <vector>
+using std::vector;
+
+
+class CountMinSketch{
+
+	size_t width; //the number of counters in each row
+	unsigned depth; //the number of rows
+	vector<unsigned long long> counters; //the rows, one after another
+	unsigned long long total_count; //the total of every count added
+
+public:
+	CountMinSketch(size_t width, unsigned depth);
+
+	//add count to the key (a hash of what is counted)
+	void add(unsigned long long key, unsigned long long count);
+
+	//estimate the total count of the key, which is never less than the true total
+	unsigned long long estimate(unsigned long long key) const;
+
+	//the total of every count added
+	unsigned long long total() const;
+
+	//an estimate is at most error_fraction() * total() more than the true count, with probability confidence()
+	double error_fraction() const;
+	double confidence() const;
+};
+
+
+#endif
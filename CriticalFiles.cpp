@@ -0,0 +1,389 @@
+//CriticalFiles.cpp
+//Implementation of CriticalFiles class
+
+#include "CriticalFiles.h"
+#include "Serialization.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <atomic>
+#include <chrono>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+using std::ifstream;
+using std::ofstream;
+using std::ios;
+using std::unique_ptr;
+using std::priority_queue;
+using std::atomic;
+using std::to_string;
+
+const size_t MERGE_FAN_IN = 16; //the number of runs of a level which are merged into a run of the next level
+
+static atomic<unsigned long> next_run_number(0); //used to give every run file of the process its own name
+
+
+//reads the pairs of a run file back in order
+class run_reader{
+
+	ifstream file;
+
+	//read a string written with write_string()
+	bool read_string(string& str){
+		char length_bytes[8];
+		if(!file.read(length_bytes, 8)) return false;
+
+		Deserializer length(string_view(length_bytes, 8));
+		str.resize(length.read_number());
+		return (bool)file.read(&str[0], str.size());
+	}
+
+public:
+	string owner, file_name; //the current pair
+
+	run_reader(const string& run_file) : file(run_file.c_str(), ios::binary) {}
+
+	//move to the next pair, returns false at the end of the run
+	bool next(){
+		return read_string(owner) && read_string(file_name);
+	}
+};
+
+//the source of the next pair in a k-way merge, the in-memory pairs are source readers.size()
+struct merge_source{
+	critical_file_owner pair;
+	size_t source;
+};
+
+//used to make a priority_queue with the smallest pair on top
+struct later_pair{
+	bool operator()(const merge_source& a, const merge_source& b) const{
+		return b.pair < a.pair;
+	}
+};
+
+//merge the sorted sources (the runs and the pairs in memory from first to last), calling visit for the first limit pairs
+template <class Iterator>
+static void merge_sorted(vector<unique_ptr<run_reader> >& readers, Iterator first, Iterator last,
+	unsigned long long limit, const function<void(string_view owner, string_view file)>& visit){
+
+	priority_queue<merge_source, vector<merge_source>, later_pair> next;
+
+	for(size_t i = 0; i < readers.size(); i++){
+		if(readers[i]->next()){
+			merge_source source = {{readers[i]->owner, readers[i]->file_name}, i};
+			next.push(source);
+		}
+	}
+
+	if(first != last){
+		merge_source source = {*first++, readers.size()};
+		next.push(source);
+	}
+
+	for(unsigned long long visited = 0; (visited < limit) && !next.empty(); visited++){
+
+		const merge_source smallest = next.top();
+		next.pop();
+
+		visit(smallest.pair.owner, smallest.pair.file);
+
+		//the views of a reader's pair are only valid until it reads the next one
+		if(smallest.source < readers.size()){
+			run_reader& reader = *readers[smallest.source];
+			if(reader.next()){
+				merge_source source = {{reader.owner, reader.file_name}, smallest.source};
+				next.push(source);
+			}
+		}
+		else if(first != last){
+			merge_source source = {*first++, readers.size()};
+			next.push(source);
+		}
+	}
+}
+
+
+CriticalFiles::CriticalFiles(unsigned long max_files, size_t memory_budget, const string& spill_directory)
+	: kept(max_files), max_files(max_files), memory_budget(memory_budget), spill_directory(spill_directory){
+	total = 0;
+	kept_bytes = 0;
+}
+
+CriticalFiles::~CriticalFiles(){
+	for(vector<spill_run>::iterator i = runs.begin(); i != runs.end(); i++){
+		remove(i->file_name.c_str());
+	}
+}
+
+//add a critical file, the file name is only copied if it is kept
+void CriticalFiles::add(string_view owner, string_view file){
+
+	total++;
+
+	//if we already have enough files, the new one is only kept if it comes before the last of them
+	//(ordered by owner name, then by file name, like operator<)
+	if(kept.full()){
+		if(kept.size() == 0) return;
+
+		const critical_file_owner& last = kept.worst();
+		const int owner_order = owner.compare(last.owner);
+
+		if((owner_order > 0) || ((owner_order == 0) && (file.compare(last.file) >= 0))) return;
+
+		//the last file will be replaced
+		kept_bytes -= last.file.size();
+	}
+
+	critical_file_owner new_critical_file;
+
+	new_critical_file.owner = owner;
+	new_critical_file.file = file_names.store(file);
+
+	kept.push(new_critical_file);
+	kept_bytes += file.size();
+
+	//if the kept pairs take more than the budget, write them to a run and start again with an empty heap
+	if(kept_bytes + kept.size() * sizeof(critical_file_owner) > memory_budget){
+		spill();
+	}
+	//the names of replaced files are still in the arena,
+	//so if they take up most of it, we copy the kept names into a new one
+	else if(file_names.bytes_used() > 2 * kept_bytes + 1024 * 1024){
+		compact();
+	}
+}
+
+//copy the file names of the kept pairs into a new arena and free the old one
+void CriticalFiles::compact(){
+
+	Arena compacted;
+
+	kept.for_each([&compacted](critical_file_owner& critical_file){
+		critical_file.file = compacted.store(critical_file.file);
+	});
+
+	file_names.swap(compacted);
+}
+
+//write the kept pairs to a new run file and free them
+//once there are MERGE_FAN_IN runs of a level, they are merged into one run of the next level,
+//so only a few runs are ever open at once when they're read back
+void CriticalFiles::spill(){
+
+	spill_run run;
+	run.file_name = run_file_name();
+	run.level = 0;
+	run.pairs = kept.size();
+
+	{
+		ofstream file (run.file_name.c_str(), ios::binary | ios::trunc);
+
+		string bytes;
+		kept.sort();
+		const vector<critical_file_owner>& worst_first = kept.items();
+		for(vector<critical_file_owner>::const_reverse_iterator i = worst_first.rbegin(); i != worst_first.rend(); i++){
+			write_string(bytes, i->owner);
+			write_string(bytes, i->file);
+
+			if(bytes.size() >= 1024 * 1024){
+				file.write(bytes.data(), bytes.size());
+				bytes.clear();
+			}
+		}
+		file.write(bytes.data(), bytes.size());
+
+		//if the run can't be written, the pairs stay in memory from now on
+		if(!file.good()){
+			file.close();
+			remove(run.file_name.c_str());
+			memory_budget = std::numeric_limits<size_t>::max();
+			return;
+		}
+	}
+
+	runs.push_back(run);
+
+	kept.clear();
+	file_names.reset();
+	kept_bytes = 0;
+
+	while((runs.size() >= MERGE_FAN_IN) && (runs[runs.size() - MERGE_FAN_IN].level == runs.back().level)){
+
+		spill_run merged;
+		if(!merge_runs(runs.size() - MERGE_FAN_IN, merged)) break;
+
+		for(size_t i = runs.size() - MERGE_FAN_IN; i < runs.size(); i++){
+			remove(runs[i].file_name.c_str());
+		}
+		runs.resize(runs.size() - MERGE_FAN_IN);
+		runs.push_back(merged);
+	}
+}
+
+//merge the runs from first to the end into a new run, keeping the first max_files pairs
+//returns false if the new run could not be written
+bool CriticalFiles::merge_runs(size_t first, spill_run& merged){
+
+	merged.file_name = run_file_name();
+	merged.level = runs[first].level + 1;
+	merged.pairs = 0;
+
+	vector<unique_ptr<run_reader> > readers;
+	for(size_t i = first; i < runs.size(); i++){
+		readers.push_back(unique_ptr<run_reader>(new run_reader(runs[i].file_name)));
+	}
+
+	ofstream file (merged.file_name.c_str(), ios::binary | ios::trunc);
+	string bytes;
+
+	const vector<critical_file_owner> none;
+	merge_sorted(readers, none.begin(), none.end(), max_files, [&](string_view owner, string_view file_name){
+		write_string(bytes, owner);
+		write_string(bytes, file_name);
+		merged.pairs++;
+
+		if(bytes.size() >= 1024 * 1024){
+			file.write(bytes.data(), bytes.size());
+			bytes.clear();
+		}
+	});
+	file.write(bytes.data(), bytes.size());
+
+	if(!file.good()){
+		file.close();
+		remove(merged.file_name.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+//the name of a new run file, e.g. ".WWF Analyzer Spill 1234-0.tmp" for the first run of process 1234
+string CriticalFiles::run_file_name(){
+#ifdef _WIN32
+	const unsigned long process = _getpid();
+#else
+	const unsigned long process = getpid();
+#endif
+	return spill_directory + SPILL_FILE_PREFIX + to_string(process) + "-" + to_string(next_run_number++) + ".tmp";
+}
+
+//take the matching pairs out of the heap, and out of each run by copying the rest of it to a new run
+void CriticalFiles::remove_files(const function<bool(string_view owner, string_view file)>& matches, unsigned long long files){
+
+	total -= files;
+
+	size_t& bytes_kept = kept_bytes;
+	kept.remove_if([&matches, &bytes_kept](const critical_file_owner& critical_file){
+		if(!matches(critical_file.owner, critical_file.file)) return false;
+
+		bytes_kept -= critical_file.file.size();
+		return true;
+	});
+
+	for(vector<spill_run>::iterator i = runs.begin(); i != runs.end(); i++){
+
+		spill_run filtered;
+		filtered.file_name = run_file_name();
+		filtered.level = i->level;
+		filtered.pairs = 0;
+
+		run_reader reader(i->file_name);
+		ofstream file (filtered.file_name.c_str(), ios::binary | ios::trunc);
+		string bytes;
+
+		while(reader.next()){
+			if(matches(reader.owner, reader.file_name)) continue;
+
+			write_string(bytes, reader.owner);
+			write_string(bytes, reader.file_name);
+			filtered.pairs++;
+
+			if(bytes.size() >= 1024 * 1024){
+				file.write(bytes.data(), bytes.size());
+				bytes.clear();
+			}
+		}
+		file.write(bytes.data(), bytes.size());
+
+		//if the new run can't be written (or nothing was taken out), the run is left as it was
+		if(!file.good() || (filtered.pairs == i->pairs)){
+			file.close();
+			remove(filtered.file_name.c_str());
+			continue;
+		}
+
+		remove(i->file_name.c_str());
+		*i = filtered;
+	}
+}
+
+//drop the pairs in memory past the new max, the runs are only read up to it
+void CriticalFiles::limit(unsigned long max_files){
+
+	this->max_files = max_files;
+	kept.set_limit(max_files);
+
+	kept_bytes = 0;
+	for(vector<critical_file_owner>::const_iterator i = kept.items().begin(); i != kept.items().end(); i++){
+		kept_bytes += i->file.size();
+	}
+
+	if(file_names.bytes_used() > 2 * kept_bytes + 1024 * 1024){
+		compact();
+	}
+}
+
+void CriticalFiles::add_count(unsigned long long files){
+	total += files;
+}
+
+unsigned long long CriticalFiles::count() const{
+	return total;
+}
+
+unsigned long long CriticalFiles::kept_count() const{
+
+	unsigned long long pairs = kept.size();
+	for(vector<spill_run>::const_iterator i = runs.begin(); i != runs.end(); i++){
+		pairs += i->pairs;
+	}
+
+	return (pairs < max_files) ? pairs : max_files;
+}
+
+bool CriticalFiles::omitted() const{
+	return (total > kept_count());
+}
+
+bool CriticalFiles::spilled() const{
+	return !runs.empty();
+}
+
+//call visit(owner, file) for each of the kept owner/file pairs, merging the runs with the pairs in memory
+void CriticalFiles::for_each_sorted(const function<void(string_view owner, string_view file)>& visit) const{
+
+	vector<unique_ptr<run_reader> > readers;
+	for(vector<spill_run>::const_iterator i = runs.begin(); i != runs.end(); i++){
+		readers.push_back(unique_ptr<run_reader>(new run_reader(i->file_name)));
+	}
+
+	//the pairs in memory are read from the back if they've been sorted worst first, or else from a sorted copy
+	if(kept.sorted_in_place()){
+		merge_sorted(readers, kept.items().rbegin(), kept.items().rend(), max_files, visit);
+	}
+	else{
+		const vector<critical_file_owner> sorted = kept.sorted();
+		merge_sorted(readers, sorted.begin(), sorted.end(), max_files, visit);
+	}
+}
+
+void CriticalFiles::sort(){
+	kept.sort();
+}
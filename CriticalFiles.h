@@ -0,0 +1,108 @@
+/*
+
+CriticalFiles.h
+
+CriticalFiles is a class which collects the critical files found in a report
+
+Only the first max_files owner/file pairs (in sorted order) are kept, since those are the only ones displayed,
+but every critical file is counted so that we know if some have been omitted
+
+The file names of the kept pairs are stored in an arena, which is freed at once when the CriticalFiles is destroyed
+
+If the kept pairs would take more than the memory budget, they are sorted and spilled to a run file,
+and the runs are merged while the pairs are read back with for_each_sorted(),
+so the memory used stays the same however many critical files there are
+The run files are named with SPILL_FILE_PREFIX and the id of the process, so two runs in the same directory don't share them,
+and they start with a '.' so they're hidden, and are never taken for reports
+
+*/
+
+#ifndef _CRITICALFILES_H_
+#define _CRITICALFILES_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <limits>
+#include "data structs.h"
+#include "BoundedHeap.h"
+#include "Arena.h"
+using std::string;
+using std::string_view;
+using std::vector;
+using std::less;
+using std::function;
+
+
+const string SPILL_FILE_PREFIX = ".WWF Analyzer Spill "; //the start of the names of the run files
+
+
+class CriticalFiles{
+
+	BoundedHeap<critical_file_owner, less<critical_file_owner> > kept; //the smallest owner/file pairs which are in memory
+	unsigned long max_files; //the max number of pairs to keep
+	unsigned long long total; //the number of critical files added
+
+	Arena file_names; //the file names of the kept pairs (and of pairs which have since been replaced)
+	size_t kept_bytes; //the number of bytes of file names of the kept pairs
+
+	//a file of pairs which were spilled from memory, sorted
+	//a run made by merging runs has a level one more than theirs
+	struct spill_run{
+		string file_name;
+		unsigned level;
+		unsigned long long pairs;
+	};
+
+	size_t memory_budget; //the most bytes the kept pairs may take before they are spilled
+	string spill_directory; //where the run files are made
+	vector<spill_run> runs; //in the order they were made, so the levels never increase
+
+	void compact();
+	void spill();
+	bool merge_runs(size_t first, spill_run& merged);
+	string run_file_name();
+
+	//critical files can't be copied, since the run files would be removed twice
+	CriticalFiles(const CriticalFiles&);
+	CriticalFiles& operator=(const CriticalFiles&);
+
+public:
+	//pairs are only spilled if a memory budget (in bytes) is given, into run files in the spill directory
+	CriticalFiles(unsigned long max_files, size_t memory_budget = std::numeric_limits<size_t>::max(), const string& spill_directory = "");
+	~CriticalFiles(); //removes the run files
+
+	//add a critical file, the file name is only copied if it is kept
+	//the owner must be a name which stays valid for the life of the CriticalFiles (e.g. interned in a WWFStore)
+	void add(string_view owner, string_view file);
+
+	//count critical files without collecting them
+	//used when the kept files are added from elsewhere (e.g. the cache) and the rest are known to have been omitted
+	void add_count(unsigned long long files);
+
+	//take the kept pairs for which matches(owner, file) is true out, and files out of the count of critical files
+	//(files includes those which matched but weren't kept, e.g. when more than the max number were found)
+	void remove_files(const function<bool(string_view owner, string_view file)>& matches, unsigned long long files);
+
+	//keep only the first max_files pairs from now on
+	//e.g. when duplicates are collapsed, every pair is kept until the duplicates have been taken out,
+	//so that the pairs which would have been dropped for them aren't lost
+	void limit(unsigned long max_files);
+
+	unsigned long long count() const; //the number of critical files added
+	unsigned long long kept_count() const; //the number of pairs for_each_sorted() visits
+	bool omitted() const; //returns true iff some critical files were not kept
+	bool spilled() const; //returns true iff some of the kept pairs have been spilled to disk
+
+	//sort the kept pairs once all of the critical files have been added,
+	//so that each for_each_sorted() reads them in place instead of sorting a copy of them
+	void sort();
+
+	//call visit(owner, file) for each of the kept owner/file pairs, sorted by owner name then by file name
+	//the views are only valid during the call
+	void for_each_sorted(const function<void(string_view owner, string_view file)>& visit) const;
+};
+
+
+#endif
@@ -0,0 +1,268 @@
+//DirectoryIndex.cpp
+//Implementation of DirectoryIndex class
+
+#include "DirectoryIndex.h"
+#include "BoundedHeap.h"
+
+
+bool more_files::operator()(const directory_count& count1, const directory_count& count2) const{
+	if(count1.files != count2.files){
+		return (count1.files > count2.files);
+	}
+	else if(count1.server != count2.server){
+		return (count1.server < count2.server);
+	}
+	else{
+		return (count1.directory < count2.directory);
+	}
+}
+
+
+DirectoryIndex::DirectoryIndex(){
+	node root;
+	root.label = 0;
+	root.length = 0;
+	root.first_child = root.next_sibling = 0;
+	root.files = 0;
+	nodes.push_back(root);
+
+	last_node = 0;
+}
+
+//count files in the directory
+void DirectoryIndex::add(string_view directory, unsigned long long files){
+
+	//most files are in the same directory as the last one
+	if(directory == last_directory){
+		nodes[last_node].files += files;
+		return;
+	}
+
+	unsigned current = 0;
+	size_t position = 0; //the length of the path to current
+
+	while(position < directory.size()){
+
+		//find the child whose label starts with the next character, there's at most one
+		unsigned child = nodes[current].first_child;
+		unsigned previous = 0;
+		while((child != 0) && (labels[nodes[child].label] != directory[position])){
+			previous = child;
+			child = nodes[child].next_sibling;
+		}
+
+		//if there's none, the rest of the directory is a new child
+		if(child == 0){
+			node new_node;
+			new_node.label = labels.size();
+			new_node.length = directory.size() - position;
+			new_node.first_child = 0;
+			new_node.next_sibling = nodes[current].first_child;
+			new_node.files = 0;
+
+			labels.append(directory.substr(position));
+			nodes.push_back(new_node);
+
+			nodes[current].first_child = nodes.size() - 1;
+			current = nodes.size() - 1;
+			position = directory.size();
+			break;
+		}
+
+		//move the child to the front of its siblings, since the next directories are probably under it too
+		if(previous != 0){
+			nodes[previous].next_sibling = nodes[child].next_sibling;
+			nodes[child].next_sibling = nodes[current].first_child;
+			nodes[current].first_child = child;
+		}
+
+		//follow as much of the label as the directory matches
+		size_t matched = 1;
+		while((matched < nodes[child].length) && (position + matched < directory.size())
+			&& (labels[nodes[child].label + matched] == directory[position + matched])){
+			matched++;
+		}
+
+		//if the directory leaves the label part of the way along, split the child there
+		//the child keeps the start of the label, and a new node below it takes the rest (and the child's children and files)
+		if(matched < nodes[child].length){
+			node lower;
+			lower.label = nodes[child].label + matched;
+			lower.length = nodes[child].length - matched;
+			lower.first_child = nodes[child].first_child;
+			lower.next_sibling = 0;
+			lower.files = nodes[child].files;
+			nodes.push_back(lower);
+
+			nodes[child].length = matched;
+			nodes[child].first_child = nodes.size() - 1;
+			nodes[child].files = 0;
+
+			if(last_node == child) last_node = nodes.size() - 1;
+		}
+
+		current = child;
+		position += matched;
+	}
+
+	nodes[current].files += files;
+
+	last_directory.assign(directory.data(), directory.size());
+	last_node = current;
+}
+
+void DirectoryIndex::remove(string_view directory, unsigned long long files){
+
+	//the directory has been added, so adding nothing to it finds its node without changing the tree
+	add(directory, 0);
+	nodes[last_node].files -= files;
+}
+
+//the number of files in the directory of the node and every directory under it
+unsigned long long DirectoryIndex::subtree_files(unsigned top) const{
+
+	unsigned long long files = 0;
+
+	vector<unsigned> stack(1, top);
+	while(!stack.empty()){
+		const node& current = nodes[stack.back()];
+		stack.pop_back();
+
+		files += current.files;
+
+		for(unsigned child = current.first_child; child != 0; child = nodes[child].next_sibling){
+			stack.push_back(child);
+		}
+	}
+
+	return files;
+}
+
+//call visit(directory, files) for each directory with files, rolled up to the depth (0 for the whole paths)
+//each directory is visited once, in no particular order
+void DirectoryIndex::visit_directories(size_t depth, const function<void(string_view directory, unsigned long long files)>& visit) const{
+
+	//a node to visit, with the length of the path to its parent and the number of components in it
+	struct pending{
+		unsigned index;
+		size_t path_length;
+		size_t components;
+	};
+
+	string path;
+	vector<pending> stack;
+
+	for(unsigned child = nodes[0].first_child; child != 0; child = nodes[child].next_sibling){
+		pending first = {child, 0, 0};
+		stack.push_back(first);
+	}
+
+	while(!stack.empty()){
+		const pending current = stack.back();
+		stack.pop_back();
+
+		const node& current_node = nodes[current.index];
+
+		path.resize(current.path_length);
+		path.append(labels, current_node.label, current_node.length);
+
+		//count the components which end in the label (a leading '/' doesn't end one)
+		//if the depth is reached part of the way along, every file under the node is in that directory
+		size_t components = current.components;
+		bool rolled_up = false;
+
+		for(size_t i = current.path_length; i < path.size(); i++){
+			if((path[i] == '/') && (i > 0)){
+				components++;
+
+				if(components == depth){
+					visit(string_view(path).substr(0, i + 1), subtree_files(current.index));
+					rolled_up = true;
+					break;
+				}
+			}
+		}
+
+		if(rolled_up) continue;
+
+		if(current_node.files > 0){
+			visit(path, current_node.files);
+		}
+
+		for(unsigned child = current_node.first_child; child != 0; child = nodes[child].next_sibling){
+			pending next = {child, path.size(), components};
+			stack.push_back(next);
+		}
+	}
+}
+
+//the directories with the most files, most first
+//(files which aren't in a directory aren't counted)
+vector<directory_count> DirectoryIndex::top_directories(size_t max_directories, size_t depth) const{
+
+	BoundedHeap<directory_count, more_files> top(max_directories);
+
+	visit_directories(depth, [&top](string_view directory, unsigned long long files){
+
+		//only copy the directory if it could be kept
+		if(top.full() && ((top.size() == 0) || (files < top.worst().files))) return;
+
+		directory_count count;
+		count.directory.assign(directory.data(), directory.size());
+		count.files = files;
+
+		top.push(count);
+	});
+
+	return top.sorted();
+}
+
+size_t DirectoryIndex::size() const{
+	return nodes.size();
+}
+
+//add the counts of other to these counts
+void DirectoryIndex::merge(const DirectoryIndex& other){
+
+	//the files which aren't in a directory
+	nodes[0].files += other.nodes[0].files;
+
+	other.visit_directories(0, [this](string_view directory, unsigned long long files){
+		add(directory, files);
+	});
+}
+
+//append the counts to bytes
+//the number of files not in a directory, the number of directories, then each directory and its number of files
+void DirectoryIndex::save(string& bytes) const{
+
+	unsigned long long num_directories = 0;
+	visit_directories(0, [&num_directories](string_view, unsigned long long){
+		num_directories++;
+	});
+
+	write_number(bytes, nodes[0].files);
+	write_number(bytes, num_directories);
+
+	visit_directories(0, [&bytes](string_view directory, unsigned long long files){
+		write_string(bytes, directory);
+		write_number(bytes, files);
+	});
+}
+
+//read counts which were saved with save() and add them to these counts
+void DirectoryIndex::load(Deserializer& in){
+
+	nodes[0].files += in.read_number();
+
+	const unsigned long long num_directories = in.read_number();
+	for(unsigned long long i = 0; (i < num_directories) && in.good(); i++){
+
+		const string_view directory = in.read_string();
+		const unsigned long long files = in.read_number();
+
+		if(in.good() && !directory.empty()){
+			add(directory, files);
+		}
+	}
+}
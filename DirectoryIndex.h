@@ -0,0 +1,88 @@
+/*
+
+DirectoryIndex.h
+
+DirectoryIndex is a class which counts the files in each directory of a report, to find the directories with the most files
+
+The directories are kept in a radix tree: each node is a directory (or a point where paths branch),
+and the edge to it is labelled with the text between its parent and it, so a path shared by many directories is only stored once
+Each node only counts the files directly in its directory, and the counts are rolled up to the depth asked for when they're read,
+so adding a file is a single increment when it's in the same directory as the last one (which most files are)
+
+The depth of a directory is the number of its path components, e.g. /home/user/ has a depth of 2,
+and a directory deeper than the depth is counted as the directory of its first depth components
+
+*/
+
+#ifndef _DIRECTORYINDEX_H_
+#define _DIRECTORYINDEX_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include "Serialization.h"
+using std::string;
+using std::string_view;
+using std::vector;
+using std::function;
+
+
+//the number of files in a directory (and the server it's on, when directories from several servers are compared)
+struct directory_count{
+	string server;
+	string directory;
+	unsigned long long files;
+};
+
+//orders directory_count by the number of files, most first, then by server and directory
+struct more_files{
+	bool operator()(const directory_count& count1, const directory_count& count2) const;
+};
+
+
+class DirectoryIndex{
+
+	struct node{
+		size_t label; //the start of the label of the edge to the node in labels
+		unsigned length; //the length of the label
+		unsigned first_child; //the index of the first child, 0 if there are none (the root is never a child)
+		unsigned next_sibling; //the index of the next child of the same parent, 0 if there are no more
+		unsigned long long files; //the number of files directly in the directory (0 if the node isn't a directory)
+	};
+
+	vector<node> nodes; //nodes[0] is the root, for the empty path
+	string labels; //the text of the labels, a node split in two shares its label's text with the new node
+
+	//the last directory added to, since the next file is probably in it too
+	string last_directory;
+	unsigned last_node;
+
+	//call visit(directory, files) for each directory with files, rolled up to the depth
+	void visit_directories(size_t depth, const function<void(string_view directory, unsigned long long files)>& visit) const;
+	unsigned long long subtree_files(unsigned top) const;
+
+public:
+	DirectoryIndex();
+
+	//count files in the directory, which is the part of a file's path up to and including the last '/'
+	void add(string_view directory, unsigned long long files = 1);
+
+	//take files which were added to the directory out of its count again
+	void remove(string_view directory, unsigned long long files = 1);
+
+	//the directories (rolled up to the depth) with the most files, up to max_directories of them, most first
+	vector<directory_count> top_directories(size_t max_directories, size_t depth) const;
+
+	size_t size() const; //the number of nodes in the tree
+
+	//add the counts of other to these counts
+	void merge(const DirectoryIndex& other);
+
+	//append the counts to bytes / read counts which were saved with save() and add them to these counts
+	void save(string& bytes) const;
+	void load(Deserializer& in);
+};
+
+
+#endif
@@ -0,0 +1,157 @@
+//DirectoryScanner.cpp
+//Implementation of the directory scan
+
+#include "DirectoryScanner.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+static bool scan(const string& directory, const string& prefix, bool recursive, vector<scanned_file>& files);
+
+//used to sort the files by path
+static bool path_less(const scanned_file& file1, const scanned_file& file2){
+	return file1.path < file2.path;
+}
+
+
+bool scan_directory(const string& directory, bool recursive, vector<scanned_file>& files){
+
+	const size_t first = files.size();
+
+	if(!scan(directory, "", recursive, files)) return false;
+
+	//the order in which the files are listed depends on the file system, so sort them to make it the same everywhere
+	std::sort(files.begin() + first, files.end(), path_less);
+
+	return true;
+}
+
+#ifdef _WIN32
+
+//add the files in directory + prefix to files, with paths starting with prefix
+static bool scan(const string& directory, const string& prefix, bool recursive, vector<scanned_file>& files){
+
+	WIN32_FIND_DATA file_data;
+
+	//the basic information leaves out the short names, and the large fetch reads many entries per call,
+	//which makes a difference for directories with a lot of reports
+	HANDLE hFind = FindFirstFileEx((directory + prefix + "*").c_str(), FindExInfoBasic, &file_data,
+		FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+
+	if(hFind == INVALID_HANDLE_VALUE){
+		//an empty directory has no files, but it's not an error
+		return (GetLastError() == ERROR_FILE_NOT_FOUND);
+	}
+
+	bool scanned = true;
+
+	do{
+		const string name = file_data.cFileName;
+
+		//ignore hidden files, and the current and parent directories
+		if((file_data.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) || (name == ".") || (name == "..")) continue;
+
+		if(file_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY){
+			if(recursive && !scan(directory, prefix + name + '\\', recursive, files)){
+				scanned = false;
+			}
+			continue;
+		}
+
+		scanned_file file;
+		file.path = prefix + name;
+		file.name = name;
+		file.size = ((unsigned long long)file_data.nFileSizeHigh << 32) | file_data.nFileSizeLow;
+		file.modified = ((long long)file_data.ftLastWriteTime.dwHighDateTime << 32) | file_data.ftLastWriteTime.dwLowDateTime;
+
+		files.push_back(file);
+
+	} while(FindNextFile(hFind, &file_data));
+
+	//if the reason that we stopped is something other than running out of files, something went wrong
+	if(GetLastError() != ERROR_NO_MORE_FILES) scanned = false;
+
+	FindClose(hFind);
+
+	return scanned;
+}
+
+#else
+
+//add the files in directory + prefix to files, with paths starting with prefix
+static bool scan(const string& directory, const string& prefix, bool recursive, vector<scanned_file>& files){
+
+	DIR* dir = opendir((directory + prefix).c_str());
+	if(dir == NULL) return false;
+
+	//the entries are looked up relative to the open directory, so the path isn't resolved again for each file
+	const int dir_fd = dirfd(dir);
+
+	bool scanned = true;
+	struct dirent* entry;
+	struct stat status;
+
+	while((entry = readdir(dir)) != NULL){
+
+		const char* name = entry->d_name;
+
+		//ignore hidden files, which includes the current and parent directories
+		if(name[0] == '.') continue;
+
+		//only look at the file system when the type of the entry isn't known from the directory itself
+		bool is_directory = false;
+#ifdef DT_DIR
+		if(entry->d_type == DT_DIR){
+			is_directory = true;
+		}
+		else if(entry->d_type == DT_REG){
+			is_directory = false;
+		}
+		else if((entry->d_type != DT_UNKNOWN) && (entry->d_type != DT_LNK)){
+			continue;
+		}
+		else
+#endif
+		{
+			//don't follow links to directories, to avoid loops
+			if(fstatat(dir_fd, name, &status, AT_SYMLINK_NOFOLLOW) != 0) continue;
+			is_directory = S_ISDIR(status.st_mode);
+		}
+
+		if(is_directory){
+			if(recursive && !scan(directory, prefix + name + '/', recursive, files)){
+				scanned = false;
+			}
+			continue;
+		}
+
+		//the size and time are those of the file that a link refers to
+		if((fstatat(dir_fd, name, &status, 0) != 0) || !S_ISREG(status.st_mode)) continue;
+
+		scanned_file file;
+		file.path = prefix + name;
+		file.name = name;
+		file.size = status.st_size;
+#ifdef __APPLE__
+		file.modified = (long long)status.st_mtimespec.tv_sec * 1000000000LL + status.st_mtimespec.tv_nsec;
+#else
+		file.modified = (long long)status.st_mtim.tv_sec * 1000000000LL + status.st_mtim.tv_nsec;
+#endif
+
+		files.push_back(file);
+	}
+
+	closedir(dir);
+
+	return scanned;
+}
+
+#endif
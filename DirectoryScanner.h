@@ -0,0 +1,37 @@
+/*
+
+DirectoryScanner.h
+
+Finds the files in a directory (and optionally its subdirectories)
+
+On Windows this uses FindFirstFileEx, elsewhere opendir/readdir,
+and in both cases the size and modification time of each file are found during the scan
+
+Hidden files and directories (and on POSIX, names starting with '.') are skipped
+
+*/
+
+#ifndef _DIRECTORYSCANNER_H_
+#define _DIRECTORYSCANNER_H_
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+
+//a file found in a directory
+struct scanned_file{
+	string path; //path of the file relative to the scanned directory
+	string name; //name of the file, without any directories
+	unsigned long long size; //size of the file in bytes
+	long long modified; //the time that the file was last modified
+};
+
+//add the files in the directory to files, sorted by path
+//the directory must end with a slash or backslash
+//returns false if the directory could not be read
+bool scan_directory(const string& directory, bool recursive, vector<scanned_file>& files);
+
+
+#endif
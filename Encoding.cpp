@@ -0,0 +1,199 @@
+//Encoding.cpp
+//Implementation of the encoding detection and decoding
+
+#include "Encoding.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ENCODING_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define ENCODING_NEON
+#endif
+
+
+const size_t DETECT_BYTES = 64; //the number of bytes looked at to detect UTF-16 without a byte order mark
+
+const unsigned REPLACEMENT_CHARACTER = 0xFFFD;
+
+text_encoding detect_encoding(string_view contents, size_t& bom_length){
+
+	const unsigned char* bytes = (const unsigned char*)contents.data();
+	bom_length = 0;
+
+	if((contents.size() >= 3) && (bytes[0] == 0xEF) && (bytes[1] == 0xBB) && (bytes[2] == 0xBF)){
+		bom_length = 3;
+		return ENCODING_UTF8;
+	}
+	if((contents.size() >= 2) && (bytes[0] == 0xFF) && (bytes[1] == 0xFE)){
+		bom_length = 2;
+		return ENCODING_UTF16_LE;
+	}
+	if((contents.size() >= 2) && (bytes[0] == 0xFE) && (bytes[1] == 0xFF)){
+		bom_length = 2;
+		return ENCODING_UTF16_BE;
+	}
+
+	//without a byte order mark, UTF-16 text has a 0 byte in most characters (the ASCII ones), and text in any other encoding has none
+	size_t length = (contents.size() < DETECT_BYTES) ? contents.size() : DETECT_BYTES;
+	length &= ~(size_t)1;
+
+	size_t even_zeros = 0, odd_zeros = 0;
+	for(size_t i = 0; i < length; i += 2){
+		if(bytes[i] == 0) even_zeros++;
+		if(bytes[i + 1] == 0) odd_zeros++;
+	}
+
+	if((even_zeros == 0) && (odd_zeros * 4 > length)) return ENCODING_UTF16_LE;
+	if((odd_zeros == 0) && (even_zeros * 4 > length)) return ENCODING_UTF16_BE;
+
+	//UTF-8 (which includes ASCII) must start with a whole character
+	if(contents.empty()) return ENCODING_UTF8;
+
+	const size_t first = utf8_character_length(bytes[0]);
+	if((first == 0) || (first > contents.size())) return ENCODING_UNKNOWN;
+
+	for(size_t i = 1; i < first; i++){
+		if((bytes[i] & 0xC0) != 0x80) return ENCODING_UNKNOWN;
+	}
+
+	return ENCODING_UTF8;
+}
+
+const char* encoding_name(text_encoding encoding){
+	switch(encoding){
+		case ENCODING_UTF16_LE: return "UTF-16LE";
+		case ENCODING_UTF16_BE: return "UTF-16BE";
+		case ENCODING_UTF8: return "UTF-8";
+		default: return "unknown";
+	}
+}
+
+size_t utf8_character_length(unsigned char first){
+	if(first < 0x80) return 1;
+	if((first >= 0xC2) && (first <= 0xDF)) return 2;
+	if((first >= 0xE0) && (first <= 0xEF)) return 3;
+	if((first >= 0xF0) && (first <= 0xF4)) return 4;
+	return 0;
+}
+
+size_t utf8_capacity(size_t length){
+	//each 2 byte character is at most 3 bytes, a surrogate pair (4 bytes) is 4 bytes, and an odd last byte is U+FFFD
+	return (length / 2 + 1) * 3;
+}
+
+static inline unsigned read_unit(const unsigned char* p, bool big_endian){
+	return big_endian ? ((p[0] << 8) | p[1]) : (p[0] | (p[1] << 8));
+}
+
+static inline char* write_utf8(unsigned code_point, char* out){
+	if(code_point < 0x80){
+		*out++ = (char)code_point;
+	}
+	else if(code_point < 0x800){
+		*out++ = (char)(0xC0 | (code_point >> 6));
+		*out++ = (char)(0x80 | (code_point & 0x3F));
+	}
+	else if(code_point < 0x10000){
+		*out++ = (char)(0xE0 | (code_point >> 12));
+		*out++ = (char)(0x80 | ((code_point >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (code_point & 0x3F));
+	}
+	else{
+		*out++ = (char)(0xF0 | (code_point >> 18));
+		*out++ = (char)(0x80 | ((code_point >> 12) & 0x3F));
+		*out++ = (char)(0x80 | ((code_point >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (code_point & 0x3F));
+	}
+	return out;
+}
+
+size_t utf16_to_utf8(string_view contents, bool big_endian, char* out){
+
+	const unsigned char* in = (const unsigned char*)contents.data();
+	const unsigned char* end = in + (contents.size() & ~(size_t)1);
+	char* const out_start = out;
+
+#ifdef ENCODING_SSE2
+	const __m128i not_ascii = _mm_set1_epi16((short)0xFF80);
+	const __m128i zero = _mm_setzero_si128();
+#endif
+
+	while(in != end){
+
+		//8 characters (16 bytes) at a time, until one of them isn't ASCII
+#if defined(ENCODING_SSE2)
+		while(end - in >= 16){
+			__m128i units = _mm_loadu_si128((const __m128i*)in);
+			if(big_endian) units = _mm_or_si128(_mm_slli_epi16(units, 8), _mm_srli_epi16(units, 8));
+
+			if(_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, not_ascii), zero)) != 0xFFFF) break;
+
+			_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(units, units));
+			in += 16;
+			out += 8;
+		}
+#elif defined(ENCODING_NEON)
+		while(end - in >= 16){
+			uint8x16_t bytes = vld1q_u8(in);
+			if(big_endian) bytes = vrev16q_u8(bytes);
+			const uint16x8_t units = vreinterpretq_u16_u8(bytes);
+
+			if(vmaxvq_u16(units) >= 0x80) break;
+
+			vst1_u8((uint8_t*)out, vmovn_u16(units));
+			in += 16;
+			out += 8;
+		}
+#endif
+
+		//then the next 8 characters one at a time, before trying 8 at a time again
+		for(int i = 0; (i < 8) && (in != end); i++){
+
+			unsigned code_point = read_unit(in, big_endian);
+			in += 2;
+
+			if((code_point >= 0xD800) && (code_point <= 0xDFFF)){
+				//a high surrogate followed by a low one is a character above U+FFFF, anything else is not valid
+				const unsigned low = (end - in >= 2) ? read_unit(in, big_endian) : 0;
+
+				if((code_point <= 0xDBFF) && (low >= 0xDC00) && (low <= 0xDFFF)){
+					code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+					in += 2;
+				}
+				else{
+					code_point = REPLACEMENT_CHARACTER;
+				}
+			}
+
+			out = write_utf8(code_point, out);
+		}
+	}
+
+	//half of a character at the end
+	if(contents.size() & 1){
+		out = write_utf8(REPLACEMENT_CHARACTER, out);
+	}
+
+	return out - out_start;
+}
+
+string utf8_character(unsigned code_point){
+	char bytes[4];
+	return string(bytes, write_utf8(code_point, bytes) - bytes);
+}
+
+unsigned utf8_code_point(string_view character){
+
+	if(character.empty()) return 0;
+
+	//the bits of the first byte after its length prefix, then 6 bits from each of the rest
+	const size_t length = character.size();
+	unsigned code_point = (unsigned char)character[0] & ((length == 1) ? 0x7F : (0x7F >> length));
+
+	for(size_t i = 1; i < length; i++){
+		code_point = (code_point << 6) | ((unsigned char)character[i] & 0x3F);
+	}
+
+	return code_point;
+}
@@ -0,0 +1,52 @@
+/*
+
+Encoding.h
+
+Detection of the text encoding of a report, and decoding of UTF-16 reports to UTF-8
+
+Reports saved by PowerShell (e.g. with Out-File or >) are UTF-16 with a byte order mark, and other tools may add
+a UTF-8 byte order mark, so the encoding is found from the first bytes and UTF-16 is decoded to UTF-8 before the lines are parsed
+Since the fields of a line are ASCII, only the file names can have other characters, and these stay UTF-8 for the rules
+
+Most of a report is ASCII, so the decoder converts 8 characters at a time while they are ASCII
+(with SSE2 or NEON, where the processor has them), and only the rest one character at a time
+
+*/
+
+#ifndef _ENCODING_H_
+#define _ENCODING_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+using std::string;
+using std::string_view;
+
+
+enum text_encoding {ENCODING_UTF8, ENCODING_UTF16_LE, ENCODING_UTF16_BE, ENCODING_UNKNOWN};
+
+//detect the encoding of contents from its byte order mark, or (without one) from where its first bytes are 0
+//the length of the byte order mark, if there is one, is set in bom_length
+//returns ENCODING_UNKNOWN if the contents don't start with text, e.g. a document with formatting
+text_encoding detect_encoding(string_view contents, size_t& bom_length);
+
+//the name of the encoding, e.g. for the statistics
+const char* encoding_name(text_encoding encoding);
+
+//the most bytes that decoding UTF-16 contents of length bytes can produce
+size_t utf8_capacity(size_t length);
+
+//decode UTF-16 contents (without the byte order mark) to UTF-8 in out, which must have room for utf8_capacity() bytes
+//characters which are not valid UTF-16 (e.g. a lone surrogate) are replaced with U+FFFD
+//returns the number of bytes written
+size_t utf16_to_utf8(string_view contents, bool big_endian, char* out);
+
+//the number of bytes in the UTF-8 character which starts with the byte, 0 if it can't start one
+size_t utf8_character_length(unsigned char first);
+
+//the UTF-8 character for a code point, and the code point of a whole UTF-8 character
+string utf8_character(unsigned code_point);
+unsigned utf8_code_point(string_view character);
+
+
+#endif
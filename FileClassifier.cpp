@@ -2,13 +2,20 @@
 //Implementation of FileClassifier class
 
 #include "FileClassifier.h"
+#include "Hash.h"
 
+#include <limits>
 #include <list>
 #include <string>
 using std::list;
 using std::string;
+using std::numeric_limits;
 
 
+FileClassifier::FileClassifier(){
+	compile();
+}
+
 void FileClassifier::add_extension(string extension){
 	extensions.push_front(extension);
 }
@@ -16,30 +23,180 @@ void FileClassifier::add_substring(string substring){
 	substrings.push_front(substring);
 }
 
-//returns true iff the extensions/substrings make the file have the classification
-bool FileClassifier::satisfies(string file_name){
-	
-	//for each substring
-	for(list<string>::iterator i = substrings.begin(); i != substrings.end(); i++){
-		//if the substring can be found in the file name, we're done
-		if(file_name.find(*i) != string::npos){
-			return true;
-		}
+bool FileClassifier::add_glob(string glob, string& error, unsigned long line){
+
+	//check the pattern on its own, so that a bad pattern is reported when it's added instead of by compile()
+	RuleAutomaton check;
+	if(!check.add_glob(glob, error)) return false;
+
+	pattern rule = {glob, line, 0};
+	globs.push_front(rule);
+	return true;
+}
+bool FileClassifier::add_regex(string regex, string& error, unsigned long line){
+
+	RuleAutomaton check;
+	if(!check.add_regex(regex, error)) return false;
+
+	pattern rule = {regex, line, 0};
+	regexes.push_front(rule);
+	return true;
+}
+
+//add the extensions and substrings to an automaton
+//their DFA has at most a state for each of their characters, so it never needs to be split up
+void FileClassifier::add_fixed_rules(RuleAutomaton& automaton) const{
+	for(list<string>::const_iterator i = extensions.begin(); i != extensions.end(); i++){
+		automaton.add_extension(*i);
+	}
+	for(list<string>::const_iterator i = substrings.begin(); i != substrings.end(); i++){
+		automaton.add_substring(*i);
+	}
+}
+
+//the number of states of the DFA of a glob or regex on its own, or 0 if it would have more than MAX_DFA_STATES
+size_t FileClassifier::pattern_states(const pattern& rule, bool regex){
+
+	//the patterns were checked when they were added
+	string error;
+	RuleAutomaton automaton;
+	if(regex) automaton.add_regex(rule.text, error);
+	else automaton.add_glob(rule.text, error);
+
+	rule_dfa compiled;
+	if(!automaton.compile(compiled, error)) return 0;
+
+	return compiled.matches.size();
+}
+
+//add a glob or regex to the combined rules if they still fit in a DFA with it, otherwise keep it separately
+void FileClassifier::add_pattern(RuleAutomaton& combined, const pattern& rule, bool regex){
+
+	//the combined DFA has at least as many states as the pattern's own, so it can't fit in the states which are left
+	const size_t states_left = MAX_DFA_STATES - dfa.matches.size();
+	if(rule.states > states_left){
+		add_separate(rule, regex);
+		return;
+	}
+
+	string error;
+	RuleAutomaton trial = combined;
+	if(regex) trial.add_regex(rule.text, error);
+	else trial.add_glob(rule.text, error);
+
+	rule_dfa compiled;
+	if(trial.compile(compiled, error)){
+		combined = trial;
+		dfa = compiled;
+		return;
+	}
+
+	add_separate(rule, regex);
+}
+
+//keep a glob or regex which is too complex to combine with the other rules, to be checked on its own
+void FileClassifier::add_separate(const pattern& rule, bool regex){
+
+	string error;
+	separate.push_back(RuleAutomaton());
+	if(regex) separate.back().add_regex(rule.text, error);
+	else separate.back().add_glob(rule.text, error);
+
+	separate_rules.push_back(pair<unsigned long, string>(rule.line, (regex ? "the regex " : "the glob ") + rule.text));
+}
+
+//combine the rules into a single DFA
+void FileClassifier::compile(){
+
+	separate.clear();
+	separate_rules.clear();
+
+	//a pattern which is too complex on its own is kept separately straight away, without making the combined DFA
+	//(the patterns are taken in the order they were added, the lists are newest first)
+	RuleAutomaton automaton;
+	add_fixed_rules(automaton);
+
+	string error;
+	for(list<pattern>::reverse_iterator i = globs.rbegin(); i != globs.rend(); i++){
+		i->states = pattern_states(*i, false);
+
+		if(i->states == 0) add_separate(*i, false);
+		else automaton.add_glob(i->text, error);
+	}
+	for(list<pattern>::reverse_iterator i = regexes.rbegin(); i != regexes.rend(); i++){
+		i->states = pattern_states(*i, true);
+
+		if(i->states == 0) add_separate(*i, true);
+		else automaton.add_regex(i->text, error);
 	}
 
+	if(automaton.compile(dfa, error)) return;
 
-	//get the file extension
-	const string file_extension = file_name.substr(file_name.find_last_of("\\/.") + 1);
+	//the DFA would have too many states, so start again from the extensions and substrings
+	//and add the other patterns one at a time, leaving out the ones which don't fit
+	RuleAutomaton combined;
+	add_fixed_rules(combined);
+	combined.compile(dfa, error, numeric_limits<size_t>::max());
 
-	//for each file extension
-	for(list<string>::iterator i = extensions.begin(); i != extensions.end(); i++){
-		//if the extensions match, we're done
-		if(file_extension == *i){
-			return true;
-		}
+	for(list<pattern>::reverse_iterator i = globs.rbegin(); i != globs.rend(); i++){
+		if(i->states != 0) add_pattern(combined, *i, false);
+	}
+	for(list<pattern>::reverse_iterator i = regexes.rbegin(); i != regexes.rend(); i++){
+		if(i->states != 0) add_pattern(combined, *i, true);
 	}
+}
+
+const list<pair<unsigned long, string> >& FileClassifier::uncombined_rules() const{
+	return separate_rules;
+}
+
+//returns true iff the rules make the file have the classification
+bool FileClassifier::satisfies(string_view file_name) const{
 
+	//follow the DFA over the file name, if a rule matches before the end of the name, we're done
+	unsigned state = 0;
+	if(dfa.matches[state]) return true;
+
+	for(string_view::iterator c = file_name.begin(); c != file_name.end(); c++){
+		state = dfa.transitions[state * dfa.num_classes + dfa.byte_class[(unsigned char)*c]];
+
+		if(dfa.matches[state]) return true;
+	}
 
-	//by this point we know the file does not have the classification
+	//otherwise only the rules which match up to the end of the name (extensions, globs, regexes ending in $)
+	//and the rules which couldn't be combined are left
+	return dfa.matches_at_end[state] || satisfies_uncombined(file_name);
+}
+
+bool FileClassifier::satisfies_uncombined(string_view file_name) const{
+	for(list<RuleAutomaton>::const_iterator i = separate.begin(); i != separate.end(); i++){
+		if(i->matches(file_name)) return true;
+	}
 	return false;
 }
+
+//a hash of the rules, which changes iff the rules change
+unsigned long long FileClassifier::fingerprint() const{
+
+	unsigned long long hash = 0;
+
+	//the kind of each rule is hashed too, so that an extension doesn't have the same hash as the same substring
+	for(list<string>::const_iterator i = extensions.begin(); i != extensions.end(); i++){
+		hash = hash_bytes(*i, hash_combine(hash, 'e'));
+	}
+	for(list<string>::const_iterator i = substrings.begin(); i != substrings.end(); i++){
+		hash = hash_bytes(*i, hash_combine(hash, 's'));
+	}
+	for(list<pattern>::const_iterator i = globs.begin(); i != globs.end(); i++){
+		hash = hash_bytes(i->text, hash_combine(hash, 'g'));
+	}
+	for(list<pattern>::const_iterator i = regexes.begin(); i != regexes.end(); i++){
+		hash = hash_bytes(i->text, hash_combine(hash, 'r'));
+	}
+
+	return hash;
+}
+
+const rule_dfa& FileClassifier::automaton() const{
+	return dfa;
+}
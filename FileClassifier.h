@@ -7,27 +7,78 @@ if files should be classified a certain way
 
 In this project they are used to identify ignored and critical files
 
+The rules are extensions, substrings, globs and regexes (see RuleAutomaton.h for what they match)
+Once the rules have been added, compile() combines all of them into a single DFA,
+so a file name is checked against every rule in a single pass over the name
+
+A glob or regex can need a very large DFA, e.g. a.{16}b needs a state for each of the 2^16 ways the last 16 characters
+can have had an a in them, so each one is compiled on its own first, and one which is too large even then is checked on its own
+(by RuleAutomaton::matches(), which is slower), instead of the rules failing
+If the others still make the combined DFA too large, they're added to it one at a time, and each one which would take it
+over the limit is checked on its own too
+
+
 */
 
 #ifndef _FILECLASSIFIER_H_
 #define _FILECLASSIFIER_H_
 
+#include "RuleAutomaton.h"
+
 #include <list>
 #include <string>
+#include <string_view>
+#include <utility>
 using std::list;
 using std::string;
+using std::string_view;
+using std::pair;
 
 
 class FileClassifier{
-	
-	//having given extensions or containing given substrings makes the file have the classification
+
+	//a glob or regex, with the line of the preferences file it's from (0 if it isn't from one)
+	struct pattern{
+		string text;
+		unsigned long line;
+		size_t states; //the states of its DFA on its own, 0 if that's more than MAX_DFA_STATES (set by compile())
+	};
+
+	//matching any of these makes the file have the classification
 	list<string> extensions;
 	list<string> substrings;
+	list<pattern> globs;
+	list<pattern> regexes;
+
+	rule_dfa dfa; //the compiled rules
+	list<RuleAutomaton> separate; //the rules which were too complex to combine into dfa, each checked on its own
+	list<pair<unsigned long, string> > separate_rules; //the line and a description of each of them
+
+	void add_fixed_rules(RuleAutomaton& automaton) const;
+	static size_t pattern_states(const pattern& rule, bool regex);
+	void add_pattern(RuleAutomaton& combined, const pattern& rule, bool regex);
+	void add_separate(const pattern& rule, bool regex);
 
 public:
+	FileClassifier();
+
 	void add_extension(string extension);
 	void add_substring(string substring);
-	bool satisfies(string file_name); //returns true iff the extensions/substrings make the file have the classification
+
+	//these return false (and set error) if the pattern is not valid, in which case it isn't added
+	bool add_glob(string glob, string& error, unsigned long line = 0);
+	bool add_regex(string regex, string& error, unsigned long line = 0);
+
+	//build the DFA, this must be done after adding rules for them to take effect
+	void compile();
+
+	//the rules which the last compile() couldn't combine with the others (see above), as their line and e.g. "the regex a.{16}b"
+	const list<pair<unsigned long, string> >& uncombined_rules() const;
+
+	bool satisfies(string_view file_name) const; //returns true iff the rules make the file have the classification
+	bool satisfies_uncombined(string_view file_name) const; //returns true iff one of the uncombined rules matches the file
+	unsigned long long fingerprint() const; //a hash of the rules, which changes iff the rules change
+	const rule_dfa& automaton() const; //the compiled rules (without the uncombined ones), e.g. for a ClassificationCache to resume from
 };
 
 
@@ -0,0 +1,91 @@
+//FingerprintSet.cpp
+//Implementation of FingerprintSet class
+
+#include "FingerprintSet.h"
+#include "Hash.h"
+
+using std::lock_guard;
+
+
+const size_t MIN_SLOTS = 16; //the size of a shard's table when its first fingerprint is added
+
+//the seeds of the two halves of a fingerprint
+const unsigned long long HIGH_SEED = 0x9e3779b97f4a7c15ULL;
+const unsigned long long LOW_SEED = 0xc2b2ae3d27d4eb4fULL;
+
+FingerprintSet::FingerprintSet(){
+	for(size_t i = 0; i < (1 << SHARD_BITS); i++){
+		shards[i].count = 0;
+	}
+}
+
+fingerprint FingerprintSet::make(string_view scope, string_view path){
+
+	//the scope seeds the hash of the path, so that the same path in different scopes has a different fingerprint
+	fingerprint f;
+	f.high = hash_bytes(path, hash_bytes(scope, HIGH_SEED));
+	f.low = hash_bytes(path, hash_bytes(scope, LOW_SEED));
+
+	if((f.high == 0) && (f.low == 0)) f.low = 1;
+
+	return f;
+}
+
+//double the size of a shard's table, and put its fingerprints back in
+void FingerprintSet::grow(shard& s){
+
+	vector<fingerprint> old_slots;
+	old_slots.swap(s.slots);
+
+	s.slots.assign(old_slots.empty() ? MIN_SLOTS : (old_slots.size() * 2), fingerprint());
+	const size_t mask = s.slots.size() - 1;
+
+	for(vector<fingerprint>::iterator i = old_slots.begin(); i != old_slots.end(); i++){
+		if((i->high == 0) && (i->low == 0)) continue;
+
+		size_t slot = (size_t)i->low & mask;
+		while((s.slots[slot].high != 0) || (s.slots[slot].low != 0)){
+			slot = (slot + 1) & mask;
+		}
+		s.slots[slot] = *i;
+	}
+}
+
+bool FingerprintSet::insert(const fingerprint& f){
+
+	shard& s = shards[f.high >> (64 - SHARD_BITS)];
+	lock_guard<mutex> lock(s.lock);
+
+	if((s.count + 1) * 4 > s.slots.size() * 3) grow(s);
+
+	//linear probing from the slot chosen by the low bits, until the fingerprint or an empty slot
+	const size_t mask = s.slots.size() - 1;
+	size_t slot = (size_t)f.low & mask;
+
+	while((s.slots[slot].high != 0) || (s.slots[slot].low != 0)){
+		if((s.slots[slot].high == f.high) && (s.slots[slot].low == f.low)) return false;
+		slot = (slot + 1) & mask;
+	}
+
+	s.slots[slot] = f;
+	s.count++;
+	return true;
+}
+
+unsigned long long FingerprintSet::size(){
+	unsigned long long total = 0;
+	for(size_t i = 0; i < (1 << SHARD_BITS); i++){
+		lock_guard<mutex> lock(shards[i].lock);
+		total += shards[i].count;
+	}
+	return total;
+}
+
+size_t FingerprintSet::memory(){
+	size_t total = 0;
+	for(size_t i = 0; i < (1 << SHARD_BITS); i++){
+		lock_guard<mutex> lock(shards[i].lock);
+		total += shards[i].slots.size() * sizeof(fingerprint);
+	}
+	return total;
+}
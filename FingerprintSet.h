@@ -0,0 +1,71 @@
+/*
+
+FingerprintSet.h
+
+FingerprintSet is a class which remembers which paths have been seen, to find the files which are in more than one place,
+e.g. a file listed twice in a report, or a file on a file system which is mounted on several servers
+
+A path is kept as a 128 bit fingerprint of the scope it's in (the server, or the shared mount) and the path,
+so each distinct path takes a fixed number of bytes however long it is: a 16 byte slot in an open addressing table,
+which is kept between 3/8 and 3/4 full, so at most about 43 bytes
+Two different paths have the same fingerprint with a probability of about n^2 / 2^128, which can be ignored
+
+The table is split into shards, each with its own lock, so that the chunks of a report can be checked at the same time
+
+*/
+
+#ifndef _FINGERPRINTSET_H_
+#define _FINGERPRINTSET_H_
+
+#include <string_view>
+#include <vector>
+#include <mutex>
+using std::string_view;
+using std::vector;
+using std::mutex;
+
+
+//the fingerprint of a path, which is never all zeros (that's an empty slot)
+struct fingerprint{
+	unsigned long long high;
+	unsigned long long low;
+};
+
+
+class FingerprintSet{
+
+	static const unsigned SHARD_BITS = 6; //the first bits of a fingerprint choose its shard
+
+	struct shard{
+		mutex lock;
+		vector<fingerprint> slots; //empty until the first fingerprint is added
+		size_t count;
+	};
+
+	shard shards[1 << SHARD_BITS];
+
+	static void grow(shard& s);
+
+	//a set can't be copied
+	FingerprintSet(const FingerprintSet&);
+	FingerprintSet& operator=(const FingerprintSet&);
+
+public:
+	FingerprintSet();
+
+	//the fingerprint of path in scope
+	static fingerprint make(string_view scope, string_view path);
+
+	//add a fingerprint
+	//returns true iff it wasn't already in the set
+	bool insert(const fingerprint& f);
+
+	//the number of fingerprints in the set
+	unsigned long long size();
+
+	//the bytes used by the tables
+	size_t memory();
+};
+
+
+#endif
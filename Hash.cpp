@@ -0,0 +1,97 @@
+//Hash.cpp
+//Implementation of the hash functions
+
+#include "Hash.h"
+
+#include <cstring>
+
+
+static const unsigned long long PRIME1 = 11400714785074694791ULL;
+static const unsigned long long PRIME2 = 14029467366897019727ULL;
+static const unsigned long long PRIME3 = 1609587929392839161ULL;
+static const unsigned long long PRIME4 = 9650029242287828579ULL;
+static const unsigned long long PRIME5 = 2870177450012600261ULL;
+
+static inline unsigned long long rotate_left(unsigned long long x, int bits){
+	return (x << bits) | (x >> (64 - bits));
+}
+
+//read 8 bytes as a little endian number, regardless of the byte order of the machine
+static inline unsigned long long read64(const unsigned char* p){
+	return (unsigned long long)p[0] | ((unsigned long long)p[1] << 8) | ((unsigned long long)p[2] << 16) | ((unsigned long long)p[3] << 24)
+		| ((unsigned long long)p[4] << 32) | ((unsigned long long)p[5] << 40) | ((unsigned long long)p[6] << 48) | ((unsigned long long)p[7] << 56);
+}
+
+static inline unsigned long long hash_round(unsigned long long accumulator, unsigned long long input){
+	accumulator += input * PRIME2;
+	accumulator = rotate_left(accumulator, 31);
+	return accumulator * PRIME1;
+}
+
+static inline unsigned long long merge_round(unsigned long long hash, unsigned long long accumulator){
+	hash ^= hash_round(0, accumulator);
+	return hash * PRIME1 + PRIME4;
+}
+
+unsigned long long hash_bytes(string_view data, unsigned long long seed){
+
+	const unsigned char* p = (const unsigned char*)data.data();
+	const unsigned char* const end = p + data.size();
+	unsigned long long hash;
+
+	if(data.size() >= 32){
+
+		//four independent accumulators, so the multiplications can overlap
+		unsigned long long v1 = seed + PRIME1 + PRIME2;
+		unsigned long long v2 = seed + PRIME2;
+		unsigned long long v3 = seed;
+		unsigned long long v4 = seed - PRIME1;
+
+		const unsigned char* const limit = end - 32;
+		do{
+			v1 = hash_round(v1, read64(p));
+			v2 = hash_round(v2, read64(p + 8));
+			v3 = hash_round(v3, read64(p + 16));
+			v4 = hash_round(v4, read64(p + 24));
+			p += 32;
+		} while(p <= limit);
+
+		hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+		hash = merge_round(hash, v1);
+		hash = merge_round(hash, v2);
+		hash = merge_round(hash, v3);
+		hash = merge_round(hash, v4);
+	}
+	else{
+		hash = seed + PRIME5;
+	}
+
+	hash += data.size();
+
+	//the remaining bytes
+	for(; p + 8 <= end; p += 8){
+		hash ^= hash_round(0, read64(p));
+		hash = rotate_left(hash, 27) * PRIME1 + PRIME4;
+	}
+	for(; p < end; p++){
+		hash ^= (*p) * PRIME5;
+		hash = rotate_left(hash, 11) * PRIME1;
+	}
+
+	//mix the bits
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+	hash *= PRIME3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+unsigned long long hash_combine(unsigned long long hash, unsigned long long value){
+	unsigned char bytes[8];
+	for(int i = 0; i < 8; i++){
+		bytes[i] = (unsigned char)(value >> (8 * i));
+	}
+	return hash_bytes(string_view((const char*)bytes, 8), hash);
+}
@@ -0,0 +1,24 @@
+/*
+
+Hash.h
+
+Hashing of byte strings, used to fingerprint report contents and preferences
+
+*/
+
+#ifndef _HASH_H_
+#define _HASH_H_
+
+#include <string_view>
+using std::string_view;
+
+
+//a 64 bit hash of the bytes, which reads 32 bytes at a time so that large reports hash quickly
+//(based on the structure of xxHash64)
+unsigned long long hash_bytes(string_view data, unsigned long long seed = 0);
+
+//combine a hash with another value, e.g. to fingerprint several settings at once
+unsigned long long hash_combine(unsigned long long hash, unsigned long long value);
+
+
+#endif
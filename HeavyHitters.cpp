@@ -0,0 +1,108 @@
+//HeavyHitters.cpp
+//Implementation of HeavyHitters class
+
+#include "HeavyHitters.h"
+
+
+HeavyHitters::HeavyHitters(size_t capacity) : capacity(capacity > 0 ? capacity : 1){
+	slots.reserve(this->capacity);
+	heap.reserve(this->capacity);
+	heap_position.reserve(this->capacity);
+}
+
+size_t HeavyHitters::add(unsigned long long key, unsigned long long count, bool& replaced){
+
+	replaced = false;
+
+	//if the key is already counted, just count it
+	unordered_map<unsigned long long, size_t>::iterator i = slot_index.find(key);
+	if(i != slot_index.end()){
+		slots[i->second].count += count;
+		sift_down(heap_position[i->second]);
+		return i->second;
+	}
+
+	//if there's a free counter, the key is counted exactly
+	if(slots.size() < capacity){
+		const size_t slot = slots.size();
+
+		counter new_counter;
+		new_counter.key = key;
+		new_counter.count = count;
+		new_counter.error = 0;
+
+		slots.push_back(new_counter);
+		slot_index[key] = slot;
+		heap.push_back(slot);
+		heap_position.push_back(heap.size() - 1);
+		sift_up(heap.size() - 1);
+
+		return slot;
+	}
+
+	//otherwise it takes over the counter with the smallest count, which it could have had all along
+	const size_t slot = heap[0];
+	counter& smallest = slots[slot];
+
+	slot_index.erase(smallest.key);
+	slot_index[key] = slot;
+
+	smallest.key = key;
+	smallest.error = smallest.count;
+	smallest.count += count;
+	sift_down(0);
+
+	replaced = true;
+	return slot;
+}
+
+size_t HeavyHitters::size() const{
+	return slots.size();
+}
+
+unsigned long long HeavyHitters::key(size_t slot) const{
+	return slots[slot].key;
+}
+
+unsigned long long HeavyHitters::count(size_t slot) const{
+	return slots[slot].count;
+}
+
+unsigned long long HeavyHitters::error(size_t slot) const{
+	return slots[slot].error;
+}
+
+//move the slot at position towards the front of the heap while its count is smaller than its parent's
+void HeavyHitters::sift_up(size_t position){
+	while(position > 0){
+		const size_t parent = (position - 1) / 2;
+		if(slots[heap[parent]].count <= slots[heap[position]].count) break;
+
+		swap_positions(parent, position);
+		position = parent;
+	}
+}
+
+//move the slot at position towards the back of the heap while its count is larger than a child's
+void HeavyHitters::sift_down(size_t position){
+	while(true){
+		size_t smallest = position;
+		const size_t left = 2 * position + 1, right = 2 * position + 2;
+
+		if((left < heap.size()) && (slots[heap[left]].count < slots[heap[smallest]].count)) smallest = left;
+		if((right < heap.size()) && (slots[heap[right]].count < slots[heap[smallest]].count)) smallest = right;
+		if(smallest == position) break;
+
+		swap_positions(position, smallest);
+		position = smallest;
+	}
+}
+
+void HeavyHitters::swap_positions(size_t position1, size_t position2){
+	const size_t slot1 = heap[position1];
+	heap[position1] = heap[position2];
+	heap[position2] = slot1;
+
+	heap_position[heap[position1]] = position1;
+	heap_position[heap[position2]] = position2;
+}
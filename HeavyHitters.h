@@ -0,0 +1,63 @@
+/*
+
+HeavyHitters.h
+
+HeavyHitters is a class which keeps the keys with the largest counts (the heavy hitters) in a fixed number of counters,
+with the Space-Saving algorithm
+
+A key which is already counted has its count increased, and a new key takes over the counter with the smallest count,
+starting from that count, which is remembered as the most that its count can be too large by
+So a count is never less than the true count of its key, and at most its error more,
+and every key whose true count is more than total / capacity is sure to be kept
+
+The counters are in slots, which stay the same while a key is kept, so other data about the keys can be kept by slot
+
+*/
+
+#ifndef _HEAVYHITTERS_H_
+#define _HEAVYHITTERS_H_
+
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+using std::vector;
+using std::unordered_map;
+
+
+class HeavyHitters{
+
+	struct counter{
+		unsigned long long key; //a hash of what is counted
+		unsigned long long count; //at least the true count of the key
+		unsigned long long error; //the most that count can be more than the true count
+	};
+
+	size_t capacity; //the max number of counters
+	vector<counter> slots;
+	unordered_map<unsigned long long, size_t> slot_index; //key -> its slot
+
+	//a heap of the slots with the smallest count at the front, and the position in it of each slot
+	vector<size_t> heap;
+	vector<size_t> heap_position;
+
+	void sift_up(size_t position);
+	void sift_down(size_t position);
+	void swap_positions(size_t position1, size_t position2);
+
+public:
+	HeavyHitters(size_t capacity);
+
+	//add count to the key, and return its slot
+	//replaced is set to true iff the slot was another key's, whose data by slot should be reset
+	size_t add(unsigned long long key, unsigned long long count, bool& replaced);
+
+	//the number of slots in use
+	size_t size() const;
+
+	unsigned long long key(size_t slot) const;
+	unsigned long long count(size_t slot) const;
+	unsigned long long error(size_t slot) const;
+};
+
+
+#endif
@@ -0,0 +1,68 @@
+//HyperLogLog.cpp
+//Implementation of HyperLogLog class
+
+#include "HyperLogLog.h"
+
+#include <cmath>
+
+
+HyperLogLog::HyperLogLog(unsigned precision){
+
+	if(precision < 4) precision = 4;
+	if(precision > 16) precision = 16;
+
+	this->precision = precision;
+	registers.assign((size_t)1 << precision, 0);
+}
+
+void HyperLogLog::add(unsigned long long key){
+
+	//the first bits choose the register, and the rest are the bits whose leading zeros are counted
+	const size_t index = (size_t)(key >> (64 - precision));
+	unsigned long long rest = key << precision;
+
+	//the position of the first 1 bit, which is past the end of the bits if they are all 0
+	unsigned char rank = 1;
+	while((rank <= 64 - precision) && !(rest & (1ULL << 63))){
+		rest <<= 1;
+		rank++;
+	}
+
+	if(rank > registers[index]) registers[index] = rank;
+}
+
+double HyperLogLog::estimate() const{
+
+	const double m = (double)registers.size();
+
+	double sum = 0;
+	size_t zeros = 0;
+	for(vector<unsigned char>::const_iterator i = registers.begin(); i != registers.end(); i++){
+		sum += std::ldexp(1.0, -(int)*i);
+		if(*i == 0) zeros++;
+	}
+
+	//the bias correction for the number of registers
+	double alpha;
+	if(registers.size() == 16) alpha = 0.673;
+	else if(registers.size() == 32) alpha = 0.697;
+	else if(registers.size() == 64) alpha = 0.709;
+	else alpha = 0.7213 / (1.0 + 1.079 / m);
+
+	const double raw = alpha * m * m / sum;
+
+	//for a few keys, counting the empty registers is more accurate
+	if((raw <= 2.5 * m) && (zeros > 0)){
+		return m * std::log(m / zeros);
+	}
+
+	return raw;
+}
+
+double HyperLogLog::standard_error() const{
+	return 1.04 / std::sqrt((double)registers.size());
+}
+
+void HyperLogLog::clear(){
+	registers.assign(registers.size(), 0);
+}
@@ -0,0 +1,43 @@
+/*
+
+HyperLogLog.h
+
+HyperLogLog is a class which estimates the number of distinct keys added to it in a fixed amount of memory
+
+Each key (a hash of what is counted) goes to one of 2^precision registers, which keeps the longest run of leading zeros
+in the rest of the hashes it has seen, and the number of distinct keys is estimated from the registers
+The standard error of the estimate is about 1.04 / sqrt(2^precision), e.g. 6.5% for a precision of 8 (256 bytes)
+
+*/
+
+#ifndef _HYPERLOGLOG_H_
+#define _HYPERLOGLOG_H_
+
+#include <vector>
+using std::vector;
+
+
+class HyperLogLog{
+
+	unsigned precision; //the number of bits of a hash which choose its register
+	vector<unsigned char> registers;
+
+public:
+	//the precision is from 4 to 16
+	HyperLogLog(unsigned precision = 8);
+
+	//add a key, which should be a good 64 bit hash, since the bits of it are used directly
+	void add(unsigned long long key);
+
+	//estimate the number of distinct keys added
+	double estimate() const;
+
+	//the standard error of the estimate, as a fraction of it
+	double standard_error() const;
+
+	//forget every key
+	void clear();
+};
+
+
+#endif
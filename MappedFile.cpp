@@ -0,0 +1,143 @@
+//MappedFile.cpp
+//Implementation of MappedFile class
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const string& file_name, bool read_contents){
+
+	data = NULL;
+	length = 0;
+	opened = false;
+	mapping_handle = NULL;
+
+	//a file which is read can be written by others at the same time
+	const DWORD share = read_contents ? (FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE) : FILE_SHARE_READ;
+
+	file_handle = CreateFile(file_name.c_str(), GENERIC_READ, share, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(file_handle == INVALID_HANDLE_VALUE) return;
+
+	opened = true;
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file_handle, &size) || (size.QuadPart == 0)) return;
+
+	//read as much of the file as there is (it may have been made shorter since its size was found), and close it
+	if(read_contents){
+		buffer.reset(new char[(size_t)size.QuadPart]);
+
+		DWORD bytes_read = 0;
+		while(length < (size_t)size.QuadPart){
+			DWORD to_read = (DWORD)(((size_t)size.QuadPart - length < (1 << 30)) ? ((size_t)size.QuadPart - length) : (1 << 30));
+			if(!ReadFile(file_handle, buffer.get() + length, to_read, &bytes_read, NULL)){
+				opened = false;
+				break;
+			}
+			if(bytes_read == 0) break;
+			length += bytes_read;
+		}
+
+		data = buffer.get();
+		CloseHandle(file_handle);
+		file_handle = INVALID_HANDLE_VALUE;
+		return;
+	}
+
+	//a mapping can't be made of an empty file, so we only map files which have contents
+	mapping_handle = CreateFileMapping(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(mapping_handle == NULL){
+		opened = false;
+		return;
+	}
+
+	data = (const char*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if(data == NULL){
+		opened = false;
+		return;
+	}
+
+	length = (size_t)size.QuadPart;
+}
+
+MappedFile::~MappedFile(){
+	if((data != NULL) && !buffer) UnmapViewOfFile(data);
+	if(mapping_handle != NULL) CloseHandle(mapping_handle);
+	if(file_handle != INVALID_HANDLE_VALUE) CloseHandle(file_handle);
+}
+
+#else
+
+MappedFile::MappedFile(const string& file_name, bool read_contents){
+
+	data = NULL;
+	length = 0;
+	opened = false;
+
+	const int fd = open(file_name.c_str(), O_RDONLY);
+	if(fd == -1) return;
+
+	struct stat file_stat;
+	if(fstat(fd, &file_stat) == 0){
+
+		opened = true;
+
+		//read as much of the file as there is (it may have been made shorter since its size was found)
+		if(read_contents && (file_stat.st_size > 0)){
+			buffer.reset(new char[file_stat.st_size]);
+			data = buffer.get();
+
+			while(length < (size_t)file_stat.st_size){
+				const ssize_t bytes_read = read(fd, buffer.get() + length, file_stat.st_size - length);
+				if((bytes_read == -1) && (errno == EINTR)) continue;
+
+				if(bytes_read == -1) opened = false;
+				if(bytes_read <= 0) break;
+				length += bytes_read;
+			}
+		}
+		//a mapping can't be made of an empty file, so we only map files which have contents
+		else if(file_stat.st_size > 0){
+			void* mapping = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if(mapping != MAP_FAILED){
+				data = (const char*)mapping;
+				length = file_stat.st_size;
+
+				//the file is read from start to finish
+				madvise(mapping, length, MADV_SEQUENTIAL);
+			}
+			else{
+				opened = false;
+			}
+		}
+	}
+
+	//the mapping stays valid after the file is closed
+	close(fd);
+}
+
+MappedFile::~MappedFile(){
+	if((data != NULL) && !buffer) munmap((void*)data, length);
+}
+
+#endif
+
+bool MappedFile::is_open() const{
+	return opened;
+}
+
+string_view MappedFile::contents() const{
+	return string_view(data, length);
+}
@@ -0,0 +1,51 @@
+/*
+
+MappedFile.h
+
+MappedFile is a class which maps a file into memory for reading
+
+The contents can then be read in place without copying them into strings
+
+A file which may be changed while it's read (e.g. a report which is still being written) is read into memory instead,
+since reading a mapping past the end of a file which has been truncated stops the program (with SIGBUS)
+
+*/
+
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+
+#include <string>
+#include <string_view>
+#include <memory>
+using std::string;
+using std::string_view;
+using std::unique_ptr;
+
+
+class MappedFile{
+
+	const char* data; //the mapped contents (null if the file is empty or could not be mapped)
+	size_t length; //the number of bytes mapped
+	bool opened;
+	unique_ptr<char[]> buffer; //the contents, if they were read rather than mapped
+
+#ifdef _WIN32
+	void* file_handle;
+	void* mapping_handle;
+#endif
+
+	//a mapping can't be copied
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+public:
+	//if read_contents, the contents are read into memory rather than mapped
+	MappedFile(const string& file_name, bool read_contents = false);
+	~MappedFile();
+
+	bool is_open() const; //returns true iff the file was opened (an empty file is open but has no contents)
+	string_view contents() const;
+};
+
+
+#endif
@@ -0,0 +1,167 @@
+//MemoryCounter.cpp
+//Replacement of the global operator new and operator delete which counts the memory allocated
+
+#include "MemoryCounter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+using std::atomic;
+using std::size_t;
+using std::mutex;
+using std::lock_guard;
+
+
+//each thread counts its own allocations, so that new and delete don't all write to the same cache line
+//the counts are atomic only so that get_memory_counts can read them, a thread updates its own with a plain load and store
+//the bytes are signed because memory can be freed by another thread than the one which allocated it
+struct thread_counts{
+	atomic<unsigned long long> allocations{0};
+	atomic<long long> unsynced_bytes{0}; //the bytes allocated (less those freed) since they were last added to bytes_in_use
+	thread_counts* next = NULL; //the other counting threads
+	int state = 0; //0 until the thread is added to the list, 1 while it's in it, 2 after the thread has ended
+};
+
+//a thread's bytes are added to the totals when it has allocated or freed this many since they last were
+//so the peak is exact to within this many bytes for each thread
+static const long long SYNC_BYTES = 64 * 1024;
+
+static atomic<long long> bytes_in_use(0);
+static atomic<long long> peak_bytes(0);
+
+static mutex threads_lock; //guards the list of threads and ended_allocations
+static thread_counts* threads = NULL;
+static unsigned long long ended_allocations = 0; //the allocations made by the threads which have ended
+
+static thread_local thread_counts counts;
+
+//add the thread's bytes to the totals, and raise the peak if it's been exceeded
+static void sync_bytes(long long bytes){
+	const long long in_use = bytes_in_use.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+	long long peak = peak_bytes.load(std::memory_order_relaxed);
+	while((in_use > peak) && !peak_bytes.compare_exchange_weak(peak, in_use, std::memory_order_relaxed));
+}
+
+//takes the thread's counts out of the list when it ends
+//its allocations are kept in ended_allocations, and what it allocates after this (in other thread_local destructors) goes straight to the totals
+struct thread_exit{
+	~thread_exit(){
+		lock_guard<mutex> lock(threads_lock);
+
+		for(thread_counts** i = &threads; *i != NULL; i = &(*i)->next){
+			if(*i == &counts){
+				*i = counts.next;
+				break;
+			}
+		}
+
+		ended_allocations += counts.allocations.load(std::memory_order_relaxed);
+		sync_bytes(counts.unsynced_bytes.exchange(0, std::memory_order_relaxed));
+		counts.state = 2;
+	}
+};
+
+static thread_local thread_exit exit_hook;
+
+//add the thread's counts to the list the first time it allocates
+static void add_thread(){
+	{
+		lock_guard<mutex> lock(threads_lock);
+		counts.next = threads;
+		threads = &counts;
+		counts.state = 1;
+	}
+
+	//using it makes it be destroyed when the thread ends
+	(void)&exit_hook;
+}
+
+static inline void count(long long bytes, bool allocation){
+
+	if(counts.state != 1){
+		if(counts.state == 0){
+			add_thread();
+		}
+		else{
+			if(allocation){
+				lock_guard<mutex> lock(threads_lock);
+				ended_allocations++;
+			}
+			sync_bytes(bytes);
+			return;
+		}
+	}
+
+	if(allocation){
+		counts.allocations.store(counts.allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	const long long unsynced = counts.unsynced_bytes.load(std::memory_order_relaxed) + bytes;
+	if((unsynced >= SYNC_BYTES) || (unsynced <= -SYNC_BYTES)){
+		counts.unsynced_bytes.store(0, std::memory_order_relaxed);
+		sync_bytes(unsynced);
+	}
+	else{
+		counts.unsynced_bytes.store(unsynced, std::memory_order_relaxed);
+	}
+}
+
+//the size of each allocation is stored in front of it, so that it's known when the memory is freed
+//the header is large enough to keep the memory after it aligned for any type
+static const size_t HEADER_SIZE = alignof(std::max_align_t);
+
+
+void* operator new(size_t size){
+
+	char* memory = (char*)malloc(size + HEADER_SIZE);
+	if(memory == NULL) throw std::bad_alloc();
+
+	*(size_t*)memory = size;
+	count((long long)size, true);
+
+	return memory + HEADER_SIZE;
+}
+
+void operator delete(void* pointer) noexcept{
+
+	if(pointer == NULL) return;
+
+	char* memory = (char*)pointer - HEADER_SIZE;
+	count(-(long long)*(size_t*)memory, false);
+
+	free(memory);
+}
+
+void operator delete(void* pointer, size_t) noexcept{
+	operator delete(pointer);
+}
+
+memory_counts get_memory_counts(void){
+
+	lock_guard<mutex> lock(threads_lock);
+
+	unsigned long long allocations = ended_allocations;
+	long long in_use = bytes_in_use.load(std::memory_order_relaxed);
+
+	for(thread_counts* i = threads; i != NULL; i = i->next){
+		allocations += i->allocations.load(std::memory_order_relaxed);
+		in_use += i->unsynced_bytes.load(std::memory_order_relaxed);
+	}
+
+	if(in_use < 0) in_use = 0;
+	const long long peak = peak_bytes.load(std::memory_order_relaxed);
+
+	memory_counts result;
+	result.allocations = allocations;
+	result.bytes_in_use = in_use;
+	result.peak_bytes = (in_use > peak) ? in_use : peak;
+
+	return result;
+}
+
+unsigned long long get_thread_allocations(void){
+	return counts.allocations.load(std::memory_order_relaxed);
+}
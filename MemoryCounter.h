@@ -0,0 +1,34 @@
+/*
+
+MemoryCounter.h
+
+Counts the memory allocated by the program
+
+MemoryCounter.cpp replaces the global operator new and operator delete,
+so every allocation made through them is counted
+
+Each thread keeps its own counts, which are only added up when they're read, so counting doesn't make the threads
+contend for the same memory; the bytes in use are added to the shared total every 64 KB, so the peak is exact to
+within 64 KB for each thread
+
+*/
+
+#ifndef _MEMORYCOUNTER_H_
+#define _MEMORYCOUNTER_H_
+
+
+//the counts of the memory allocated so far
+struct memory_counts{
+	unsigned long long allocations; //the number of allocations made
+	unsigned long long bytes_in_use; //the number of bytes currently allocated
+	unsigned long long peak_bytes; //the most bytes that have been allocated at once (to within 64 KB for each thread)
+};
+
+memory_counts get_memory_counts(void);
+
+//the number of allocations made so far by the calling thread
+//the difference before and after some work is the number of allocations it made, even while other threads allocate
+unsigned long long get_thread_allocations(void);
+
+
+#endif
@@ -0,0 +1,132 @@
+//PartialResults.cpp
+//Implementation of PartialResults class
+
+#include "PartialResults.h"
+#include "Serialization.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <fstream>
+using std::ofstream;
+using std::ios;
+using std::to_string;
+
+
+//the start of every partial results file, the number is increased whenever the format changes
+static const string PARTIAL_MAGIC = "WWFPARTL";
+static const unsigned long long PARTIAL_VERSION = 3;
+
+
+PartialResults::PartialResults(unsigned long max_critical, size_t memory_budget, const string& spill_directory)
+	: max_critical(max_critical), memory_budget(memory_budget), spill_directory(spill_directory){
+}
+
+//add the results of a report, merging them with any results for the same server
+void PartialResults::add(const ReportAnalysis& analysis){
+
+	unique_ptr<ReportAnalysis>& results = servers[analysis.server_name];
+
+	if(!results){
+		results.reset(new ReportAnalysis(analysis.server_name, max_critical, memory_budget, spill_directory));
+		results->readable = false; //until results which could be analyzed are merged
+	}
+
+	results->merge(analysis);
+}
+
+void PartialResults::merge(const PartialResults& other){
+	for(map<string, unique_ptr<ReportAnalysis> >::const_iterator i = other.servers.begin(); i != other.servers.end(); i++){
+		add(*i->second);
+	}
+}
+
+//save the results to a partial results file
+//the header, then for each server whether its reports could be analyzed and its saved ReportAnalysis
+//(the results are written as they're saved, so the critical files of every server aren't held in memory at once)
+bool PartialResults::save(const string& file_name) const{
+
+	//write to a temporary file and then replace the file, so that an interrupted save doesn't leave partial results
+	const string temporary_name = file_name + ".tmp";
+	{
+		ofstream file (temporary_name.c_str(), ios::binary | ios::trunc);
+		if(!file.is_open()) return false;
+
+		string bytes = PARTIAL_MAGIC;
+		write_number(bytes, PARTIAL_VERSION);
+		write_number(bytes, max_critical);
+		write_number(bytes, servers.size());
+
+		for(map<string, unique_ptr<ReportAnalysis> >::const_iterator i = servers.begin(); i != servers.end(); i++){
+			write_number(bytes, i->second->readable);
+			i->second->save(bytes, &file);
+		}
+
+		file.write(bytes.data(), bytes.size());
+		if(!file.good()) return false;
+	}
+
+	remove(file_name.c_str());
+	return (rename(temporary_name.c_str(), file_name.c_str()) == 0);
+}
+
+//load a partial results file and merge it into these results
+bool PartialResults::load(const string& file_name, string& error){
+
+	MappedFile file (file_name);
+	if(!file.is_open()){
+		error = "the file could not be opened";
+		return false;
+	}
+
+	Deserializer in(file.contents());
+
+	if((in.read_bytes(PARTIAL_MAGIC.size()) != PARTIAL_MAGIC) || (in.read_number() != PARTIAL_VERSION)){
+		error = "the file is not a partial results file, or is from another version of this program";
+		return false;
+	}
+
+	//fewer critical files than we need to show may have been kept
+	const unsigned long long file_max_critical = in.read_number();
+	if(file_max_critical < max_critical){
+		error = "the file was made with MAX_CRITICAL=" + to_string(file_max_critical)
+			+ ", which is less than MAX_CRITICAL for this run";
+		return false;
+	}
+
+	//load everything before merging any of it, so that a damaged file doesn't add some of its results
+	PartialResults loaded(max_critical, memory_budget, spill_directory);
+
+	const unsigned long long num_servers = in.read_number();
+	for(unsigned long long i = 0; (i < num_servers) && in.good(); i++){
+
+		const bool readable = (in.read_number() != 0);
+
+		ReportAnalysis analysis("", max_critical, memory_budget, spill_directory);
+		if(!in.good() || !analysis.load(in)){
+			error = "the file is damaged";
+			return false;
+		}
+		analysis.readable = readable;
+
+		loaded.add(analysis);
+	}
+
+	if(!in.good() || !in.at_end()){
+		error = "the file is damaged";
+		return false;
+	}
+
+	merge(loaded);
+	return true;
+}
+
+const map<string, unique_ptr<ReportAnalysis> >& PartialResults::results() const{
+	return servers;
+}
+
+//add the owner/server pairs of every server to store
+void PartialResults::merge_into(WWFStore& store) const{
+	for(map<string, unique_ptr<ReportAnalysis> >::const_iterator i = servers.begin(); i != servers.end(); i++){
+		store.merge(i->second->store);
+	}
+}
@@ -0,0 +1,67 @@
+/*
+
+PartialResults.h
+
+PartialResults is a class which holds the results of analyzing some of the reports, one ReportAnalysis per server,
+so that reports can be analyzed where they are made (map) and only the results sent to be summarized (reduce)
+
+The results are saved to a partial results file, and any number of these files can be merged
+Merging is associative and commutative, so partial results can be combined in a tree, in any order,
+and summarizing the merged results gives the same summary report as analyzing all of the reports together
+
+Each server's results have the same memory budget for critical files as a report's, so they are spilled to disk the same way,
+and are written to the file as they're read back rather than being collected in memory first
+
+*/
+
+#ifndef _PARTIALRESULTS_H_
+#define _PARTIALRESULTS_H_
+
+#include <string>
+#include <map>
+#include <memory>
+#include <limits>
+#include "ReportAnalysis.h"
+#include "WWFStore.h"
+using std::string;
+using std::map;
+using std::unique_ptr;
+
+
+class PartialResults{
+
+	unsigned long max_critical; //the max number of critical files kept for each server
+	size_t memory_budget; //the most bytes of critical files each server's results hold before they are spilled
+	string spill_directory; //where they're spilled to
+	map<string, unique_ptr<ReportAnalysis> > servers; //the results for each server, by server name
+
+	//partial results can't be copied
+	PartialResults(const PartialResults&);
+	PartialResults& operator=(const PartialResults&);
+
+public:
+	PartialResults(unsigned long max_critical, size_t memory_budget = std::numeric_limits<size_t>::max(), const string& spill_directory = "");
+
+	//add the results of a report, merging them with any results for the same server
+	void add(const ReportAnalysis& analysis);
+
+	//add the results of every server in other
+	void merge(const PartialResults& other);
+
+	//save the results to a partial results file
+	//returns false iff the file could not be written
+	bool save(const string& file_name) const;
+
+	//load a partial results file and merge it into these results
+	//returns false (and sets error) if the file could not be read or is not a valid partial results file
+	bool load(const string& file_name, string& error);
+
+	//the results for each server, in order of server name
+	const map<string, unique_ptr<ReportAnalysis> >& results() const;
+
+	//add the owner/server pairs of every server to store
+	void merge_into(WWFStore& store) const;
+};
+
+
+#endif
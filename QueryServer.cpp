@@ -0,0 +1,498 @@
+//QueryServer.cpp
+//Implementation of QueryServer class
+
+#include "QueryServer.h"
+#include "PartialResults.h"
+#include "WWFStore.h"
+#include "Arena.h"
+#include "data structs.h"
+#include "Hash.h"
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+using std::ostringstream;
+using std::string_view;
+using std::lock_guard;
+using std::thread;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+
+const int RELOAD_CHECK_SECONDS = 2; //how often the files are checked for changes
+
+
+//the results of the files at the time they were loaded, which are never changed afterwards
+struct QueryServer::snapshot{
+	PartialResults results;
+	WWFStore store; //the owner/server pairs of every server
+
+	//the sums for each server and owner, indexed by ID in store
+	vector<unsigned long> server_files, owner_files, server_critical;
+	unsigned long long total_files, total_critical;
+
+	//the kept critical files of each server, indexed by server ID and sorted by owner then file
+	//the owners are interned in store and the files are stored in file_names
+	vector<vector<critical_file_owner> > critical_files;
+	Arena file_names;
+
+	snapshot(unsigned long max_critical) : results(max_critical), total_files(0), total_critical(0) {}
+};
+
+
+//a number which changes whenever the file is changed or replaced, 0 if it can't be found
+//(partial results are saved to a temporary file which replaces the old one, so the file's inode changes too)
+static unsigned long long file_version(const string& file_name){
+#ifdef _WIN32
+	(void)file_name;
+	return 0;
+#else
+	struct stat status;
+	if(stat(file_name.c_str(), &status) != 0) return 0;
+	return hash_combine(hash_combine(status.st_mtime, status.st_ino), status.st_size);
+#endif
+}
+
+//split a query into the words between its tabs
+static vector<string_view> split_words(string_view query){
+
+	vector<string_view> words;
+
+	size_t start = 0;
+	while(start <= query.size()){
+		size_t end = query.find('\t', start);
+		if(end == string_view::npos) end = query.size();
+
+		words.push_back(query.substr(start, end - start));
+		start = end + 1;
+	}
+
+	return words;
+}
+
+
+QueryServer::QueryServer(const vector<string>& files, unsigned long max_critical) : files(files), max_critical(max_critical), connections(0){
+}
+
+QueryServer::~QueryServer(){
+}
+
+//load the files into a new snapshot, and replace the current one with it
+bool QueryServer::load(string& error){
+
+	lock_guard<mutex> lock(reload_mutex);
+
+	shared_ptr<snapshot> loaded(new snapshot(max_critical));
+
+	//the versions are found first, so that a file which changes while it's loaded is loaded again
+	//(and a file which can't be loaded isn't tried again until it changes)
+	loaded_versions.clear();
+	for(vector<string>::const_iterator i = files.begin(); i != files.end(); i++){
+		loaded_versions.push_back(file_version(*i));
+	}
+
+	for(vector<string>::const_iterator i = files.begin(); i != files.end(); i++){
+		if(!loaded->results.load(*i, error)){
+			error = "the results in " + *i + " could not be loaded, " + error;
+			return false;
+		}
+	}
+
+	WWFStore& store = loaded->store;
+	loaded->results.merge_into(store);
+	store.totals(loaded->server_files, loaded->owner_files, loaded->server_critical);
+
+	for(symbol s = 0; s < loaded->server_files.size(); s++){
+		loaded->total_files += loaded->server_files[s];
+		loaded->total_critical += loaded->server_critical[s];
+	}
+
+	//copy the kept critical files of each server, they're read in order so they stay sorted
+	const map<string, unique_ptr<ReportAnalysis> >& servers = loaded->results.results();
+	for(map<string, unique_ptr<ReportAnalysis> >::const_iterator i = servers.begin(); i != servers.end(); i++){
+
+		const symbol server = store.intern_server(i->first);
+		if(loaded->critical_files.size() <= server) loaded->critical_files.resize(server + 1);
+
+		vector<critical_file_owner>& critical_files = loaded->critical_files[server];
+		i->second->critical_files.for_each_sorted([&](string_view owner, string_view file){
+			critical_file_owner pair;
+			pair.owner = store.owner_name(store.intern_owner(owner));
+			pair.file = loaded->file_names.store(file);
+			critical_files.push_back(pair);
+		});
+	}
+
+	std::atomic_store(&current, shared_ptr<const snapshot>(loaded));
+	return true;
+}
+
+//returns true iff any of the files has changed since they were last loaded
+bool QueryServer::files_changed(){
+
+	lock_guard<mutex> lock(reload_mutex);
+
+	for(size_t i = 0; i < files.size(); i++){
+		if((i >= loaded_versions.size()) || (file_version(files[i]) != loaded_versions[i])) return true;
+	}
+
+	return false;
+}
+
+//answer a query
+string QueryServer::answer(const string& query){
+
+	string_view line = query;
+	if(!line.empty() && (line[line.size() - 1] == '\r')) line.remove_suffix(1);
+
+	const vector<string_view> words = split_words(line);
+	const string_view command = words[0];
+
+	if(command == "reload"){
+		string error;
+		if(!load(error)) return "ERROR " + error + "\n";
+		return "OK 0\n";
+	}
+
+	//the snapshot is kept until the answer is made, even if it's replaced in the meantime
+	shared_ptr<const snapshot> loaded = std::atomic_load(&current);
+	if(!loaded) return "ERROR no results are loaded\n";
+
+	const WWFStore& store = loaded->store;
+
+	ostringstream lines;
+	unsigned long long num_lines = 0;
+
+	if((command == "servers") && (words.size() == 2)){
+
+		symbol owner;
+		if(store.find_owner(words[1], owner)){
+			vector<const WWF_data*> pairs = store.sorted_owner_pairs(owner);
+			for(vector<const WWF_data*>::iterator i = pairs.begin(); i != pairs.end(); i++){
+				lines << store.server_name((*i)->server) << '\t' << (*i)->count << '\t' << (*i)->critical << '\n';
+				num_lines++;
+			}
+		}
+	}
+	else if((command == "owners") && (words.size() == 2)){
+
+		symbol server;
+		if(store.find_server(words[1], server)){
+			vector<const WWF_data*> pairs = store.sorted_server_pairs(server);
+			for(vector<const WWF_data*>::iterator i = pairs.begin(); i != pairs.end(); i++){
+				lines << store.owner_name((*i)->owner) << '\t' << (*i)->count << '\t' << (*i)->critical << '\n';
+				num_lines++;
+			}
+		}
+	}
+	else if((command == "critical") && ((words.size() == 2) || (words.size() == 3))){
+
+		symbol server;
+		if(store.find_server(words[1], server) && (server < loaded->critical_files.size())){
+			const vector<critical_file_owner>& critical_files = loaded->critical_files[server];
+
+			vector<critical_file_owner>::const_iterator first = critical_files.begin();
+			vector<critical_file_owner>::const_iterator last = critical_files.end();
+
+			//the files are sorted by owner, so the owner's files are found with a binary search
+			if(words.size() == 3){
+				const string_view owner = words[2];
+				first = std::lower_bound(critical_files.begin(), critical_files.end(), owner,
+					[](const critical_file_owner& pair, string_view name){ return pair.owner < name; });
+				last = std::upper_bound(first, critical_files.end(), owner,
+					[](string_view name, const critical_file_owner& pair){ return name < pair.owner; });
+			}
+
+			for(vector<critical_file_owner>::const_iterator i = first; i != last; i++){
+				lines << i->owner << '\t' << i->file << '\n';
+				num_lines++;
+			}
+		}
+	}
+	else if((command == "totals") && (words.size() == 1)){
+		lines << store.num_servers() << '\t' << store.num_owners() << '\t'
+			<< loaded->total_files << '\t' << loaded->total_critical << '\n';
+		num_lines++;
+	}
+	else{
+		return "ERROR the queries are: servers <owner>, owners <server>, critical <server> [<owner>], totals and reload,"
+			" with tabs between the words\n";
+	}
+
+	ostringstream answer;
+	answer << "OK " << num_lines << '\n' << lines.str();
+	return answer.str();
+}
+
+
+#ifdef _WIN32
+
+bool QueryServer::serve(const string& socket_path, string& error){
+	(void)socket_path;
+	error = "queries over a local socket are not supported on Windows";
+	return false;
+}
+
+void QueryServer::handle_connection(int connection){
+	(void)connection;
+}
+
+bool send_query(const string& socket_path, const string& query, string& answer, string& error){
+	(void)socket_path;
+	(void)query;
+	(void)answer;
+	error = "queries over a local socket are not supported on Windows";
+	return false;
+}
+
+#else
+
+//write all of the data to the socket
+//returns false iff it could not be written (e.g. the other end has closed it)
+static bool write_all(int connection, const string& data){
+
+	size_t written = 0;
+	while(written < data.size()){
+		const ssize_t result = write(connection, data.data() + written, data.size() - written);
+
+		if(result < 0){
+			if(errno == EINTR) continue;
+			return false;
+		}
+
+		written += result;
+	}
+
+	return true;
+}
+
+//set the address of the socket
+//returns false if the path is too long for a socket address
+static bool socket_address(const string& socket_path, sockaddr_un& address){
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if(socket_path.empty() || (socket_path.size() >= sizeof(address.sun_path))) return false;
+
+	memcpy(address.sun_path, socket_path.data(), socket_path.size());
+	return true;
+}
+
+//answer the queries sent on a connection until it's closed (or sends a query which is too long)
+void QueryServer::handle_connection(int connection){
+
+	string received; //the data received which hasn't been answered yet
+	char buffer[4096];
+
+	while(true){
+		const ssize_t result = read(connection, buffer, sizeof(buffer));
+
+		if(result < 0){
+			if(errno == EINTR) continue;
+			break;
+		}
+
+		//the last query may not end with a newline
+		if(result == 0){
+			if(!received.empty()) write_all(connection, answer(received));
+			break;
+		}
+
+		received.append(buffer, result);
+
+		//answer each complete line
+		size_t start = 0;
+		size_t newline;
+		bool open = true;
+
+		while(open && ((newline = received.find('\n', start)) != string::npos)){
+			open = write_all(connection, answer(received.substr(start, newline - start)));
+			start = newline + 1;
+		}
+
+		received.erase(0, start);
+		if(!open) break;
+
+		//a line which is still going after this many bytes isn't a query, so it isn't held on to
+		if(received.size() > MAX_QUERY_BYTES){
+			write_all(connection, "ERROR the query is longer than " + std::to_string(MAX_QUERY_BYTES) + " bytes\n");
+			break;
+		}
+	}
+
+	close(connection);
+	connections--;
+}
+
+//answer queries on the socket until the program is stopped
+bool QueryServer::serve(const string& socket_path, string& error){
+
+	sockaddr_un address;
+	if(!socket_address(socket_path, address)){
+		error = "the socket path is empty or too long";
+		return false;
+	}
+
+	//a socket left by a server which was stopped is replaced, but nothing else is
+	//(a server is still running if it can be connected to, and a stopped one's socket refuses connections)
+	struct stat status;
+	if(stat(socket_path.c_str(), &status) == 0){
+		if(!S_ISSOCK(status.st_mode)){
+			error = socket_path + " exists and is not a socket";
+			return false;
+		}
+
+		const int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(probe < 0){
+			error = string("the socket could not be created, ") + strerror(errno);
+			return false;
+		}
+
+		const bool answered = (connect(probe, (const sockaddr*)&address, sizeof(address)) == 0);
+		const int connect_error = errno;
+		close(probe);
+
+		if(answered){
+			error = "a server is already answering on " + socket_path;
+			return false;
+		}
+		if(connect_error != ECONNREFUSED){
+			error = "the socket " + socket_path + " could not be checked, " + strerror(connect_error);
+			return false;
+		}
+
+		unlink(socket_path.c_str());
+	}
+
+	const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(listener < 0){
+		error = string("the socket could not be created, ") + strerror(errno);
+		return false;
+	}
+
+	//the results say where the weak points of the servers are, so only this user may query them
+	//(the socket is made with only the user's permissions, rather than changed afterwards, so no one else can connect in between)
+	const mode_t old_mask = umask(S_IRWXG | S_IRWXO);
+	const bool bound = (bind(listener, (const sockaddr*)&address, sizeof(address)) == 0);
+	umask(old_mask);
+
+	if(!bound || (listen(listener, SOMAXCONN) != 0)){
+		error = string("the socket could not be bound, ") + strerror(errno);
+		close(listener);
+		return false;
+	}
+
+	//a client which closes its connection before reading the answer mustn't stop the server
+	signal(SIGPIPE, SIG_IGN);
+
+	//reload the files whenever they change
+	thread([this](){
+		while(true){
+			std::this_thread::sleep_for(std::chrono::seconds(RELOAD_CHECK_SECONDS));
+
+			if(files_changed()){
+				string error;
+				if(load(error)){
+					cout << "The results have changed and have been reloaded." << endl;
+				}
+				else{
+					cerr << "Error: " << error << ", the previous results are still being served." << endl;
+				}
+			}
+		}
+	}).detach();
+
+	//each connection is answered by its own thread, so a slow client doesn't hold up the others,
+	//up to MAX_CONNECTIONS of them, so that clients which don't close their connections can't start threads without end
+	while(true){
+		const int connection = accept(listener, NULL, NULL);
+
+		if(connection < 0){
+			if((errno == EINTR) || (errno == ECONNABORTED)) continue;
+
+			error = string("connections could not be accepted, ") + strerror(errno);
+			close(listener);
+			return false;
+		}
+
+		if(connections >= MAX_CONNECTIONS){
+			write_all(connection, "ERROR there are too many connections, try again later\n");
+			close(connection);
+			continue;
+		}
+
+		connections++;
+		thread(&QueryServer::handle_connection, this, connection).detach();
+	}
+}
+
+//send a query to a QueryServer listening on the socket
+bool send_query(const string& socket_path, const string& query, string& answer, string& error){
+
+	sockaddr_un address;
+	if(!socket_address(socket_path, address)){
+		error = "the socket path is empty or too long";
+		return false;
+	}
+
+	const int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(connection < 0){
+		error = string("the socket could not be created, ") + strerror(errno);
+		return false;
+	}
+
+	if(connect(connection, (const sockaddr*)&address, sizeof(address)) != 0){
+		error = "the server could not be reached on " + socket_path + ", " + strerror(errno);
+		close(connection);
+		return false;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+
+	//send the query and say that there are no more, then read the answer until the server closes the connection
+	if(!write_all(connection, query + "\n")){
+		error = string("the query could not be sent, ") + strerror(errno);
+		close(connection);
+		return false;
+	}
+	shutdown(connection, SHUT_WR);
+
+	answer.clear();
+	char buffer[4096];
+
+	while(true){
+		const ssize_t result = read(connection, buffer, sizeof(buffer));
+
+		if(result < 0){
+			if(errno == EINTR) continue;
+
+			error = string("the answer could not be read, ") + strerror(errno);
+			close(connection);
+			return false;
+		}
+		if(result == 0) break;
+
+		answer.append(buffer, result);
+	}
+
+	close(connection);
+	return true;
+}
+
+#endif
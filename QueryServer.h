@@ -0,0 +1,88 @@
+/*
+
+QueryServer.h
+
+QueryServer is a class which keeps the results in partial results files in memory
+and answers queries about them over a local (Unix domain) socket, so that a question doesn't need a rerun of the analysis
+
+The protocol is a line per query, with the words separated by tabs (so names may contain spaces):
+ servers	<owner>				the servers the owner has WWFs on:	<server> <files> <critical>
+ owners	<server>			the owners with WWFs on the server:	<owner> <files> <critical>
+ critical	<server>			the kept critical files on the server:	<owner> <file>
+ critical	<server>	<owner>		the kept critical files of the owner on the server
+ totals					the number of servers, owners and WWFs:	<servers> <owners> <files> <critical>
+ reload					load the files again now
+The answer is a line "OK <n>" followed by n lines with tab separated fields, sorted like the reports,
+or a line "ERROR <message>"
+A connection may send any number of queries, each of up to MAX_QUERY_BYTES
+At most MAX_CONNECTIONS connections are answered at once, another one is sent an error and closed
+
+The results are held in a snapshot which is never changed once it's loaded, and the files are checked every few seconds
+When one of them changes (e.g. the nightly run has saved new results), a new snapshot is loaded and replaces the old one at once,
+so a query sees either the old results or the new ones, and queries are answered from the old ones while the new ones load
+
+Queries over a socket are not supported on Windows
+
+*/
+
+#ifndef _QUERYSERVER_H_
+#define _QUERYSERVER_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using std::mutex;
+using std::atomic;
+
+
+const size_t MAX_QUERY_BYTES = 64 * 1024; //the longest query line a connection may send
+const unsigned MAX_CONNECTIONS = 64; //the most connections answered at the same time
+
+
+class QueryServer{
+
+	struct snapshot;
+
+	vector<string> files; //the partial results files served
+	unsigned long max_critical; //the max number of critical files which the files must have kept
+
+	shared_ptr<const snapshot> current; //only read or replaced with atomic_load/atomic_store
+	mutex reload_mutex; //held while loading, so that two loads don't race to replace the snapshot
+	vector<unsigned long long> loaded_versions; //the versions of the files when they were last loaded (or tried to be)
+	atomic<unsigned> connections; //the number of connections being answered
+
+	bool files_changed();
+	void handle_connection(int connection);
+
+	//a server can't be copied
+	QueryServer(const QueryServer&);
+	QueryServer& operator=(const QueryServer&);
+
+public:
+	QueryServer(const vector<string>& files, unsigned long max_critical);
+	~QueryServer();
+
+	//load the files into a new snapshot, and replace the current one with it
+	//returns false (and sets error) if any of the files could not be loaded, the current snapshot is kept
+	bool load(string& error);
+
+	//answer a query (a line without its newline), the answer ends with a newline
+	string answer(const string& query);
+
+	//answer queries on the socket until the program is stopped
+	//returns false (and sets error) if the socket could not be created
+	bool serve(const string& socket_path, string& error);
+};
+
+
+//send a query to a QueryServer listening on the socket and set answer to the answer
+//returns false (and sets error) if the server could not be reached
+bool send_query(const string& socket_path, const string& query, string& answer, string& error);
+
+
+#endif
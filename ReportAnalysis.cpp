@@ -0,0 +1,139 @@
+//ReportAnalysis.cpp
+//Implementation of ReportAnalysis class
+
+#include "ReportAnalysis.h"
+#include "Serialization.h"
+
+#include <vector>
+#include <deque>
+using std::vector;
+using std::deque;
+
+
+ReportAnalysis::ReportAnalysis(const string& server_name, unsigned long max_critical, size_t memory_budget, const string& spill_directory)
+	: server_name(server_name), critical_files(max_critical, memory_budget, spill_directory){
+	WWFs = 0;
+	ignored_files = 0;
+	duplicates = 0;
+	earlier_duplicates = 0;
+	readable = true;
+}
+
+//append the results to bytes
+//the server name and counts, then the owner/server pairs, then the kept critical files in sorted order, then the directories
+void ReportAnalysis::save(string& bytes, ostream* file) const{
+
+	write_string(bytes, server_name);
+	write_number(bytes, WWFs);
+	write_number(bytes, ignored_files);
+
+	//the pairs, which are all for this report's server
+	unsigned long long num_pairs = 0;
+	for(symbol s = 0; s < store.num_servers(); s++){
+		num_pairs += store.server_pairs(s).size();
+	}
+	write_number(bytes, num_pairs);
+
+	for(symbol s = 0; s < store.num_servers(); s++){
+		const deque<WWF_data>& pairs = store.server_pairs(s);
+
+		for(deque<WWF_data>::const_iterator i = pairs.begin(); i != pairs.end(); i++){
+			write_string(bytes, store.owner_name(i->owner));
+			write_number(bytes, i->count);
+			write_number(bytes, i->critical);
+		}
+	}
+
+	write_number(bytes, critical_files.count());
+	write_number(bytes, critical_files.kept_count());
+
+	critical_files.for_each_sorted([&bytes, file](string_view owner, string_view file_name){
+		write_string(bytes, owner);
+		write_string(bytes, file_name);
+
+		if((file != NULL) && (bytes.size() >= 1024 * 1024)){
+			file->write(bytes.data(), bytes.size());
+			bytes.clear();
+		}
+	});
+
+	directories.save(bytes);
+}
+
+//load results which were saved with save()
+bool ReportAnalysis::load(string_view bytes){
+
+	Deserializer in(bytes);
+	return load(in) && in.at_end();
+}
+
+bool ReportAnalysis::load(Deserializer& in){
+
+	server_name = in.read_string();
+	WWFs = in.read_number();
+	ignored_files = in.read_number();
+	readable = true;
+
+	const symbol server = store.intern_server(server_name);
+
+	const unsigned long long num_pairs = in.read_number();
+	for(unsigned long long i = 0; (i < num_pairs) && in.good(); i++){
+
+		const string_view owner = in.read_string();
+
+		WWF_data& WWF = store.entry(server, store.intern_owner(owner));
+		WWF.count += in.read_number();
+		WWF.critical += in.read_number();
+	}
+
+	const unsigned long long total_critical = in.read_number();
+	const unsigned long long num_kept = in.read_number();
+
+	for(unsigned long long i = 0; (i < num_kept) && in.good(); i++){
+
+		const string_view owner = in.read_string();
+		const string_view file = in.read_string();
+
+		if(in.good()){
+			critical_files.add(store.owner_name(store.intern_owner(owner)), file);
+		}
+	}
+
+	//the critical files which were omitted when the results were saved
+	if(total_critical >= num_kept){
+		critical_files.add_count(total_critical - num_kept);
+	}
+
+	critical_files.sort();
+
+	directories.load(in);
+
+	return in.good();
+}
+
+//add the results of other (for the same server) to these results
+void ReportAnalysis::merge(const ReportAnalysis& other){
+
+	store.merge(other.store);
+	WWFs += other.WWFs;
+	ignored_files += other.ignored_files;
+	duplicates += other.duplicates;
+	readable = readable || other.readable;
+
+	//the owners are numbered differently in the other results
+	for(vector<counted_WWF>::const_iterator i = other.counted.begin(); i != other.counted.end(); i++){
+		counted_WWF WWF = *i;
+		WWF.owner = store.intern_owner(other.store.owner_name(i->owner));
+		counted.push_back(WWF);
+	}
+
+	//the kept files of both are the smallest of all of their files, so the smallest of those are the smallest of the union
+	other.critical_files.for_each_sorted([this](string_view owner, string_view file){
+		critical_files.add(store.owner_name(store.intern_owner(owner)), file);
+	});
+
+	critical_files.add_count(other.critical_files.count() - other.critical_files.kept_count());
+	critical_files.sort();
+
+	directories.merge(other.directories);
+}
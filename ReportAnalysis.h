@@ -0,0 +1,80 @@
+/*
+
+ReportAnalysis.h
+
+ReportAnalysis is a class which holds the results of analyzing a single WWF report
+
+The results can be saved as bytes and loaded again, so that a report which hasn't changed doesn't need to be reanalyzed,
+and the results for the same server can be merged, e.g. when partial results from several machines are combined
+
+*/
+
+#ifndef _REPORTANALYSIS_H_
+#define _REPORTANALYSIS_H_
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <limits>
+#include "WWFStore.h"
+#include "CriticalFiles.h"
+#include "DirectoryIndex.h"
+#include "FingerprintSet.h"
+#include "Serialization.h"
+#include <vector>
+using std::string;
+using std::string_view;
+using std::ostream;
+using std::vector;
+
+
+//a WWF which has been counted, so that it can be taken out again if another report has the same file
+struct counted_WWF{
+	fingerprint path;
+	symbol owner;
+	bool critical;
+};
+
+
+class ReportAnalysis{
+
+public:
+	string server_name; //name of the server that the report is for
+	WWFStore store; //the owner/server pairs found in the report
+	CriticalFiles critical_files; //the critical files found in the report (up to the max number displayed)
+	DirectoryIndex directories; //the number of WWFs in each directory
+
+	unsigned long WWFs; //the number of WWFs found
+	unsigned long ignored_files; //the number of files which were ignored (or are not world writable)
+	bool readable; //false iff the contents of the report could not be analyzed
+
+	//when duplicates are collapsed, the number of world writable files which had already been counted,
+	//how many of them were counted by an earlier report, and the WWFs which were counted, in file order (none are saved)
+	unsigned long duplicates;
+	unsigned long earlier_duplicates;
+	vector<counted_WWF> counted;
+
+	//the critical files are spilled to the spill directory if they would take more than memory_budget bytes
+	ReportAnalysis(const string& server_name, unsigned long max_critical,
+		size_t memory_budget = std::numeric_limits<size_t>::max(), const string& spill_directory = "");
+
+	//append the results to bytes
+	//if file is given, bytes are written to it and emptied whenever they grow large, so that critical files which were
+	//spilled to disk aren't all held in memory at once (what's left in bytes at the end is for the caller to write)
+	void save(string& bytes, ostream* file = NULL) const;
+
+	//load results which were saved with save()
+	//returns false iff the bytes are not valid results
+	bool load(string_view bytes);
+
+	//load results which were saved with save() from the next bytes of in, which may have more after them
+	//returns false iff they are not valid results
+	bool load(Deserializer& in);
+
+	//add the results of other (for the same server) to these results
+	//merging is associative and commutative, so results can be merged in any order
+	void merge(const ReportAnalysis& other);
+};
+
+
+#endif
@@ -0,0 +1,139 @@
+//ReportCache.cpp
+//Implementation of ReportCache class
+
+#include "ReportCache.h"
+#include "Serialization.h"
+#include "MappedFile.h"
+#include "Hash.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+using std::ifstream;
+using std::ofstream;
+using std::ostringstream;
+using std::ios;
+using std::lock_guard;
+
+
+//the start of every cache file, the number is increased whenever the format of the results changes
+//(or the results for a report would, e.g. when more formats or encodings of report can be read)
+static const string CACHE_MAGIC = "WWFCACHE";
+static const unsigned long long CACHE_VERSION = 4;
+
+
+ReportCache::ReportCache(unsigned long long preferences, bool read_reports) : preferences(preferences), read_reports(read_reports){
+}
+
+//load the cache file, if it exists and was saved with the same preferences
+void ReportCache::load(const string& file_name){
+
+	ifstream file (file_name.c_str(), ios::binary);
+	if(!file.is_open()) return;
+
+	ostringstream contents;
+	contents << file.rdbuf();
+	const string bytes = contents.str();
+
+	Deserializer in(bytes);
+
+	//if the cache is from another version or other preferences, none of it can be used
+	if((in.read_bytes(CACHE_MAGIC.size()) != CACHE_MAGIC) || (in.read_number() != CACHE_VERSION)
+		|| (in.read_number() != preferences)) return;
+
+	const unsigned long long num_entries = in.read_number();
+	for(unsigned long long i = 0; (i < num_entries) && in.good(); i++){
+
+		const string report_name(in.read_string());
+
+		cache_entry entry;
+		entry.size = in.read_number();
+		entry.modified = (long long)in.read_number();
+		entry.content_hash = in.read_number();
+		entry.results = in.read_string();
+
+		if(in.good()){
+			loaded[report_name] = entry;
+		}
+	}
+}
+
+//save the entries for the reports analyzed in this run
+bool ReportCache::save(const string& file_name){
+
+	lock_guard<mutex> lock(current_mutex);
+
+	string bytes = CACHE_MAGIC;
+	write_number(bytes, CACHE_VERSION);
+	write_number(bytes, preferences);
+	write_number(bytes, current.size());
+
+	for(unordered_map<string, cache_entry>::const_iterator i = current.begin(); i != current.end(); i++){
+		write_string(bytes, i->first);
+		write_number(bytes, i->second.size);
+		write_number(bytes, (unsigned long long)i->second.modified);
+		write_number(bytes, i->second.content_hash);
+		write_string(bytes, i->second.results);
+	}
+
+	//write to a temporary file and then replace the cache, so that an interrupted save doesn't leave a partial cache
+	const string temporary_name = file_name + ".tmp";
+	{
+		ofstream file (temporary_name.c_str(), ios::binary | ios::trunc);
+		if(!file.is_open()) return false;
+
+		file.write(bytes.data(), bytes.size());
+		if(!file.good()) return false;
+	}
+
+	remove(file_name.c_str());
+	return (rename(temporary_name.c_str(), file_name.c_str()) == 0);
+}
+
+//find the results for the report, checking that the report has not changed since they were saved
+bool ReportCache::find(const string& directory, const report_file& report, ReportAnalysis& analysis, unsigned long long& content_hash) const{
+
+	unordered_map<string, cache_entry>::const_iterator i = loaded.find(report.file_name);
+	if(i == loaded.end()) return false;
+
+	const cache_entry& entry = i->second;
+
+	//if the size has changed, so have the contents
+	if(entry.size != report.size) return false;
+
+	//if the file has been modified, check whether its contents are actually any different
+	if(entry.modified != report.modified){
+		MappedFile file (directory + report.file_name, read_reports);
+		if(!file.is_open() || (hash_bytes(file.contents()) != entry.content_hash)) return false;
+	}
+
+	content_hash = entry.content_hash;
+	return analysis.load(entry.results);
+}
+
+//remember the results for the report
+void ReportCache::update(const report_file& report, unsigned long long content_hash, const ReportAnalysis& analysis){
+
+	cache_entry entry;
+
+	entry.size = report.size;
+	entry.modified = report.modified;
+	entry.content_hash = content_hash;
+	analysis.save(entry.results);
+
+	lock_guard<mutex> lock(current_mutex);
+	current[report.file_name] = entry;
+}
+
+//remember the cached results for the report, after they were found with find()
+void ReportCache::keep(const report_file& report){
+
+	unordered_map<string, cache_entry>::const_iterator i = loaded.find(report.file_name);
+	if(i == loaded.end()) return;
+
+	cache_entry entry = i->second;
+	entry.modified = report.modified;
+
+	lock_guard<mutex> lock(current_mutex);
+	current[report.file_name] = entry;
+}
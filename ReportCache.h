@@ -0,0 +1,65 @@
+/*
+
+ReportCache.h
+
+ReportCache is a class which remembers the results of analyzing each report between runs
+
+A report's cached results are used if its size and modification time are the same as when it was analyzed,
+or if its contents hash to the same value (e.g. the file was copied again without changing)
+The cache is only used if the preferences which affect the results are the same as when it was saved
+
+*/
+
+#ifndef _REPORTCACHE_H_
+#define _REPORTCACHE_H_
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include "data structs.h"
+#include "ReportAnalysis.h"
+using std::string;
+using std::unordered_map;
+using std::mutex;
+
+
+class ReportCache{
+
+	//what we know about a report when it was analyzed
+	struct cache_entry{
+		unsigned long long size; //the size of the report file
+		long long modified; //the modification time of the report file
+		unsigned long long content_hash; //hash_bytes() of the contents of the report file
+		string results; //the saved ReportAnalysis
+	};
+
+	unsigned long long preferences; //fingerprint of the preferences which affect the results
+	bool read_reports; //whether the reports are read rather than mapped to check their contents, since they may be changing
+	unordered_map<string, cache_entry> loaded; //the entries from the cache file, by report file name
+	unordered_map<string, cache_entry> current; //the entries for the reports analyzed in this run
+	mutex current_mutex; //held while changing current, since workers update it at the same time
+
+public:
+	//if the reports may be changed while they're checked (e.g. when watching them), read_reports should be true
+	ReportCache(unsigned long long preferences, bool read_reports = false);
+
+	//load the cache file, if it exists and was saved with the same preferences
+	void load(const string& file_name);
+
+	//save the entries for the reports analyzed in this run
+	//returns false iff the cache file could not be written
+	bool save(const string& file_name);
+
+	//find the results for the report, checking that the report has not changed since they were saved
+	//returns true iff the results were loaded into analysis
+	bool find(const string& directory, const report_file& report, ReportAnalysis& analysis, unsigned long long& content_hash) const;
+
+	//remember the results for the report
+	void update(const report_file& report, unsigned long long content_hash, const ReportAnalysis& analysis);
+
+	//remember the cached results for the report, after they were found with find()
+	void keep(const report_file& report);
+};
+
+
+#endif
@@ -0,0 +1,120 @@
+//ReportParser.cpp
+//Implementation of ReportParser class
+
+#include "ReportParser.h"
+
+#include <cstring>
+
+
+const int DETECT_LINES = 20; //the number of lines at the start of a report which its format is detected from
+
+
+ReportParser::ReportParser(string_view contents){
+	position = contents.data();
+	end = contents.data() + contents.size();
+	done = false;
+}
+
+//get the next line (without the newline)
+//like reading with getline until the end of the file, a file ending in a newline has an empty last line
+bool ReportParser::next_line(string_view& line){
+
+	if(done) return false;
+
+	const char* newline = (const char*)memchr(position, '\n', end - position);
+
+	if(newline != NULL){
+		line = string_view(position, newline - position);
+		position = newline + 1;
+	}
+	else{
+		line = string_view(position, end - position);
+		position = end;
+		done = true;
+	}
+
+	return true;
+}
+
+//get the nth field of the line (from 0), or an empty field if the line has fewer
+static string_view nth_field(string_view line, int n){
+
+	const char* i = line.data();
+	const char* line_end = line.data() + line.size();
+
+	for(int field = 0; i != line_end; field++){
+
+		while((i != line_end) && SEPARATORS.contains[(unsigned char)*i]) i++;
+
+		const char* field_start = i;
+		while((i != line_end) && !SEPARATORS.contains[(unsigned char)*i]) i++;
+
+		if(field == n) return string_view(field_start, i - field_start);
+	}
+
+	return string_view();
+}
+
+bool ls_format::recognize(string_view line){
+
+	report_line fields;
+	if(!ReportParser::parse_line<ls_format>(line, fields)) return false;
+
+	const string_view links = nth_field(line, 1);
+	for(string_view::const_iterator i = links.begin(); i != links.end(); i++){
+		if(!DIGITS.contains[(unsigned char)*i]) return false;
+	}
+
+	return true;
+}
+
+bool find_format::recognize(string_view line){
+
+	report_line fields;
+	if(!ReportParser::parse_line<find_format>(line, fields)) return false;
+
+	return (fields.file_name[0] == '/') || (fields.file_name[0] == '.');
+}
+
+bool stat_format::recognize(string_view line){
+
+	report_line fields;
+	return ReportParser::parse_line<stat_format>(line, fields);
+}
+
+//detect the format of a report from its first lines
+//the format which the most of them are recognized as is chosen, and ls -l unless another one has more
+report_format ReportParser::detect_format(string_view contents){
+
+	ReportParser parser(contents);
+	string_view line;
+
+	int ls_lines = 0, find_lines = 0, stat_lines = 0;
+
+	for(int n = 0; (n < DETECT_LINES) && parser.next_line(line); n++){
+		if(ls_format::recognize(line)) ls_lines++;
+		if(find_format::recognize(line)) find_lines++;
+		if(stat_format::recognize(line)) stat_lines++;
+	}
+
+	report_format format = FORMAT_LS;
+	int most_lines = ls_lines;
+
+	if(find_lines > most_lines){
+		format = FORMAT_FIND;
+		most_lines = find_lines;
+	}
+	if(stat_lines > most_lines){
+		format = FORMAT_STAT;
+	}
+
+	return format;
+}
+
+const char* ReportParser::format_name(report_format format){
+	switch(format){
+		case FORMAT_FIND: return find_format::name;
+		case FORMAT_STAT: return stat_format::name;
+		default: return ls_format::name;
+	}
+}
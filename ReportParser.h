@@ -0,0 +1,196 @@
+/*
+
+ReportParser.h
+
+ReportParser is a class which splits the contents of a WWF report into lines
+and extracts the fields that the analysis uses from each line
+
+The fields are views into the contents, so no strings are allocated while parsing
+
+A report can be in any of these formats, which is detected from its first lines:
+	ls -l				-rw-rw-rw- 1 owner group 1234 Jan  1 12:00 /path/to/file
+	find -printf '%M %u %p\n'	-rw-rw-rw- owner /path/to/file
+	stat -c '%a %U %n'		666 owner /path/to/file
+Each format is a policy class, and the lines are parsed with parse_line<format>(),
+so the loop over the lines of a report is compiled for its format, with no checks of the format for each line
+
+*/
+
+#ifndef _REPORTPARSER_H_
+#define _REPORTPARSER_H_
+
+#include <string_view>
+using std::string_view;
+
+
+//the fields of a line of a report that are used in the analysis
+struct report_line{
+	string_view permissions; //the file type and permissions, e.g. "-rw-rw-rw-" (or "666" for stat)
+	string_view owner; //the owner of the file
+	string_view file_name; //the file name, which is the rest of the line after the other fields
+};
+
+
+//a table of the characters in a set, made at compile time, so checking a character is a single lookup
+struct char_table{
+	bool contains[256];
+};
+
+constexpr char_table make_char_table(const char* chars){
+	char_table table = {};
+	for(; *chars != '\0'; chars++){
+		table.contains[(unsigned char)*chars] = true;
+	}
+	return table;
+}
+
+//the characters that separate the fields of a line (the same characters that >> skips)
+inline constexpr char_table SEPARATORS = make_char_table(" \t\n\v\f\r");
+
+//the characters removed from the ends of the file name (the same characters that trim() removes)
+inline constexpr char_table TRIMMED = make_char_table(" \t\n\r");
+
+//the file types in symbolic notation:
+//'-' for regular file, 'd' for directory, or 'l' for link, or b, c, p, s
+inline constexpr char_table FILE_TYPES = make_char_table("-dlbcps");
+
+inline constexpr char_table OCTAL_DIGITS = make_char_table("01234567");
+inline constexpr char_table DIGITS = make_char_table("0123456789");
+
+
+//ls -l: permissions, number of hard links, owner, group, size, month, date, time/year, then the file name
+struct ls_format{
+	static constexpr const char* name = "ls -l";
+	static constexpr int NUM_FIELDS = 8; //the fields before the file name
+	static constexpr int OWNER_FIELD = 2;
+
+	//we expect the permissions symbolic notation to be 10 characters long, starting with the file type
+	static bool valid_permissions(string_view permissions){
+		return (permissions.size() == 10) && FILE_TYPES.contains[(unsigned char)permissions[0]];
+	}
+
+	//if the file is world writable then the second last char will be "w", not "-"
+	static bool world_writable(string_view permissions){
+		return (permissions[8] == 'w');
+	}
+
+	//whether a valid line looks like it's in this format rather than another, when detecting the format
+	//the number of hard links is a number
+	static bool recognize(string_view line);
+};
+
+//find -printf '%M %u %p\n': permissions, owner, then the path
+struct find_format{
+	static constexpr const char* name = "find -printf";
+	static constexpr int NUM_FIELDS = 2;
+	static constexpr int OWNER_FIELD = 1;
+
+	static bool valid_permissions(string_view permissions){
+		return ls_format::valid_permissions(permissions);
+	}
+
+	static bool world_writable(string_view permissions){
+		return ls_format::world_writable(permissions);
+	}
+
+	//the path is where find started, e.g. "/home/..." or "./..."
+	static bool recognize(string_view line);
+};
+
+//stat -c '%a %U %n': permissions in octal (3 or 4 digits, with the special bits first), owner, then the file name
+//the file type isn't in the permissions, so any file is valid
+struct stat_format{
+	static constexpr const char* name = "stat -c";
+	static constexpr int NUM_FIELDS = 2;
+	static constexpr int OWNER_FIELD = 1;
+
+	static bool valid_permissions(string_view permissions){
+		return ((permissions.size() == 3) || (permissions.size() == 4))
+			&& OCTAL_DIGITS.contains[(unsigned char)permissions[0]]
+			&& OCTAL_DIGITS.contains[(unsigned char)permissions[1]]
+			&& OCTAL_DIGITS.contains[(unsigned char)permissions[2]]
+			&& ((permissions.size() == 3) || OCTAL_DIGITS.contains[(unsigned char)permissions[3]]);
+	}
+
+	//the last digit is the permissions of others, and 2 is write
+	static bool world_writable(string_view permissions){
+		return (((permissions.back() - '0') & 2) != 0);
+	}
+
+	static bool recognize(string_view line);
+};
+
+//the formats, to choose the policy for a report once it's been detected
+enum report_format {FORMAT_LS, FORMAT_FIND, FORMAT_STAT};
+
+
+class ReportParser{
+
+	const char* position; //the start of the next line
+	const char* end; //the end of the contents
+	bool done;
+
+public:
+	ReportParser(string_view contents);
+
+	//get the next line (without the newline)
+	//returns false iff there are no more lines
+	bool next_line(string_view& line);
+
+	//extract the fields from the line
+	//returns true iff the line contains valid data
+	template<class Format = ls_format>
+	static bool parse_line(string_view line, report_line& fields);
+
+	//returns true iff the file that the line is for is world writable
+	template<class Format = ls_format>
+	static bool world_writable(const report_line& fields){
+		return Format::world_writable(fields.permissions);
+	}
+
+	//detect the format of a report from its first lines
+	//a report which isn't clearly in another format is read as ls -l
+	static report_format detect_format(string_view contents);
+
+	//the name of the format, e.g. for the statistics
+	static const char* format_name(report_format format);
+};
+
+
+template<class Format>
+bool ReportParser::parse_line(string_view line, report_line& fields){
+
+	const char* i = line.data();
+	const char* line_end = line.data() + line.size();
+
+	//we keep the permissions and owner and discard the other fields before the file name
+	for(int field = 0; field < Format::NUM_FIELDS; field++){
+
+		while((i != line_end) && SEPARATORS.contains[(unsigned char)*i]) i++;
+
+		//if the line ends before all of the fields are found, it's invalid
+		if(i == line_end) return false;
+
+		const char* field_start = i;
+		while((i != line_end) && !SEPARATORS.contains[(unsigned char)*i]) i++;
+
+		if(field == 0){
+			fields.permissions = string_view(field_start, i - field_start);
+		}
+		else if(field == Format::OWNER_FIELD){
+			fields.owner = string_view(field_start, i - field_start);
+		}
+	}
+
+	//the file name is just the rest of the line, with leading and trailing white space removed
+	while((i != line_end) && TRIMMED.contains[(unsigned char)*i]) i++;
+	while((line_end != i) && TRIMMED.contains[(unsigned char)*(line_end - 1)]) line_end--;
+
+	fields.file_name = string_view(i, line_end - i);
+
+	//only continue to process the line if the line contains valid data
+	return !fields.file_name.empty() && Format::valid_permissions(fields.permissions);
+}
+
+
+#endif
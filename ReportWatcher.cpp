@@ -0,0 +1,241 @@
+//ReportWatcher.cpp
+//Implementation of ReportWatcher class
+
+#include "ReportWatcher.h"
+#include "DirectoryScanner.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#else
+#include <thread>
+#include <chrono>
+#endif
+
+
+#ifdef __linux__
+
+//the changes which make a report written or removed, and (for the subdirectories) a directory added
+const uint32_t WATCHED_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE | IN_ONLYDIR;
+
+ReportWatcher::ReportWatcher(const string& directory, bool recursive) : directory(directory), recursive(recursive), inotify_fd(-1) {}
+
+ReportWatcher::~ReportWatcher(){
+	if(inotify_fd >= 0) close(inotify_fd);
+}
+
+bool ReportWatcher::start(string& error){
+
+	inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(inotify_fd < 0){
+		error = string("the directory can't be watched (") + strerror(errno) + ")";
+		return false;
+	}
+
+	if(!watch_directories("")){
+		error = "the directory " + directory + " can't be watched (" + strerror(errno) + ")";
+		return false;
+	}
+
+	return true;
+}
+
+//watch directory + relative, and its subdirectories if recursive
+//returns false iff directory + relative itself could not be watched
+bool ReportWatcher::watch_directories(const string& relative){
+
+	const int descriptor = inotify_add_watch(inotify_fd, (directory + relative).c_str(), WATCHED_EVENTS);
+	if(descriptor < 0) return false;
+
+	watched[descriptor] = relative;
+
+	if(!recursive) return true;
+
+	DIR* dir = opendir((directory + relative).c_str());
+	if(dir == NULL) return true;
+
+	struct dirent* entry;
+	struct stat status;
+	while((entry = readdir(dir)) != NULL){
+
+		//hidden directories aren't searched for reports, so they aren't watched either
+		if(entry->d_name[0] == '.') continue;
+
+		//don't follow links to directories, to avoid loops
+		if(fstatat(dirfd(dir), entry->d_name, &status, AT_SYMLINK_NOFOLLOW) != 0) continue;
+
+		if(S_ISDIR(status.st_mode)){
+			watch_directories(relative + entry->d_name + '/');
+		}
+	}
+
+	closedir(dir);
+	return true;
+}
+
+bool ReportWatcher::wait(int timeout, vector<string>& written){
+
+	struct pollfd ready;
+	ready.fd = inotify_fd;
+	ready.events = POLLIN;
+
+	if(poll(&ready, 1, timeout) <= 0) return false;
+
+	bool changed = false;
+
+	//the events are read until there are none left, since one change to a report is often several events
+	alignas(struct inotify_event) char buffer[64 * 1024];
+	ssize_t length;
+	while((length = read(inotify_fd, buffer, sizeof(buffer))) > 0){
+
+		for(char* next = buffer; next < buffer + length; next += sizeof(struct inotify_event) + ((struct inotify_event*)next)->len){
+			const struct inotify_event* event = (const struct inotify_event*)next;
+
+			//if events have been lost, any report may have been written, so every one is checked
+			if(event->mask & IN_Q_OVERFLOW){
+				vector<scanned_file> files;
+				scan_directory(directory, recursive, files);
+				for(vector<scanned_file>::iterator i = files.begin(); i != files.end(); i++){
+					written.push_back(i->path);
+				}
+				changed = true;
+				continue;
+			}
+
+			map<int, string>::iterator watch = watched.find(event->wd);
+			if(watch == watched.end()) continue;
+
+			//the directory has been removed
+			if(event->mask & IN_IGNORED){
+				watched.erase(watch);
+				continue;
+			}
+
+			//hidden files aren't reports, e.g. a report which is copied to a hidden file and then renamed
+			if((event->len == 0) || (event->name[0] == '.')) continue;
+
+			const string path = watch->second + event->name;
+
+			if(event->mask & IN_ISDIR){
+				//a new subdirectory is watched too, and the reports which are already in it have been written
+				if(recursive && (event->mask & (IN_CREATE | IN_MOVED_TO)) && watch_directories(path + '/')){
+					vector<scanned_file> files;
+					scan_directory(directory + path + '/', true, files);
+					for(vector<scanned_file>::iterator i = files.begin(); i != files.end(); i++){
+						written.push_back(path + '/' + i->path);
+					}
+				}
+
+				changed = true;
+			}
+			else if(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)){
+				written.push_back(path);
+				changed = true;
+			}
+			else if(event->mask & (IN_MOVED_FROM | IN_DELETE)){
+				changed = true;
+			}
+		}
+	}
+
+	return changed;
+}
+
+#else
+
+const int SCAN_MILLISECONDS = 2000; //how often the directory is scanned for changes
+
+ReportWatcher::ReportWatcher(const string& directory, bool recursive) : directory(directory), recursive(recursive) {}
+
+ReportWatcher::~ReportWatcher() {}
+
+bool ReportWatcher::start(string& error){
+
+	vector<scanned_file> files;
+	if(!scan_directory(directory, recursive, files)){
+		error = "the directory " + directory + " can't be read";
+		return false;
+	}
+
+	for(vector<scanned_file>::iterator i = files.begin(); i != files.end(); i++){
+		seen[i->path] = pair<unsigned long long, long long>(i->size, i->modified);
+	}
+
+	return true;
+}
+
+//scan the directory, and add the reports which haven't changed since the last scan, but have since they were last reported, to written
+//returns true iff any reports have been written or removed
+bool ReportWatcher::scan_changes(vector<string>& written){
+
+	vector<scanned_file> files;
+	if(!scan_directory(directory, recursive, files)) return false;
+
+	bool changed = false;
+
+	map<string, pair<unsigned long long, long long> > scanned;
+	for(vector<scanned_file>::iterator i = files.begin(); i != files.end(); i++){
+
+		const pair<unsigned long long, long long> version (i->size, i->modified);
+		scanned[i->path] = version;
+
+		map<string, pair<unsigned long long, long long> >::iterator last_seen = seen.find(i->path);
+		if((last_seen != seen.end()) && (last_seen->second == version)){
+			settling.erase(i->path);
+			continue;
+		}
+
+		//a report which is still being written changes between scans
+		map<string, pair<unsigned long long, long long> >::iterator last_scanned = settling.find(i->path);
+		if((last_scanned != settling.end()) && (last_scanned->second == version)){
+			written.push_back(i->path);
+			seen[i->path] = version;
+			settling.erase(last_scanned);
+			changed = true;
+		}
+		else{
+			settling[i->path] = version;
+		}
+	}
+
+	//forget the reports which are gone
+	for(map<string, pair<unsigned long long, long long> >::iterator i = seen.begin(); i != seen.end(); ){
+		if(scanned.find(i->first) == scanned.end()){
+			seen.erase(i++);
+			changed = true;
+		}
+		else{
+			i++;
+		}
+	}
+	for(map<string, pair<unsigned long long, long long> >::iterator i = settling.begin(); i != settling.end(); ){
+		if(scanned.find(i->first) == scanned.end()){
+			settling.erase(i++);
+		}
+		else{
+			i++;
+		}
+	}
+
+	return changed;
+}
+
+bool ReportWatcher::wait(int timeout, vector<string>& written){
+
+	while(true){
+		const int interval = ((timeout < 0) || (timeout > SCAN_MILLISECONDS)) ? SCAN_MILLISECONDS : timeout;
+		std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+		if(timeout > 0) timeout -= interval;
+
+		if(scan_changes(written)) return true;
+		if(timeout == 0) return false;
+	}
+}
+
+#endif
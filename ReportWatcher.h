@@ -0,0 +1,76 @@
+/*
+
+ReportWatcher.h
+
+ReportWatcher is a class which watches the directory with the reports for reports which are written or removed,
+so that each report can be analyzed as soon as it arrives instead of in one run after the last one has
+
+On Linux the directory (and its subdirectories, if they are searched too) is watched with inotify,
+and a report counts as written once the file written to it is closed or it is moved into the directory,
+so a report which is still being copied is not analyzed yet
+Elsewhere the directory is scanned every few seconds, and a report counts as written
+once its size and modification time are the same in two scans in a row
+
+*/
+
+#ifndef _REPORTWATCHER_H_
+#define _REPORTWATCHER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include "WWFStore.h"
+#include "DirectoryIndex.h"
+using std::string;
+using std::vector;
+using std::map;
+using std::pair;
+
+
+//what a report has added to the results, so that it can be taken out again when the report is replaced or removed
+struct report_contribution{
+	unsigned long long size; //the size of the report when it was analyzed
+	long long modified; //the modification time of the report when it was analyzed
+	WWFStore store; //the owner/server pairs found in the report
+	vector<directory_count> directories; //the directories with the most WWFs in the report
+};
+
+
+class ReportWatcher{
+
+	string directory; //the watched directory, ending with a slash or backslash
+	bool recursive; //whether the subdirectories are watched too
+
+#ifdef __linux__
+	int inotify_fd;
+	map<int, string> watched; //inotify watch descriptor -> the watched directory, relative to directory
+
+	bool watch_directories(const string& relative);
+#else
+	map<string, pair<unsigned long long, long long> > seen; //path -> the size and modification time when last reported
+	map<string, pair<unsigned long long, long long> > settling; //path -> the size and modification time in the last scan, if it changed
+
+	bool scan_changes(vector<string>& written);
+#endif
+
+	//a watcher can't be copied
+	ReportWatcher(const ReportWatcher&);
+	ReportWatcher& operator=(const ReportWatcher&);
+
+public:
+	ReportWatcher(const string& directory, bool recursive);
+	~ReportWatcher();
+
+	//start watching, reports which are already in the directory are not reported as written
+	//returns false (and sets error) if the directory could not be watched
+	bool start(string& error);
+
+	//wait for reports to be written or removed, for up to timeout milliseconds (or for as long as it takes if timeout is negative)
+	//the paths of the reports which have been written (relative to the directory) are added to written
+	//returns true iff any reports have been written or removed
+	bool wait(int timeout, vector<string>& written);
+};
+
+
+#endif
@@ -0,0 +1,227 @@
+//ReportWriter.cpp
+//Implementation of ReportWriter and ReportBuffer classes
+
+#include "ReportWriter.h"
+
+#include <charconv>
+using std::unique_lock;
+using std::lock_guard;
+
+const size_t BUFFER_SIZE = 1024 * 1024; //the size at which a ReportBuffer hands its text to the writer
+
+
+ReportWriter::ReportWriter(size_t max_queued_bytes){
+	queued_bytes = 0;
+	this->max_queued_bytes = max_queued_bytes;
+	writing = false;
+	stopping = false;
+
+	writer = thread(&ReportWriter::run, this);
+}
+
+ReportWriter::~ReportWriter(){
+	{
+		lock_guard<mutex> lock(queue_mutex);
+		stopping = true;
+	}
+	queue_changed.notify_all();
+
+	writer.join();
+}
+
+//write the queued pieces until the writer is stopped and there are none left
+void ReportWriter::run(){
+
+	unique_lock<mutex> lock(queue_mutex);
+
+	while(true){
+
+		while(queue.empty() && !stopping){
+			queue_changed.wait(lock);
+		}
+
+		if(queue.empty()) return;
+
+		chunk next;
+		next.file.swap(queue.front().file);
+		next.file_name.swap(queue.front().file_name);
+		next.data.swap(queue.front().data);
+		queue.pop_front();
+		writing = true;
+
+		//write without holding the lock, so more pieces can be queued in the meantime
+		lock.unlock();
+
+		next.file->write(next.data.data(), next.data.size());
+
+		//this releases the writer's hold on the file, which closes it if it was the last piece
+		const size_t written = next.data.size();
+		next.file.reset();
+
+		lock.lock();
+
+		queued_bytes -= written;
+		if(--file_holds[next.file_name] == 0) file_holds.erase(next.file_name);
+		writing = false;
+		queue_changed.notify_all();
+	}
+}
+
+void ReportWriter::write(const string& file_name, const shared_ptr<ofstream>& file, string& data){
+
+	unique_lock<mutex> lock(queue_mutex);
+
+	//don't let the queue grow without bound if the reports are formatted faster than they can be written
+	while((queued_bytes > 0) && (queued_bytes + data.size() > max_queued_bytes)){
+		queue_changed.wait(lock);
+	}
+
+	queue.push_back(chunk());
+	queue.back().file = file;
+	queue.back().file_name = file_name;
+	queue.back().data.swap(data);
+	queued_bytes += queue.back().data.size();
+	file_holds[file_name]++;
+
+	lock.unlock();
+	queue_changed.notify_all();
+}
+
+void ReportWriter::hold(const string& file_name){
+
+	unique_lock<mutex> lock(queue_mutex);
+
+	while(file_holds.find(file_name) != file_holds.end()){
+		queue_changed.wait(lock);
+	}
+
+	file_holds[file_name] = 1;
+}
+
+void ReportWriter::release(const string& file_name){
+	{
+		lock_guard<mutex> lock(queue_mutex);
+		if(--file_holds[file_name] == 0) file_holds.erase(file_name);
+	}
+	queue_changed.notify_all();
+}
+
+void ReportWriter::finish(){
+
+	unique_lock<mutex> lock(queue_mutex);
+
+	while(!queue.empty() || writing){
+		queue_changed.wait(lock);
+	}
+}
+
+
+ReportBuffer::ReportBuffer(ReportWriter& writer, const string& file_name) : writer(&writer), file_name(file_name){
+
+	//opening the file empties it, so an earlier report to the same file must have been written
+	writer.hold(file_name);
+	file.reset(new ofstream(file_name.c_str()));
+
+	buffer.reserve(BUFFER_SIZE);
+}
+
+ReportBuffer::~ReportBuffer(){
+	close();
+}
+
+bool ReportBuffer::is_open() const{
+	return file && file->is_open();
+}
+
+void ReportBuffer::append(string_view text){
+	buffer.append(text.data(), text.size());
+
+	if((buffer.size() >= BUFFER_SIZE) && is_open()){
+		writer->write(file_name, file, buffer);
+		buffer.reserve(BUFFER_SIZE);
+	}
+}
+
+ReportBuffer& ReportBuffer::operator<<(string_view text){
+	append(text);
+	return *this;
+}
+
+ReportBuffer& ReportBuffer::operator<<(char c){
+	append(string_view(&c, 1));
+	return *this;
+}
+
+ReportBuffer& ReportBuffer::operator<<(unsigned long number){
+	return *this << (unsigned long long)number;
+}
+
+ReportBuffer& ReportBuffer::operator<<(unsigned long long number){
+	char digits[24];
+	const char* end = std::to_chars(digits, digits + sizeof(digits), number).ptr;
+	append(string_view(digits, end - digits));
+	return *this;
+}
+
+ReportBuffer& ReportBuffer::operator<<(const aligned& item){
+
+	char digits[24];
+	string_view text = item.text;
+	if(item.is_number){
+		const char* end = std::to_chars(digits, digits + sizeof(digits), item.number).ptr;
+		text = string_view(digits, end - digits);
+	}
+
+	//the width is in characters, so a name with UTF-8 characters (which are several bytes) lines up too
+	//(the bytes which continue a character are 10xxxxxx)
+	size_t characters = 0;
+	for(string_view::const_iterator c = text.begin(); c != text.end(); c++){
+		if(((unsigned char)*c & 0xC0) != 0x80) characters++;
+	}
+
+	//like setw, the text is never cut to fit the width
+	const size_t padding = (characters < item.width) ? (item.width - characters) : 0;
+
+	if(item.to_left){
+		append(text);
+		buffer.append(padding, item.fill);
+	}
+	else{
+		buffer.append(padding, item.fill);
+		append(text);
+	}
+
+	return *this;
+}
+
+void ReportBuffer::close(){
+	if(!file) return;
+
+	if(file->is_open() && !buffer.empty()){
+		writer->write(file_name, file, buffer);
+	}
+
+	file.reset();
+	writer->release(file_name);
+}
+
+
+aligned align_left(string_view text, size_t width, char fill){
+	aligned item = {text, 0, false, width, fill, true};
+	return item;
+}
+
+aligned align_left(unsigned long long number, size_t width, char fill){
+	aligned item = {string_view(), number, true, width, fill, true};
+	return item;
+}
+
+aligned align_right(string_view text, size_t width, char fill){
+	aligned item = {text, 0, false, width, fill, false};
+	return item;
+}
+
+aligned align_right(unsigned long long number, size_t width, char fill){
+	aligned item = {string_view(), number, true, width, fill, false};
+	return item;
+}
@@ -0,0 +1,132 @@
+/*
+
+ReportWriter.h
+
+ReportWriter is a class which writes reports to their files on a background thread
+
+ReportBuffer is a class which formats a report into a large buffer, handing each full buffer to a ReportWriter,
+so that formatting and writing a report doesn't wait on the disk, and the disk is written in large pieces
+
+ReportBuffer has the padding that setw/setfill/left/right give an ostream,
+and the files are opened as text files, so the reports are the same as if they were written with an ofstream
+
+*/
+
+#ifndef _REPORTWRITER_H_
+#define _REPORTWRITER_H_
+
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <memory>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+using std::string;
+using std::string_view;
+using std::ofstream;
+using std::shared_ptr;
+using std::deque;
+using std::map;
+using std::thread;
+using std::mutex;
+using std::condition_variable;
+
+
+class ReportWriter{
+
+	//a piece of a report to be written
+	struct chunk{
+		shared_ptr<ofstream> file;
+		string file_name;
+		string data;
+	};
+
+	deque<chunk> queue; //the pieces waiting to be written, in order
+	map<string, size_t> file_holds; //for each file in use, by its name, the number of pieces queued for it (or being written) and buffers open to it
+	size_t queued_bytes; //the number of bytes waiting to be written
+	size_t max_queued_bytes; //the most bytes to hold before write() waits for the writer to catch up
+	bool writing; //true while the writer thread is writing a piece which has been taken off the queue
+	bool stopping;
+
+	mutex queue_mutex;
+	condition_variable queue_changed;
+
+	thread writer;
+
+	void run();
+
+	//a writer can't be copied
+	ReportWriter(const ReportWriter&);
+	ReportWriter& operator=(const ReportWriter&);
+
+public:
+	ReportWriter(size_t max_queued_bytes = 64 * 1024 * 1024);
+	~ReportWriter(); //writes whatever is still queued
+
+	//queue data to be written to the end of the file with the name, data is left empty
+	//the file is closed once the last piece queued for it has been written
+	void write(const string& file_name, const shared_ptr<ofstream>& file, string& data);
+
+	//wait until the file with the name isn't in use, and then hold it until release()
+	//so a file which is opened again (e.g. for the next report of a server) isn't emptied while pieces are still being written to it
+	void hold(const string& file_name);
+	void release(const string& file_name);
+
+	//wait until everything queued so far has been written and the files closed
+	void finish();
+};
+
+
+//text or a number padded to a width, to be added to a ReportBuffer
+//align_left(x, width) is like setw(width) << left << x, and align_right(x, width) like setw(width) << right << x
+//(except that the width is in UTF-8 characters rather than bytes)
+struct aligned{
+	string_view text;
+	unsigned long long number;
+	bool is_number;
+	size_t width;
+	char fill;
+	bool to_left;
+};
+
+aligned align_left(string_view text, size_t width, char fill = ' ');
+aligned align_left(unsigned long long number, size_t width, char fill = ' ');
+aligned align_right(string_view text, size_t width, char fill = ' ');
+aligned align_right(unsigned long long number, size_t width, char fill = ' ');
+
+
+class ReportBuffer{
+
+	ReportWriter* writer;
+	string file_name;
+	shared_ptr<ofstream> file;
+	string buffer; //the formatted text which hasn't been handed to the writer yet
+
+	void append(string_view text);
+
+	//a buffer can't be copied
+	ReportBuffer(const ReportBuffer&);
+	ReportBuffer& operator=(const ReportBuffer&);
+
+public:
+	//open the file for the report, to be written by writer
+	ReportBuffer(ReportWriter& writer, const string& file_name);
+	~ReportBuffer(); //closes the report
+
+	bool is_open() const;
+
+	ReportBuffer& operator<<(string_view text);
+	ReportBuffer& operator<<(char c);
+	ReportBuffer& operator<<(unsigned long number);
+	ReportBuffer& operator<<(unsigned long long number);
+	ReportBuffer& operator<<(const aligned& item);
+
+	//hand the rest of the report to the writer, nothing more can be added to it
+	void close();
+};
+
+
+#endif
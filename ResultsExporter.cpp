@@ -0,0 +1,203 @@
+//ResultsExporter.cpp
+//Implementation of ResultsExporter and RecordFile classes
+
+#include "ResultsExporter.h"
+
+#include <deque>
+#include <algorithm>
+using std::deque;
+
+
+RecordFile::RecordFile(ReportWriter& writer, const string& file_name, export_format format, initializer_list<string_view> fields)
+	: buffer(writer, file_name), format(format), fields(fields), next_field(0){
+
+	//a CSV file starts with the names of the fields
+	if(format == EXPORT_CSV){
+		for(vector<string_view>::iterator i = this->fields.begin(); i != this->fields.end(); i++){
+			buffer << ((i == this->fields.begin()) ? "" : ",") << *i;
+		}
+		buffer << '\n';
+	}
+}
+
+bool RecordFile::is_open() const{
+	return buffer.is_open();
+}
+
+//add what comes before a field: the separator after the last field, and the name of the field in JSON
+void RecordFile::begin_field(){
+
+	if(format == EXPORT_CSV){
+		if(next_field > 0) buffer << ',';
+	}
+	else{
+		buffer << ((next_field == 0) ? "{\"" : ",\"") << fields[next_field] << "\":";
+	}
+
+	next_field++;
+}
+
+void RecordFile::write_text(string_view text){
+
+	if(format == EXPORT_CSV){
+		//a field is only quoted if it has to be, and quotes in it are doubled
+		if(text.find_first_of(",\"\r\n") == string_view::npos){
+			buffer << text;
+			return;
+		}
+
+		buffer << '"';
+		for(size_t start = 0; start < text.size(); ){
+			const size_t quote = text.find('"', start);
+			if(quote == string_view::npos){
+				buffer << text.substr(start);
+				break;
+			}
+
+			buffer << text.substr(start, quote + 1 - start) << '"';
+			start = quote + 1;
+		}
+		buffer << '"';
+	}
+	else{
+		//escape quotes, backslashes and control characters for JSON, copying the runs of other characters at once
+		buffer << '"';
+
+		size_t start = 0;
+		for(size_t i = 0; i < text.size(); i++){
+			const unsigned char c = text[i];
+			if((c != '"') && (c != '\\') && (c >= 0x20)) continue;
+
+			buffer << text.substr(start, i - start);
+			start = i + 1;
+
+			if((c == '"') || (c == '\\')){
+				buffer << '\\' << (char)c;
+			}
+			else{
+				const char* hex = "0123456789abcdef";
+				buffer << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+			}
+		}
+
+		buffer << text.substr(start) << '"';
+	}
+}
+
+RecordFile& RecordFile::operator<<(string_view text){
+	begin_field();
+	write_text(text);
+	return *this;
+}
+
+RecordFile& RecordFile::operator<<(unsigned long long number){
+	begin_field();
+	buffer << number;
+	return *this;
+}
+
+void RecordFile::end_record(){
+	buffer << ((format == EXPORT_CSV) ? "\n" : "}\n");
+	next_field = 0;
+}
+
+void RecordFile::close(){
+	buffer.close();
+}
+
+
+ResultsExporter::ResultsExporter(ReportWriter& writer, const string& output_directory, export_format format)
+	: pairs(writer, output_directory + "WWF Export Pairs" + ((format == EXPORT_CSV) ? ".csv" : ".jsonl"), format,
+		{"server", "owner", "files", "critical"}),
+	critical_files(writer, output_directory + "WWF Export Critical Files" + ((format == EXPORT_CSV) ? ".csv" : ".jsonl"), format,
+		{"server", "owner", "file"}),
+	servers(writer, output_directory + "WWF Export Servers" + ((format == EXPORT_CSV) ? ".csv" : ".jsonl"), format,
+		{"server", "files", "critical", "owners"}),
+	owners(writer, output_directory + "WWF Export Owners" + ((format == EXPORT_CSV) ? ".csv" : ".jsonl"), format,
+		{"owner", "files", "critical", "servers"}){
+}
+
+bool ResultsExporter::is_open() const{
+	return pairs.is_open() && critical_files.is_open() && servers.is_open() && owners.is_open();
+}
+
+//export the owner/server pairs and critical files of a server, in the same order as its details report
+void ResultsExporter::add_report(const ReportAnalysis& analysis){
+
+	const WWFStore& store = analysis.store;
+
+	for(symbol s = 0; s < store.num_servers(); s++){
+
+		const vector<const WWF_data*> server_pairs = store.sorted_server_pairs(s);
+		for(vector<const WWF_data*>::const_iterator i = server_pairs.begin(); i != server_pairs.end(); i++){
+			pairs << store.server_name(s) << store.owner_name((*i)->owner) << (*i)->count << (*i)->critical;
+			pairs.end_record();
+		}
+	}
+
+	RecordFile& files = critical_files;
+	const string_view server_name = analysis.server_name;
+
+	analysis.critical_files.for_each_sorted([&files, server_name](string_view owner, string_view file){
+		files << server_name << owner << file;
+		files.end_record();
+	});
+}
+
+//export the totals for each server and owner, largest first (ties by name, descending), in the same order as the summary report
+void ResultsExporter::add_totals(const WWFStore& store){
+
+	vector<unsigned long> server_files, owner_files, server_critical;
+	store.totals(server_files, owner_files, server_critical);
+
+	//the number of owners on each server, and the number of critical files and servers for each owner
+	vector<unsigned long> server_owners(store.num_servers(), 0);
+	vector<unsigned long> owner_critical(store.num_owners(), 0), owner_servers(store.num_owners(), 0);
+
+	for(symbol s = 0; s < store.num_servers(); s++){
+		const deque<WWF_data>& server_pairs = store.server_pairs(s);
+
+		for(deque<WWF_data>::const_iterator i = server_pairs.begin(); i != server_pairs.end(); i++){
+			server_owners[s]++;
+			owner_critical[i->owner] += i->critical;
+			owner_servers[i->owner]++;
+		}
+	}
+
+	vector<symbol> order(store.num_servers());
+	for(symbol s = 0; s < order.size(); s++) order[s] = s;
+
+	std::sort(order.begin(), order.end(), [&](symbol a, symbol b){
+		if(server_files[a] != server_files[b]) return (server_files[a] > server_files[b]);
+		return (store.server_name(a) > store.server_name(b));
+	});
+
+	for(vector<symbol>::iterator s = order.begin(); s != order.end(); s++){
+		if(server_owners[*s] == 0) continue; //servers with no WWFs
+
+		servers << store.server_name(*s) << server_files[*s] << server_critical[*s] << server_owners[*s];
+		servers.end_record();
+	}
+
+	order.resize(store.num_owners());
+	for(symbol o = 0; o < order.size(); o++) order[o] = o;
+
+	std::sort(order.begin(), order.end(), [&](symbol a, symbol b){
+		if(owner_files[a] != owner_files[b]) return (owner_files[a] > owner_files[b]);
+		return (store.owner_name(a) > store.owner_name(b));
+	});
+
+	for(vector<symbol>::iterator o = order.begin(); o != order.end(); o++){
+		if(owner_servers[*o] == 0) continue; //owners with no WWFs
+
+		owners << store.owner_name(*o) << owner_files[*o] << owner_critical[*o] << owner_servers[*o];
+		owners.end_record();
+	}
+}
+
+void ResultsExporter::close(){
+	pairs.close();
+	critical_files.close();
+	servers.close();
+	owners.close();
+}
@@ -0,0 +1,88 @@
+/*
+
+ResultsExporter.h
+
+ResultsExporter is a class which exports the results as CSV or JSON Lines files,
+so that other tools can load them directly instead of reading the text reports
+
+The files made in the output directory are (with the extension .csv or .jsonl):
+ WWF Export Pairs		server, owner, files, critical		for every owner/server pair
+ WWF Export Critical Files	server, owner, file			for every critical file shown in the details reports
+ WWF Export Servers		server, files, critical, owners		the totals for each server
+ WWF Export Owners		owner, files, critical, servers		the totals for each owner
+
+RecordFile is a class which writes one of the files, a record at a time
+The records are formatted straight into a ReportBuffer and written in the background,
+so they're written as they're produced, without allocating memory for each one
+
+*/
+
+#ifndef _RESULTSEXPORTER_H_
+#define _RESULTSEXPORTER_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <initializer_list>
+#include "ReportWriter.h"
+#include "ReportAnalysis.h"
+#include "WWFStore.h"
+using std::string;
+using std::string_view;
+using std::vector;
+using std::initializer_list;
+
+
+enum export_format {EXPORT_NONE = 0, EXPORT_CSV, EXPORT_JSON_LINES};
+
+
+class RecordFile{
+
+	ReportBuffer buffer;
+	export_format format;
+	vector<string_view> fields; //the names of the fields of every record, in order
+	size_t next_field; //the index of the next field of the current record
+
+	void begin_field();
+	void write_text(string_view text); //quoted and escaped as the format needs
+
+public:
+	//the field names must stay valid for the life of the file (e.g. string literals)
+	RecordFile(ReportWriter& writer, const string& file_name, export_format format, initializer_list<string_view> fields);
+
+	bool is_open() const;
+
+	//add the next field of the current record
+	RecordFile& operator<<(string_view text);
+	RecordFile& operator<<(unsigned long long number);
+
+	void end_record(); //every field must have been added
+
+	//hand the rest of the file to the writer, nothing more can be added to it
+	void close();
+};
+
+
+class ResultsExporter{
+
+	RecordFile pairs;
+	RecordFile critical_files;
+	RecordFile servers;
+	RecordFile owners;
+
+public:
+	ResultsExporter(ReportWriter& writer, const string& output_directory, export_format format);
+
+	bool is_open() const; //returns true iff all of the files were created
+
+	//export the owner/server pairs and critical files of a server
+	void add_report(const ReportAnalysis& analysis);
+
+	//export the totals for each server and owner of store, which has the results of every report
+	void add_totals(const WWFStore& store);
+
+	void close();
+};
+
+
+#endif
@@ -0,0 +1,1006 @@
+//RuleAutomaton.cpp
+//Implementation of RuleAutomaton class
+
+#include "RuleAutomaton.h"
+#include "Hash.h"
+#include "Encoding.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <map>
+#include <utility>
+using std::unordered_map;
+using std::map;
+using std::pair;
+using std::to_string;
+
+const unsigned MAX_REPEAT = 1000; //the largest count allowed in {m,n}
+const size_t MAX_NFA_STATES = 1000000; //the most states the rules may add, to stop patterns like (a{1000}){1000}
+const unsigned MAX_CHARACTER_RANGE = 4096; //the most characters in a range of characters other than ASCII, e.g. [à-ÿ]
+
+
+//parses a glob or regex into fragments of the automaton
+class RuleAutomaton::Parser{
+
+	RuleAutomaton& automaton;
+	string_view pattern;
+	size_t position; //the next character of the pattern to parse
+
+	//set the error for the current position, keeping the first error found
+	bool fail(const string& message){
+		if(error.empty()){
+			error = "at character " + to_string(position + 1) + ": " + message;
+		}
+		return false;
+	}
+
+	bool at(char c) const{
+		return (position < pattern.size()) && (pattern[position] == c);
+	}
+
+	bool too_large(){
+		return (automaton.states.size() > MAX_NFA_STATES) && !fail("the pattern is too large");
+	}
+
+	//the number of bytes of the UTF-8 character at the position, 1 if it isn't a whole UTF-8 character
+	size_t character_length() const{
+		const size_t length = utf8_character_length((unsigned char)pattern[position]);
+		if((length < 2) || (position + length > pattern.size())) return 1;
+
+		for(size_t i = 1; i < length; i++){
+			if(((unsigned char)pattern[position + i] & 0xC0) != 0x80) return 1;
+		}
+		return length;
+	}
+
+	static char_set characters(bitset<256> bytes, const vector<string>& sequences, bool negated);
+
+	bool parse_class(bool glob, char_set& chars);
+	bool parse_class_item(bool glob, bitset<256>& item, string& sequence);
+	bool parse_escape(bitset<256>& bytes);
+	bool parse_sequence(fragment& result, bool* to_end);
+	bool parse_alternatives(fragment& result);
+	bool parse_repeat(fragment& result);
+	bool parse_atom(fragment& result);
+	bool parse_bound(unsigned& bound);
+
+public:
+	string error;
+
+	Parser(RuleAutomaton& automaton, string_view pattern) : automaton(automaton), pattern(pattern), position(0) {}
+
+	bool parse_glob();
+	bool parse_regex();
+};
+
+
+RuleAutomaton::RuleAutomaton(){
+
+	anchored_start = new_state();
+	unanchored_start = new_state();
+
+	//the unanchored start can skip any number of bytes before a rule starts
+	bitset<256> any;
+	any.set();
+
+	nfa_edge loop = {add_byte_set(any), unanchored_start};
+	states[unanchored_start].edges.push_back(loop);
+}
+
+unsigned RuleAutomaton::new_state(){
+	states.push_back(nfa_state());
+	states.back().accept = ACCEPT_NONE;
+	return states.size() - 1;
+}
+
+//the index of the byte set, adding it if it's new
+unsigned RuleAutomaton::add_byte_set(const bitset<256>& bytes){
+
+	unordered_map<bitset<256>, unsigned>::iterator found = byte_set_index.find(bytes);
+	if(found != byte_set_index.end()) return found->second;
+
+	byte_sets.push_back(bytes);
+	byte_set_index[bytes] = byte_sets.size() - 1;
+	return byte_sets.size() - 1;
+}
+
+//a fragment which reads one of the bytes
+RuleAutomaton::fragment RuleAutomaton::byte_fragment(const bitset<256>& bytes){
+	fragment result;
+	result.start = new_state();
+	result.end = new_state();
+
+	nfa_edge edge = {add_byte_set(bytes), result.end};
+	states[result.start].edges.push_back(edge);
+
+	return result;
+}
+
+//a fragment which reads the text (an empty text is a single state)
+RuleAutomaton::fragment RuleAutomaton::literal_fragment(string_view text){
+	fragment result;
+	result.start = result.end = new_state();
+
+	for(string_view::iterator c = text.begin(); c != text.end(); c++){
+		bitset<256> byte;
+		byte.set((unsigned char)*c);
+
+		const unsigned next = new_state();
+		nfa_edge edge = {add_byte_set(byte), next};
+		states[result.end].edges.push_back(edge);
+		result.end = next;
+	}
+
+	return result;
+}
+
+//a fragment which reads one of the characters
+RuleAutomaton::fragment RuleAutomaton::character_fragment(const char_set& characters){
+
+	fragment result = byte_fragment(characters.bytes);
+
+	if(characters.other_sequences){
+		//every character of 2, 3 or 4 bytes, except the excluded ones
+		for(size_t length = 2; length <= 4; length++){
+
+			bitset<256> first_bytes;
+			for(int b = 0x80; b < 256; b++){
+				if(utf8_character_length(b) == length) first_bytes.set(b);
+			}
+
+			vector<string> excluded;
+			for(vector<string>::const_iterator i = characters.sequences.begin(); i != characters.sequences.end(); i++){
+				if(i->size() == length) excluded.push_back(*i);
+			}
+
+			result = alternative(result, sequences_except(first_bytes, excluded, 0, length));
+		}
+	}
+	else{
+		for(vector<string>::const_iterator i = characters.sequences.begin(); i != characters.sequences.end(); i++){
+			result = alternative(result, literal_fragment(*i));
+		}
+	}
+
+	return result;
+}
+
+//a fragment which reads the rest of a UTF-8 character of length bytes, from byte depth, which starts with one of first_bytes,
+//other than the excluded characters (which all start with the same depth bytes)
+RuleAutomaton::fragment RuleAutomaton::sequences_except(const bitset<256>& first_bytes, const vector<string>& excluded, size_t depth, size_t length){
+
+	bitset<256> continuation;
+	for(int b = 0x80; b < 0xC0; b++) continuation.set(b);
+
+	bitset<256> excluded_bytes;
+	for(vector<string>::const_iterator i = excluded.begin(); i != excluded.end(); i++){
+		excluded_bytes.set((unsigned char)(*i)[depth]);
+	}
+
+	//the bytes which no excluded character has here can be followed by any bytes
+	fragment result = byte_fragment(first_bytes & ~excluded_bytes);
+	for(size_t i = depth + 1; i < length; i++){
+		result = sequence(result, byte_fragment(continuation));
+	}
+
+	//the others can be followed by anything but the rest of the excluded characters
+	//(if this is the last byte, the characters with it are excluded)
+	if(depth + 1 < length){
+		for(int b = 0; b < 256; b++){
+			if(!excluded_bytes.test(b)) continue;
+
+			vector<string> rest;
+			for(vector<string>::const_iterator i = excluded.begin(); i != excluded.end(); i++){
+				if((unsigned char)(*i)[depth] == b) rest.push_back(*i);
+			}
+
+			bitset<256> byte;
+			byte.set(b);
+			result = alternative(result, sequence(byte_fragment(byte), sequences_except(continuation, rest, depth + 1, length)));
+		}
+	}
+
+	return result;
+}
+
+RuleAutomaton::fragment RuleAutomaton::sequence(fragment first, fragment second){
+	states[first.end].epsilon.push_back(second.start);
+
+	fragment result = {first.start, second.end};
+	return result;
+}
+
+RuleAutomaton::fragment RuleAutomaton::alternative(fragment first, fragment second){
+	fragment result;
+	result.start = new_state();
+	result.end = new_state();
+
+	states[result.start].epsilon.push_back(first.start);
+	states[result.start].epsilon.push_back(second.start);
+	states[first.end].epsilon.push_back(result.end);
+	states[second.end].epsilon.push_back(result.end);
+
+	return result;
+}
+
+//zero or more of the fragment
+RuleAutomaton::fragment RuleAutomaton::star(fragment repeated){
+	fragment result;
+	result.start = new_state();
+	result.end = new_state();
+
+	states[result.start].epsilon.push_back(repeated.start);
+	states[result.start].epsilon.push_back(result.end);
+	states[repeated.end].epsilon.push_back(repeated.start);
+	states[repeated.end].epsilon.push_back(result.end);
+
+	return result;
+}
+
+//zero or one of the fragment
+RuleAutomaton::fragment RuleAutomaton::optional(fragment optional){
+	fragment result;
+	result.start = new_state();
+	result.end = new_state();
+
+	states[result.start].epsilon.push_back(optional.start);
+	states[result.start].epsilon.push_back(result.end);
+	states[optional.end].epsilon.push_back(result.end);
+
+	return result;
+}
+
+//make the fragment a rule
+//from_start: it must match from the start of the name, to_end: it must match up to the end of the name
+void RuleAutomaton::add_rule(fragment rule, bool from_start, bool to_end){
+	states[from_start ? anchored_start : unanchored_start].epsilon.push_back(rule.start);
+	states[rule.end].accept = to_end ? ACCEPT_AT_END : ACCEPT_NOW;
+}
+
+
+void RuleAutomaton::add_substring(string_view substring){
+	add_rule(literal_fragment(substring), false, false);
+}
+
+void RuleAutomaton::add_extension(string_view extension){
+
+	//the extension is the text after the last separator, so an extension with a separator in it never matches
+	const string_view separators = "\\/.";
+	if(extension.find_first_of(separators) != string_view::npos) return;
+
+	bitset<256> separator;
+	for(string_view::iterator c = separators.begin(); c != separators.end(); c++){
+		separator.set((unsigned char)*c);
+	}
+
+	//either the whole name is the extension, or it ends with a separator followed by the extension
+	add_rule(literal_fragment(extension), true, true);
+	add_rule(sequence(byte_fragment(separator), literal_fragment(extension)), false, true);
+}
+
+bool RuleAutomaton::add_glob(string_view pattern, string& error){
+	Parser parser(*this, pattern);
+
+	if(!parser.parse_glob()){
+		error = parser.error;
+		return false;
+	}
+
+	return true;
+}
+
+bool RuleAutomaton::add_regex(string_view pattern, string& error){
+	Parser parser(*this, pattern);
+
+	if(!parser.parse_regex()){
+		error = parser.error;
+		return false;
+	}
+
+	return true;
+}
+
+
+//a glob matches the whole name
+bool RuleAutomaton::Parser::parse_glob(){
+
+	bitset<256> any, not_slash, slash;
+	any.set();
+	slash.set('/');
+	not_slash = ~slash;
+
+	fragment result = automaton.literal_fragment("");
+
+	while(position < pattern.size()){
+
+		fragment piece;
+
+		if(pattern.compare(position, 3, "**/") == 0){
+			//any number of directories, including none
+			position += 3;
+			piece = automaton.optional(automaton.sequence(automaton.star(automaton.byte_fragment(any)), automaton.byte_fragment(slash)));
+		}
+		else if(pattern.compare(position, 2, "**") == 0){
+			position += 2;
+			piece = automaton.star(automaton.byte_fragment(any));
+		}
+		else if(at('*')){
+			position++;
+			piece = automaton.star(automaton.byte_fragment(not_slash));
+		}
+		else if(at('?')){
+			position++;
+			piece = automaton.character_fragment(characters(not_slash, vector<string>(), false));
+		}
+		else if(at('[')){
+			char_set chars;
+			if(!parse_class(true, chars)) return false;
+			piece = automaton.character_fragment(chars);
+		}
+		else{
+			if(at('\\')){
+				position++;
+				if(position == pattern.size()) return fail("the pattern ends with \\");
+			}
+
+			const size_t length = character_length();
+			piece = automaton.literal_fragment(pattern.substr(position, length));
+			position += length;
+		}
+
+		result = automaton.sequence(result, piece);
+
+		if(too_large()) return false;
+	}
+
+	automaton.add_rule(result, true, true);
+	return true;
+}
+
+//a regex matches anywhere in the name, unless an alternative starts with ^ or ends with $
+bool RuleAutomaton::Parser::parse_regex(){
+
+	//the fragments and anchors for each of the top level alternatives, which are added as rules once they're all valid
+	vector<fragment> alternatives;
+	vector<pair<bool, bool> > anchors;
+
+	while(true){
+		const bool from_start = at('^');
+		if(from_start) position++;
+
+		fragment alternative;
+		bool to_end = false;
+		if(!parse_sequence(alternative, &to_end)) return false;
+
+		alternatives.push_back(alternative);
+		anchors.push_back(pair<bool, bool>(from_start, to_end));
+
+		if(!at('|')) break;
+		position++;
+	}
+
+	if(position < pattern.size()) return fail("there is a ) without a (");
+
+	for(size_t i = 0; i < alternatives.size(); i++){
+		automaton.add_rule(alternatives[i], anchors[i].first, anchors[i].second);
+	}
+
+	return true;
+}
+
+//parse items up to a | or ) or the end of the pattern
+//to_end is set if the sequence ends with $ (which is only allowed when to_end is given)
+bool RuleAutomaton::Parser::parse_sequence(fragment& result, bool* to_end){
+
+	result = automaton.literal_fragment("");
+
+	while((position < pattern.size()) && !at('|') && !at(')')){
+
+		if(at('$')){
+			const bool last = (position + 1 == pattern.size()) || (pattern[position + 1] == '|');
+			if((to_end == NULL) || !last){
+				return fail("$ is only supported at the end of the pattern or of an alternative");
+			}
+			position++;
+			*to_end = true;
+			break;
+		}
+
+		fragment piece;
+		if(!parse_repeat(piece)) return false;
+
+		result = automaton.sequence(result, piece);
+	}
+
+	return true;
+}
+
+//parse the alternatives inside a group
+bool RuleAutomaton::Parser::parse_alternatives(fragment& result){
+
+	if(!parse_sequence(result, NULL)) return false;
+
+	while(at('|')){
+		position++;
+
+		fragment other;
+		if(!parse_sequence(other, NULL)) return false;
+
+		result = automaton.alternative(result, other);
+	}
+
+	return true;
+}
+
+//parse an atom and the quantifier after it, if there is one
+bool RuleAutomaton::Parser::parse_repeat(fragment& result){
+
+	const size_t atom_start = position;
+	if(!parse_atom(result)) return false;
+
+	if(position == pattern.size()) return true;
+
+	unsigned minimum, maximum;
+	bool unbounded = false;
+
+	const char quantifier = pattern[position];
+	if(quantifier == '*'){
+		minimum = 0;
+		unbounded = true;
+	}
+	else if(quantifier == '+'){
+		minimum = 1;
+		unbounded = true;
+	}
+	else if(quantifier == '?'){
+		minimum = 0;
+		maximum = 1;
+	}
+	else if(quantifier == '{'){
+		position++;
+		if(!parse_bound(minimum)) return false;
+
+		maximum = minimum;
+		if(at(',')){
+			position++;
+			if(at('}')){
+				unbounded = true;
+			}
+			else if(!parse_bound(maximum)){
+				return false;
+			}
+		}
+
+		if(!at('}')) return fail("{ must be followed by {m}, {m,} or {m,n}");
+		if(!unbounded && (maximum < minimum)) return fail("the bounds of {m,n} are backwards");
+	}
+	else{
+		return true;
+	}
+
+	position++;
+
+	//whether the quantifier is lazy makes no difference to whether a name matches
+	if(at('?')) position++;
+
+	if(at('*') || at('+') || at('?') || at('{')) return fail("there is nothing to repeat");
+
+	const size_t after_quantifier = position;
+
+	//each repetition needs its own copy of the atom, so the atom is parsed again for each one
+	//a{m,n} is m copies followed by n - m optional copies, a{m,} is m copies followed by a starred copy
+	const unsigned copies_needed = unbounded ? (minimum + 1) : maximum;
+
+	vector<fragment> copies(1, result);
+	while(copies.size() < copies_needed){
+		position = atom_start;
+
+		fragment copy;
+		if(!parse_atom(copy)) return false;
+		copies.push_back(copy);
+
+		if(too_large()) return false;
+	}
+	position = after_quantifier;
+
+	result = automaton.literal_fragment("");
+	for(unsigned i = 0; i < copies_needed; i++){
+		if(unbounded && (i == minimum)){
+			result = automaton.sequence(result, automaton.star(copies[i]));
+		}
+		else if(i < minimum){
+			result = automaton.sequence(result, copies[i]);
+		}
+		else{
+			result = automaton.sequence(result, automaton.optional(copies[i]));
+		}
+	}
+
+	return true;
+}
+
+//parse a number in {m,n}
+bool RuleAutomaton::Parser::parse_bound(unsigned& bound){
+
+	if((position == pattern.size()) || !isdigit((unsigned char)pattern[position])){
+		return fail("{ must be followed by {m}, {m,} or {m,n}");
+	}
+
+	bound = 0;
+	while((position < pattern.size()) && isdigit((unsigned char)pattern[position])){
+		bound = bound * 10 + (pattern[position] - '0');
+		position++;
+
+		if(bound > MAX_REPEAT) return fail("repeat counts can be at most " + to_string(MAX_REPEAT));
+	}
+
+	return true;
+}
+
+//parse a single item: a character, a class, an escape or a group
+bool RuleAutomaton::Parser::parse_atom(fragment& result){
+
+	bitset<256> bytes;
+	const char c = pattern[position];
+
+	if(c == '('){
+		position++;
+
+		//non capturing groups are the same as groups, since nothing is captured
+		if(pattern.compare(position, 2, "?:") == 0){
+			position += 2;
+		}
+		else if(at('?')){
+			return fail("(? groups other than (?: are not supported");
+		}
+
+		if(!parse_alternatives(result)) return false;
+
+		if(!at(')')) return fail("the ( is never closed");
+		position++;
+	}
+	else if(c == '['){
+		char_set chars;
+		if(!parse_class(false, chars)) return false;
+		result = automaton.character_fragment(chars);
+	}
+	else if(c == '.'){
+		bytes.set();
+		bytes.reset('\n');
+		position++;
+		result = automaton.character_fragment(characters(bytes, vector<string>(), false));
+	}
+	else if(c == '\\'){
+		if(!parse_escape(bytes)) return false;
+		result = automaton.character_fragment(characters(bytes, vector<string>(), false));
+	}
+	else if((c == '*') || (c == '+') || (c == '?') || (c == '{')){
+		return fail("there is nothing to repeat");
+	}
+	else if(c == '^'){
+		return fail("^ is only supported at the start of the pattern or of an alternative");
+	}
+	else{
+		const size_t length = character_length();
+		result = automaton.literal_fragment(pattern.substr(position, length));
+		position += length;
+	}
+
+	return true;
+}
+
+//parse an escape (\d, \., \x41, etc.) into the bytes it matches
+bool RuleAutomaton::Parser::parse_escape(bitset<256>& bytes){
+
+	position++;
+	if(position == pattern.size()) return fail("the pattern ends with \\");
+
+	const char c = pattern[position++];
+
+	bytes.reset();
+	switch(c){
+		case 'd': case 'D':
+			for(int b = '0'; b <= '9'; b++) bytes.set(b);
+			break;
+		case 'w': case 'W':
+			for(int b = 0; b < 256; b++){
+				if(isalnum(b) || (b == '_')) bytes.set(b);
+			}
+			break;
+		case 's': case 'S':
+			bytes.set(' '); bytes.set('\t'); bytes.set('\n'); bytes.set('\r'); bytes.set('\f'); bytes.set('\v');
+			break;
+		case 'n': bytes.set('\n'); break;
+		case 't': bytes.set('\t'); break;
+		case 'r': bytes.set('\r'); break;
+		case 'f': bytes.set('\f'); break;
+		case 'v': bytes.set('\v'); break;
+		case 'x':{
+			if((position + 2 > pattern.size()) || !isxdigit((unsigned char)pattern[position]) || !isxdigit((unsigned char)pattern[position + 1])){
+				return fail("\\x must be followed by two hex digits");
+			}
+			bytes.set(stoi(string(pattern.substr(position, 2)), NULL, 16));
+			position += 2;
+			break;
+		}
+		default:
+			//escaped punctuation is literal, escaped letters and digits may mean something we don't support
+			if(isalnum((unsigned char)c)){
+				position--;
+				return fail(string("\\") + c + " is not supported");
+			}
+			bytes.set((unsigned char)c);
+	}
+
+	//the upper case classes are the opposite of the lower case ones
+	if((c == 'D') || (c == 'W') || (c == 'S')) bytes.flip();
+
+	return true;
+}
+
+//the characters of a set of bytes and of UTF-8 characters of several bytes (negated if negated)
+//a set of bytes with every byte which starts a character of several bytes (e.g. from [^...], \W or .)
+//has every character of several bytes instead, other than the sequences if the set is negated
+RuleAutomaton::char_set RuleAutomaton::Parser::characters(bitset<256> bytes, const vector<string>& sequences, bool negated){
+
+	if(negated) bytes.flip();
+
+	bitset<256> first_bytes;
+	for(int b = 0x80; b < 256; b++){
+		if(utf8_character_length(b) > 1) first_bytes.set(b);
+	}
+
+	char_set result;
+	result.other_sequences = ((bytes & first_bytes) == first_bytes);
+
+	if(result.other_sequences){
+		bytes &= ~first_bytes;
+		if(negated) result.sequences = sequences;
+	}
+	else if(!negated){
+		result.sequences = sequences;
+	}
+
+	result.bytes = bytes;
+	return result;
+}
+
+//parse a [...] class, where a leading ^ (or ! in a glob) negates it
+bool RuleAutomaton::Parser::parse_class(bool glob, char_set& chars){
+
+	const size_t class_start = position;
+	position++;
+
+	bool negated = false;
+	if(at('^') || (glob && at('!'))){
+		negated = true;
+		position++;
+	}
+
+	bitset<256> bytes;
+	vector<string> sequences;
+	bool first = true;
+
+	while(true){
+
+		if(position == pattern.size()){
+			position = class_start;
+			return fail("the [ is never closed");
+		}
+
+		//a ] first in the class is a ] in the class
+		if(at(']') && !first){
+			position++;
+			break;
+		}
+		first = false;
+
+		bitset<256> item;
+		string sequence;
+		if(!parse_class_item(glob, item, sequence)) return false;
+
+		//a range, unless the - is the last character of the class
+		if(at('-') && ((item.count() == 1) || !sequence.empty()) && (position + 1 < pattern.size()) && (pattern[position + 1] != ']')){
+			position++;
+
+			bitset<256> high_item;
+			string high_sequence;
+			if(!parse_class_item(glob, high_item, high_sequence)) return false;
+
+			if((high_item.count() != 1) && high_sequence.empty()) return fail("a range must end with a single character");
+
+			unsigned low = 0;
+			if(sequence.empty()){
+				while(!item.test(low)) low++;
+			}
+			else{
+				low = utf8_code_point(sequence);
+			}
+
+			unsigned high = 0;
+			if(high_sequence.empty()){
+				while(!high_item.test(high)) high++;
+			}
+			else{
+				high = utf8_code_point(high_sequence);
+			}
+
+			if(high < low) return fail("the range is backwards");
+
+			if(sequence.empty() && high_sequence.empty()){
+				for(unsigned b = low; b <= high; b++) item.set(b);
+			}
+			else{
+				//a range of characters, some of several bytes, e.g. [a-ÿ]
+				if(sequence.empty() && (low >= 0x80)) return fail("a range which ends with a character other than ASCII must start with a character");
+				if(high - low >= MAX_CHARACTER_RANGE) return fail("a range of characters other than ASCII can have at most " + to_string(MAX_CHARACTER_RANGE) + " characters");
+
+				item.reset();
+				sequence.clear();
+
+				for(unsigned code_point = low; code_point <= high; code_point++){
+					if(code_point < 0x80){
+						item.set(code_point);
+					}
+					else if((code_point < 0xD800) || (code_point > 0xDFFF)){
+						sequences.push_back(utf8_character(code_point));
+					}
+				}
+			}
+		}
+
+		bytes |= item;
+		if(!sequence.empty()) sequences.push_back(sequence);
+	}
+
+	chars = characters(bytes, sequences, negated);
+
+	return true;
+}
+
+//parse a character of a [...] class, or (in a regex) an escaped class, into the bytes it matches,
+//or into sequence if it's a UTF-8 character of several bytes
+bool RuleAutomaton::Parser::parse_class_item(bool glob, bitset<256>& item, string& sequence){
+
+	if(at('\\')){
+		if(!glob) return parse_escape(item);
+
+		position++;
+		if(position == pattern.size()) return fail("the pattern ends with \\");
+	}
+
+	const size_t length = character_length();
+	if(length > 1){
+		sequence = string(pattern.substr(position, length));
+	}
+	else{
+		item.set((unsigned char)pattern[position]);
+	}
+	position += length;
+
+	return true;
+}
+
+
+//add the states reached from the states in set without reading a byte, and sort it
+void RuleAutomaton::closure(vector<unsigned>& set, vector<unsigned>& marks, unsigned mark) const{
+
+	vector<unsigned> stack;
+	for(vector<unsigned>::iterator s = set.begin(); s != set.end(); s++){
+		if(marks[*s] != mark){
+			marks[*s] = mark;
+			stack.push_back(*s);
+		}
+	}
+
+	set.clear();
+	while(!stack.empty()){
+		const unsigned state = stack.back();
+		stack.pop_back();
+		set.push_back(state);
+
+		const vector<unsigned>& epsilon = states[state].epsilon;
+		for(vector<unsigned>::const_iterator t = epsilon.begin(); t != epsilon.end(); t++){
+			if(marks[*t] != mark){
+				marks[*t] = mark;
+				stack.push_back(*t);
+			}
+		}
+	}
+
+	std::sort(set.begin(), set.end());
+}
+
+//used to find sets of states which have already been made into DFA states
+struct state_set_hash{
+	size_t operator()(const vector<unsigned>& set) const{
+		return hash_bytes(string_view((const char*)set.data(), set.size() * sizeof(unsigned)));
+	}
+};
+
+bool RuleAutomaton::compile(rule_dfa& dfa, string& error, size_t max_states) const{
+
+	//split the bytes into classes, so that every byte set either has all of the bytes of a class or none of them
+	unsigned byte_class[256] = {0};
+	unsigned num_classes = 1;
+	for(vector<bitset<256> >::const_iterator set = byte_sets.begin(); set != byte_sets.end(); set++){
+
+		map<pair<unsigned, bool>, unsigned> split;
+		for(int b = 0; b < 256; b++){
+			const pair<unsigned, bool> key(byte_class[b], set->test(b));
+
+			map<pair<unsigned, bool>, unsigned>::iterator found = split.find(key);
+			if(found == split.end()){
+				found = split.insert(pair<pair<unsigned, bool>, unsigned>(key, split.size())).first;
+			}
+			byte_class[b] = found->second;
+		}
+		num_classes = split.size();
+	}
+
+	dfa.num_classes = num_classes;
+	for(int b = 0; b < 256; b++){
+		dfa.byte_class[b] = byte_class[b];
+	}
+
+	//includes[set * num_classes + class] is true iff the byte set has the bytes of the class
+	vector<char> includes(byte_sets.size() * num_classes, false);
+	for(size_t set = 0; set < byte_sets.size(); set++){
+		for(int b = 0; b < 256; b++){
+			if(byte_sets[set].test(b)) includes[set * num_classes + byte_class[b]] = true;
+		}
+	}
+
+	vector<unsigned> marks(states.size(), 0);
+	unsigned mark = 0;
+
+	//the unanchored start and the states it reaches without reading a byte are in every DFA state,
+	//so the states they move to are found once instead of for every DFA state
+	vector<unsigned> root(1, unanchored_start);
+	closure(root, marks, ++mark);
+
+	vector<char> in_root(states.size(), false);
+	for(vector<unsigned>::iterator s = root.begin(); s != root.end(); s++){
+		in_root[*s] = true;
+	}
+
+	vector<vector<unsigned> > root_moves(num_classes);
+	for(unsigned c = 0; c < num_classes; c++){
+		for(vector<unsigned>::iterator s = root.begin(); s != root.end(); s++){
+			for(vector<nfa_edge>::const_iterator e = states[*s].edges.begin(); e != states[*s].edges.end(); e++){
+				if(includes[e->byte_set * num_classes + c]) root_moves[c].push_back(e->target);
+			}
+		}
+		closure(root_moves[c], marks, ++mark);
+	}
+
+	//the subsets of the NFA states, in the order they became DFA states
+	vector<vector<unsigned> > subsets;
+	unordered_map<vector<unsigned>, unsigned, state_set_hash> subset_index;
+
+	vector<unsigned> start;
+	start.push_back(anchored_start);
+	start.push_back(unanchored_start);
+	closure(start, marks, ++mark);
+
+	subsets.push_back(start);
+	subset_index[start] = 0;
+
+	dfa.transitions.clear();
+	dfa.matches.clear();
+	dfa.matches_at_end.clear();
+
+	for(unsigned state = 0; state < subsets.size(); state++){
+
+		const vector<unsigned> subset = subsets[state]; //a copy, since subsets grows below
+
+		bool matches = false, matches_at_end = false;
+		for(vector<unsigned>::const_iterator s = subset.begin(); s != subset.end(); s++){
+			if(states[*s].accept == ACCEPT_NOW) matches = true;
+			if(states[*s].accept == ACCEPT_AT_END) matches_at_end = true;
+		}
+
+		dfa.matches.push_back(matches);
+		dfa.matches_at_end.push_back(matches_at_end);
+		dfa.transitions.resize(subsets.size() * num_classes, 0);
+
+		//once a rule has matched, nothing else needs to be read, so the state only leads back to itself
+		if(matches){
+			for(unsigned c = 0; c < num_classes; c++){
+				dfa.transitions[state * num_classes + c] = state;
+			}
+			continue;
+		}
+
+		for(unsigned c = 0; c < num_classes; c++){
+
+			vector<unsigned> next = root_moves[c];
+			for(vector<unsigned>::const_iterator s = subset.begin(); s != subset.end(); s++){
+				if(in_root[*s]) continue;
+
+				for(vector<nfa_edge>::const_iterator e = states[*s].edges.begin(); e != states[*s].edges.end(); e++){
+					if(includes[e->byte_set * num_classes + c]) next.push_back(e->target);
+				}
+			}
+			closure(next, marks, ++mark);
+
+			unordered_map<vector<unsigned>, unsigned, state_set_hash>::iterator found = subset_index.find(next);
+			if(found == subset_index.end()){
+				if(subsets.size() >= max_states){
+					error = "the rules are too complex to combine (they need more than " + to_string(max_states) + " states)";
+					return false;
+				}
+
+				found = subset_index.insert(pair<vector<unsigned>, unsigned>(next, subsets.size())).first;
+				subsets.push_back(next);
+				dfa.transitions.resize(subsets.size() * num_classes, 0);
+			}
+
+			dfa.transitions[state * num_classes + c] = found->second;
+		}
+	}
+
+	//a state is alive if a rule matches there, or if it leads to a state which is alive
+	//(the states which lead to each state are found first, then the alive states are spread back through them)
+	const unsigned num_states = subsets.size();
+	vector<vector<unsigned> > sources(num_states);
+	for(unsigned state = 0; state < num_states; state++){
+		for(unsigned c = 0; c < num_classes; c++){
+			sources[dfa.transitions[state * num_classes + c]].push_back(state);
+		}
+	}
+
+	dfa.dead.assign(num_states, true);
+	vector<unsigned> alive;
+	for(unsigned state = 0; state < num_states; state++){
+		if(dfa.matches[state] || dfa.matches_at_end[state]){
+			dfa.dead[state] = false;
+			alive.push_back(state);
+		}
+	}
+
+	while(!alive.empty()){
+		const unsigned state = alive.back();
+		alive.pop_back();
+
+		for(vector<unsigned>::iterator source = sources[state].begin(); source != sources[state].end(); source++){
+			if(dfa.dead[*source]){
+				dfa.dead[*source] = false;
+				alive.push_back(*source);
+			}
+		}
+	}
+
+	return true;
+}
+
+bool RuleAutomaton::matches(string_view name) const{
+
+	vector<unsigned> marks(states.size(), 0);
+	unsigned mark = 0;
+
+	vector<unsigned> current, next;
+	current.push_back(anchored_start);
+	current.push_back(unanchored_start);
+	closure(current, marks, ++mark);
+
+	for(string_view::iterator c = name.begin(); ; c++){
+
+		for(vector<unsigned>::iterator s = current.begin(); s != current.end(); s++){
+			if(states[*s].accept == ACCEPT_NOW) return true;
+			if((c == name.end()) && (states[*s].accept == ACCEPT_AT_END)) return true;
+		}
+
+		if(c == name.end()) return false;
+
+		next.clear();
+		for(vector<unsigned>::iterator s = current.begin(); s != current.end(); s++){
+			for(vector<nfa_edge>::const_iterator e = states[*s].edges.begin(); e != states[*s].edges.end(); e++){
+				if(byte_sets[e->byte_set].test((unsigned char)*c)) next.push_back(e->target);
+			}
+		}
+		closure(next, marks, ++mark);
+
+		current.swap(next);
+	}
+}
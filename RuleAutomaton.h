@@ -0,0 +1,124 @@
+/*
+
+RuleAutomaton.h
+
+RuleAutomaton is a class which combines rules for matching file names into a single deterministic automaton
+
+Each rule is added to a nondeterministic automaton, and compile() turns all of them into one DFA,
+so that checking a file name against every rule is a single pass over the name
+
+The kinds of rules are:
+ substrings		match names which contain the substring
+ extensions		match names whose text after the last '/', '\' or '.' is the extension
+ globs			match whole names, where * matches within a directory, ** matches across directories,
+			** followed by / matches any number of directories, ? matches a character other than '/'
+			and [...] or [!...] matches a (negated) set of characters
+ regexes		match names which contain a match of the regular expression
+			(. [...] [^...] \d \w \s * + ? {m,n} | ( ) (?: ), with ^ and $ at the start and end of alternatives)
+
+The names are UTF-8, so a character other than ASCII is several bytes, and ?, ., [...] and the characters
+of a pattern each match a whole character rather than a byte of one
+
+*/
+
+#ifndef _RULEAUTOMATON_H_
+#define _RULEAUTOMATON_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <bitset>
+#include <unordered_map>
+using std::string;
+using std::string_view;
+using std::vector;
+using std::bitset;
+using std::unordered_map;
+
+
+const size_t MAX_DFA_STATES = 100000; //the most states compile() makes unless it's given another limit
+
+
+//the compiled automaton
+struct rule_dfa{
+	unsigned char byte_class[256]; //bytes which every rule treats the same share a class, to keep the table small
+	unsigned num_classes;
+	vector<unsigned> transitions; //state * num_classes + class -> next state, the start state is 0
+	vector<char> matches; //matches[state] is true iff a rule has matched on reaching state, whatever follows
+	vector<char> matches_at_end; //matches_at_end[state] is true iff a rule matches if the name ends at state
+	vector<char> dead; //dead[state] is true iff no rule can match on reaching state, whatever follows
+};
+
+
+class RuleAutomaton{
+
+	//what a state of the nondeterministic automaton accepts
+	enum accept_kind {ACCEPT_NONE = 0, ACCEPT_NOW, ACCEPT_AT_END};
+
+	struct nfa_edge{
+		unsigned byte_set; //index into byte_sets of the bytes which follow the edge
+		unsigned target;
+	};
+
+	struct nfa_state{
+		vector<nfa_edge> edges;
+		vector<unsigned> epsilon; //states reached without reading a byte
+		accept_kind accept;
+	};
+
+	//a piece of the automaton with one way in and one way out
+	struct fragment{
+		unsigned start;
+		unsigned end;
+	};
+
+	//a set of characters, where the characters other than ASCII are UTF-8 sequences of 2 to 4 bytes
+	struct char_set{
+		bitset<256> bytes; //the characters of one byte (and bytes which aren't part of a UTF-8 character)
+		vector<string> sequences; //the characters of several bytes which are in the set, or if other_sequences, which aren't
+		bool other_sequences; //whether the set has every character of several bytes other than the sequences
+	};
+
+	vector<nfa_state> states;
+	vector<bitset<256> > byte_sets; //the sets of bytes which the edges read
+	unordered_map<bitset<256>, unsigned> byte_set_index; //byte set -> index in byte_sets, so each set is only stored once
+	unsigned anchored_start; //rules which must match from the start of the name begin here
+	unsigned unanchored_start; //rules which may match anywhere begin here, it loops on every byte
+
+	unsigned new_state();
+	unsigned add_byte_set(const bitset<256>& bytes);
+	fragment byte_fragment(const bitset<256>& bytes);
+	fragment literal_fragment(string_view text);
+	fragment character_fragment(const char_set& characters);
+	fragment sequences_except(const bitset<256>& first_bytes, const vector<string>& excluded, size_t depth, size_t length);
+	fragment sequence(fragment first, fragment second);
+	fragment alternative(fragment first, fragment second);
+	fragment star(fragment repeated);
+	fragment optional(fragment optional);
+	void add_rule(fragment rule, bool from_start, bool to_end);
+
+	//parsers for globs and regexes, these set error and return false if the pattern is not valid
+	class Parser;
+	friend class Parser;
+
+	void closure(vector<unsigned>& set, vector<unsigned>& marks, unsigned mark) const;
+
+public:
+	RuleAutomaton();
+
+	void add_substring(string_view substring);
+	void add_extension(string_view extension);
+	bool add_glob(string_view pattern, string& error);
+	bool add_regex(string_view pattern, string& error);
+
+	//build the DFA for the rules added so far
+	//returns false (and sets error) if it would have more than max_states states
+	bool compile(rule_dfa& dfa, string& error, size_t max_states = MAX_DFA_STATES) const;
+
+	//returns true iff a rule matches the name, found by following every state of the nondeterministic automaton at once
+	//this is much slower than the DFA, it's for rules whose DFA would have too many states
+	bool matches(string_view name) const;
+};
+
+
+#endif
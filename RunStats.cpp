@@ -0,0 +1,244 @@
+//RunStats.cpp
+//Implementation of RunStats class
+
+#include "RunStats.h"
+#include "MemoryCounter.h"
+
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using std::ostringstream;
+
+
+report_stats::report_stats(){
+	cached = false;
+	readable = true;
+	bytes = lines = valid_lines = not_world_writable = ignored = duplicates = WWFs = critical = 0;
+	ignore_checks = ignore_hits = critical_checks = critical_hits = 0;
+	ignore_cache_hits = ignore_decided = critical_cache_hits = critical_decided = 0;
+	analyze_seconds = analyze_cpu_seconds = write_seconds = 0;
+	threads = 1;
+	allocations = 0;
+}
+
+//add the counts and times of other to these
+void report_stats::add(const report_stats& other){
+	bytes += other.bytes;
+	lines += other.lines;
+	valid_lines += other.valid_lines;
+	not_world_writable += other.not_world_writable;
+	ignored += other.ignored;
+	duplicates += other.duplicates;
+	WWFs += other.WWFs;
+	critical += other.critical;
+	ignore_checks += other.ignore_checks;
+	ignore_hits += other.ignore_hits;
+	critical_checks += other.critical_checks;
+	critical_hits += other.critical_hits;
+	ignore_cache_hits += other.ignore_cache_hits;
+	ignore_decided += other.ignore_decided;
+	critical_cache_hits += other.critical_cache_hits;
+	critical_decided += other.critical_decided;
+	analyze_seconds += other.analyze_seconds;
+	analyze_cpu_seconds += other.analyze_cpu_seconds;
+	write_seconds += other.write_seconds;
+	allocations += other.allocations;
+}
+
+
+StageTimer::StageTimer(){
+	wall_start = std::chrono::steady_clock::now();
+	cpu_start = process_cpu_seconds();
+}
+
+void StageTimer::stop(stage_time& time) const{
+	time.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+	time.cpu_seconds = process_cpu_seconds() - cpu_start;
+}
+
+
+RunStats::RunStats(){
+	workers = 1;
+	scan.wall_seconds = scan.cpu_seconds = 0;
+	analyze = summarize = write = scan;
+}
+
+//quote and escape a string for JSON
+static string json_string(const string& str){
+
+	ostringstream quoted;
+	quoted << '"';
+
+	for(string::const_iterator c = str.begin(); c != str.end(); c++){
+		if((*c == '"') || (*c == '\\')){
+			quoted << '\\' << *c;
+		}
+		else if((unsigned char)*c < 0x20){
+			quoted << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)(unsigned char)*c << std::dec;
+		}
+		else{
+			quoted << *c;
+		}
+	}
+
+	quoted << '"';
+	return quoted.str();
+}
+
+//the fraction of checks which were hits, 0 if there were no checks
+static double hit_rate(unsigned long long hits, unsigned long long checks){
+	return (checks > 0) ? ((double)hits / checks) : 0;
+}
+
+static void write_stage(ostringstream& json, const char* name, const stage_time& time){
+	json << "\t\t\"" << name << "\": {\"wall_seconds\": " << time.wall_seconds << ", \"cpu_seconds\": " << time.cpu_seconds << "}";
+}
+
+//the counts of a report, or the totals over all of the reports, as JSON members
+static void write_counts(ostringstream& json, const report_stats& stats, const char* indent){
+	json << indent << "\"bytes\": " << stats.bytes << ",\n"
+		<< indent << "\"lines\": " << stats.lines << ",\n"
+		<< indent << "\"valid_lines\": " << stats.valid_lines << ",\n"
+		<< indent << "\"invalid_lines\": " << (stats.lines - stats.valid_lines) << ",\n"
+		<< indent << "\"not_world_writable\": " << stats.not_world_writable << ",\n"
+		<< indent << "\"ignored\": " << stats.ignored << ",\n"
+		<< indent << "\"duplicates\": " << stats.duplicates << ",\n"
+		<< indent << "\"wwfs\": " << stats.WWFs << ",\n"
+		<< indent << "\"critical\": " << stats.critical << ",\n"
+		<< indent << "\"ignore_checks\": " << stats.ignore_checks << ",\n"
+		<< indent << "\"ignore_hit_rate\": " << hit_rate(stats.ignore_hits, stats.ignore_checks) << ",\n"
+		<< indent << "\"ignore_directory_cache_hit_rate\": " << hit_rate(stats.ignore_cache_hits, stats.ignore_checks) << ",\n"
+		<< indent << "\"ignore_decided_by_directory\": " << stats.ignore_decided << ",\n"
+		<< indent << "\"critical_checks\": " << stats.critical_checks << ",\n"
+		<< indent << "\"critical_hit_rate\": " << hit_rate(stats.critical_hits, stats.critical_checks) << ",\n"
+		<< indent << "\"critical_directory_cache_hit_rate\": " << hit_rate(stats.critical_cache_hits, stats.critical_checks) << ",\n"
+		<< indent << "\"critical_decided_by_directory\": " << stats.critical_decided << ",\n"
+		<< indent << "\"analyze_seconds\": " << stats.analyze_seconds << ",\n"
+		<< indent << "\"analyze_cpu_seconds\": " << stats.analyze_cpu_seconds << ",\n"
+		<< indent << "\"write_seconds\": " << stats.write_seconds << ",\n"
+		<< indent << "\"allocations\": " << stats.allocations;
+}
+
+string RunStats::to_json() const{
+
+	//sum the reports
+	report_stats totals;
+	unsigned long cached = 0, unreadable = 0;
+	for(vector<report_stats>::const_iterator i = reports.begin(); i != reports.end(); i++){
+		totals.add(*i);
+
+		if(i->cached) cached++;
+		if(!i->readable) unreadable++;
+	}
+
+	const memory_counts memory = get_memory_counts();
+	const double wall_seconds = scan.wall_seconds + analyze.wall_seconds + summarize.wall_seconds + write.wall_seconds;
+
+	ostringstream json;
+	json << std::fixed << std::setprecision(6);
+
+	json << "{\n"
+		<< "\t\"version\": 1,\n"
+		<< "\t\"workers\": " << workers << ",\n"
+		<< "\t\"reports\": " << reports.size() << ",\n"
+		<< "\t\"cached_reports\": " << cached << ",\n"
+		<< "\t\"unreadable_reports\": " << unreadable << ",\n"
+		<< "\t\"wall_seconds\": " << wall_seconds << ",\n"
+		<< "\t\"cpu_seconds\": " << process_cpu_seconds() << ",\n"
+		<< "\t\"stages\": {\n";
+	write_stage(json, "scan", scan);
+	json << ",\n";
+	write_stage(json, "analyze", analyze);
+	json << ",\n";
+	write_stage(json, "summarize", summarize);
+	json << ",\n";
+	write_stage(json, "write", write);
+	json << "\n\t},\n"
+		<< "\t\"memory\": {\"allocations\": " << memory.allocations << ", \"peak_bytes\": " << memory.peak_bytes
+		<< ", \"peak_rss_kb\": " << peak_rss_kb() << "},\n"
+		<< "\t\"totals\": {\n";
+	write_counts(json, totals, "\t\t");
+	json << "\n\t},\n"
+		<< "\t\"servers\": [";
+
+	for(vector<report_stats>::const_iterator i = reports.begin(); i != reports.end(); i++){
+		json << ((i == reports.begin()) ? "\n" : ",\n")
+			<< "\t\t{\n"
+			<< "\t\t\t\"server\": " << json_string(i->server_name) << ",\n"
+			<< "\t\t\t\"file\": " << json_string(i->file_name) << ",\n"
+			<< "\t\t\t\"format\": " << json_string(i->format) << ",\n"
+			<< "\t\t\t\"encoding\": " << json_string(i->encoding) << ",\n"
+			<< "\t\t\t\"cached\": " << (i->cached ? "true" : "false") << ",\n"
+			<< "\t\t\t\"readable\": " << (i->readable ? "true" : "false") << ",\n"
+			<< "\t\t\t\"threads\": " << i->threads << ",\n";
+		write_counts(json, *i, "\t\t\t");
+		json << "\n\t\t}";
+	}
+
+	json << "\n\t]\n"
+		<< "}\n";
+
+	return json.str();
+}
+
+
+#ifdef _WIN32
+
+//the sum of the kernel and user times, in seconds
+static double cpu_seconds(const FILETIME& kernel, const FILETIME& user){
+	const unsigned long long kernel_time = ((unsigned long long)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+	const unsigned long long user_time = ((unsigned long long)user.dwHighDateTime << 32) | user.dwLowDateTime;
+	return (kernel_time + user_time) / 1e7; //in units of 100 nanoseconds
+}
+
+double process_cpu_seconds(){
+	FILETIME creation, exit, kernel, user;
+	if(!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0;
+	return cpu_seconds(kernel, user);
+}
+
+double thread_cpu_seconds(){
+	FILETIME creation, exit, kernel, user;
+	if(!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0;
+	return cpu_seconds(kernel, user);
+}
+
+unsigned long long peak_rss_kb(){
+	PROCESS_MEMORY_COUNTERS counters;
+	if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.PeakWorkingSetSize / 1024;
+}
+
+#else
+
+double process_cpu_seconds(){
+	struct timespec time;
+	if(clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0) return 0;
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+double thread_cpu_seconds(){
+	struct timespec time;
+	if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) return 0;
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+unsigned long long peak_rss_kb(){
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024; //bytes on macOS
+#else
+	return usage.ru_maxrss; //KB on Linux
+#endif
+}
+
+#endif
@@ -0,0 +1,98 @@
+/*
+
+RunStats.h
+
+RunStats is a class which collects statistics about a run of WWF Analyzer:
+the time taken by each stage, and what was read and found in each report
+
+The statistics are written as JSON next to the summary report, so that runs can be compared
+
+*/
+
+#ifndef _RUNSTATS_H_
+#define _RUNSTATS_H_
+
+#include <string>
+#include <vector>
+#include <chrono>
+using std::string;
+using std::vector;
+
+
+//what was read and found in a report, and how long it took
+struct report_stats{
+	string server_name;
+	string file_name;
+	string format; //the format that the report was read as, empty if it wasn't read
+	string encoding; //the text encoding of the report, e.g. UTF-16LE, empty if it wasn't read
+	bool cached; //true iff the results were loaded from the cache instead of analyzing the report
+	bool readable; //false iff the report could not be analyzed
+
+	unsigned long long bytes; //the size of the report
+	unsigned long long lines; //the number of lines read
+	unsigned long long valid_lines; //lines which describe a file
+	unsigned long long not_world_writable; //valid lines for files which are not world writable
+	unsigned long long ignored; //world writable files which are ignored by the preferences
+	unsigned long long duplicates; //world writable files which had already been counted, when duplicates are collapsed
+	unsigned long long WWFs;
+	unsigned long long critical;
+
+	//the calls to FileClassifier::satisfies() and how many of them returned true
+	unsigned long long ignore_checks, ignore_hits;
+	unsigned long long critical_checks, critical_hits;
+
+	//of those, the files whose directory was found in the ClassificationCache, and those decided by their directory alone
+	unsigned long long ignore_cache_hits, ignore_decided;
+	unsigned long long critical_cache_hits, critical_decided;
+
+	double analyze_seconds; //wall time to analyze the report (or load it from the cache)
+	double analyze_cpu_seconds; //CPU time of the threads which analyzed the report
+	unsigned threads; //the number of threads which analyzed the report (more than 1 if it was split into chunks)
+	double write_seconds; //wall time to format the details report
+	unsigned long long allocations; //the allocations made while analyzing the report
+
+	report_stats();
+
+	//add the counts and times of other to these, e.g. to total the reports or the chunks of a report
+	void add(const report_stats& other);
+};
+
+//the time taken by a stage of the run
+struct stage_time{
+	double wall_seconds;
+	double cpu_seconds; //CPU time of the whole process, so it includes all of the workers
+};
+
+//measures the wall and CPU time from its creation to stop()
+class StageTimer{
+
+	std::chrono::steady_clock::time_point wall_start;
+	double cpu_start;
+
+public:
+	StageTimer();
+	void stop(stage_time& time) const;
+};
+
+class RunStats{
+
+public:
+	unsigned workers;
+	stage_time scan; //finding the reports
+	stage_time analyze; //analyzing the reports and merging the results
+	stage_time summarize; //formatting the summary report
+	stage_time write; //waiting for the reports to be written
+	vector<report_stats> reports; //in directory order
+
+	RunStats();
+
+	//the statistics as a JSON object
+	string to_json() const;
+};
+
+double process_cpu_seconds(); //the CPU time used by the process so far
+double thread_cpu_seconds(); //the CPU time used by the calling thread so far
+unsigned long long peak_rss_kb(); //the peak resident set size of the process in KB, or 0 if it can't be found
+
+
+#endif
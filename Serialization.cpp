@@ -0,0 +1,61 @@
+//Serialization.cpp
+//Implementation of the serialization functions and Deserializer class
+
+#include "Serialization.h"
+
+
+void write_number(string& bytes, unsigned long long number){
+	for(int i = 0; i < 8; i++){
+		bytes += (char)(unsigned char)(number >> (8 * i));
+	}
+}
+
+void write_string(string& bytes, string_view str){
+	write_number(bytes, str.size());
+	bytes.append(str.data(), str.size());
+}
+
+
+Deserializer::Deserializer(string_view bytes){
+	position = bytes.data();
+	end = bytes.data() + bytes.size();
+	ok = true;
+}
+
+unsigned long long Deserializer::read_number(){
+
+	string_view bytes = read_bytes(8);
+	if(bytes.empty()) return 0;
+
+	unsigned long long number = 0;
+	for(int i = 0; i < 8; i++){
+		number |= (unsigned long long)(unsigned char)bytes[i] << (8 * i);
+	}
+
+	return number;
+}
+
+string_view Deserializer::read_string(){
+	return read_bytes(read_number());
+}
+
+string_view Deserializer::read_bytes(size_t length){
+
+	if(!ok || (length > (size_t)(end - position))){
+		ok = false;
+		return string_view();
+	}
+
+	string_view bytes(position, length);
+	position += length;
+
+	return bytes;
+}
+
+bool Deserializer::good() const{
+	return ok;
+}
+
+bool Deserializer::at_end() const{
+	return (position == end);
+}
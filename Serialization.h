@@ -0,0 +1,46 @@
+/*
+
+Serialization.h
+
+Functions for storing analysis results as bytes, e.g. in the cache file
+
+Numbers are stored as 8 little endian bytes and strings as their length followed by their characters,
+so the bytes mean the same thing on every machine
+
+*/
+
+#ifndef _SERIALIZATION_H_
+#define _SERIALIZATION_H_
+
+#include <string>
+#include <string_view>
+using std::string;
+using std::string_view;
+
+
+//append a number/string to the bytes
+void write_number(string& bytes, unsigned long long number);
+void write_string(string& bytes, string_view str);
+
+
+//reads numbers and strings back from bytes in the order they were written
+//if the bytes run out, good() becomes false and everything read after that is 0 or empty
+class Deserializer{
+
+	const char* position;
+	const char* end;
+	bool ok;
+
+public:
+	Deserializer(string_view bytes);
+
+	unsigned long long read_number();
+	string_view read_string(); //a view into the bytes
+	string_view read_bytes(size_t length); //a view into the bytes
+
+	bool good() const; //returns true iff everything so far has been read successfully
+	bool at_end() const; //returns true iff all of the bytes have been read
+};
+
+
+#endif
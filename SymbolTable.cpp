@@ -0,0 +1,38 @@
+//SymbolTable.cpp
+//Implementation of SymbolTable class
+
+#include "SymbolTable.h"
+
+
+//names are short, so they're stored in small blocks
+SymbolTable::SymbolTable() : bytes(4096){
+}
+
+symbol SymbolTable::intern(string_view name){
+
+	unordered_map<string_view, symbol>::iterator i = ids.find(name);
+	if(i != ids.end()) return i->second;
+
+	const symbol id = names.size();
+	names.push_back(bytes.store(name));
+	ids[names.back()] = id;
+
+	return id;
+}
+
+bool SymbolTable::find(string_view name, symbol& id) const{
+
+	unordered_map<string_view, symbol>::const_iterator i = ids.find(name);
+	if(i == ids.end()) return false;
+
+	id = i->second;
+	return true;
+}
+
+string_view SymbolTable::name(symbol id) const{
+	return names[id];
+}
+
+unsigned SymbolTable::size() const{
+	return names.size();
+}
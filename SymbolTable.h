@@ -0,0 +1,48 @@
+/*
+
+SymbolTable.h
+
+SymbolTable is a class which interns names (e.g. of owners or servers) to compact integer IDs
+
+Each distinct name is stored once, in an arena, and everything else refers to it by its ID
+
+*/
+
+#ifndef _SYMBOLTABLE_H_
+#define _SYMBOLTABLE_H_
+
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include "Arena.h"
+using std::string_view;
+using std::vector;
+using std::unordered_map;
+
+typedef unsigned symbol; //the ID of an interned name
+
+
+class SymbolTable{
+
+	Arena bytes; //the characters of the names
+	vector<string_view> names; //the ID of a name is its index
+	unordered_map<string_view, symbol> ids;
+
+public:
+	SymbolTable();
+
+	//return the ID for the name, adding it if it has not been seen before
+	symbol intern(string_view name);
+
+	//find the ID for a name which may not have been interned
+	//returns false iff the name has not been interned
+	bool find(string_view name, symbol& id) const;
+
+	//the name for the ID, which stays valid for the life of the table
+	string_view name(symbol id) const;
+
+	unsigned size() const;
+};
+
+
+#endif
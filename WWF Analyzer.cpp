@@ -5,32 +5,141 @@ By: Kevin McNee
 
 This program analyzes world writable files reports and summarizes the results.
 
+Build it with all of its sources (every .cpp file but WWF Benchmark.cpp and WWF Report Generator.cpp), e.g.:
+g++ -std=c++17 -O2 -pthread "WWF Analyzer.cpp" ApproximateSummary.cpp Arena.cpp ClassificationCache.cpp CountMinSketch.cpp CriticalFiles.cpp
+	DirectoryIndex.cpp DirectoryScanner.cpp Encoding.cpp FileClassifier.cpp FingerprintSet.cpp Hash.cpp HeavyHitters.cpp HyperLogLog.cpp
+	MappedFile.cpp MemoryCounter.cpp PartialResults.cpp QueryServer.cpp ReportAnalysis.cpp ReportCache.cpp ReportParser.cpp ReportWatcher.cpp
+	ReportWriter.cpp ResultsExporter.cpp RuleAutomaton.cpp RunStats.cpp Serialization.cpp SymbolTable.cpp WWFStore.cpp "data structs.cpp" -o "WWF Analyzer"
+(-pthread is needed on Linux, and with MinGW on Windows -lpsapi is needed too)
+
+Usage:
+WWF Analyzer [options]
+	--input <directory>	the directory containing the reports (asked for if not given)
+	--output <directory>	where to create the details and summary reports (default: the input directory)
+	--prefs <file>		the preferences file (default: "WWF Analyzer.pref" in the current directory)
+	--recursive		also analyze the reports in subdirectories of the input directory
+	--no-prompt		never wait for the user, for running from scripts (--input must be given)
+	-j <n>, --workers <n>	the number of reports to analyze at the same time (a large report is split among them)
+	--cache, --no-cache	whether to reuse the results for reports which haven't changed
+	--memory-budget <MB>	the most memory for the critical files of each report, the rest are spilled to disk
+	--export <csv|jsonl>	also export the results as CSV or JSON Lines files for other tools to load
+	--approximate <MB>	summarize in about this much memory, with estimated counts, when there are too many owner/server pairs
+	--dedup <none|server|all>	count a file which is in several reports (or twice in one) once for each server,
+				or once for all of them if it's on a shared mount (see DEDUP in the preferences file)
+	--watch			after the analysis, keep watching the input directory and analyze each report as it's written,
+				keeping the summary report up to date until stopped (replaced or removed reports are taken out)
+	--partial <file>	save the results to a partial results file instead of making the summary report
+	--reduce <file>		merge the results in a partial results file instead of analyzing reports,
+				given once for each file, the merged results are summarized (or saved with --partial)
+	--serve <socket>	keep the merged results of the --reduce files in memory and answer queries about them
+				on a local socket, reloading them whenever the files change (not on Windows)
+	--query <socket> <query>...	send a query to a server started with --serve and print the answer,
+				e.g. servers <owner>, owners <server>, critical <server> [<owner>] or totals
+
+A report may be the output of ls -l, find -printf '%M %u %p\n' or stat -c '%a %U %n' for each file,
+which is detected from its first lines. It may be ASCII, UTF-8 or UTF-16 (as saved by PowerShell),
+which is detected from its byte order mark or first bytes.
+
+Partial results let the reports be analyzed on the machines where they are made (--input with --partial),
+and only the results be sent to be summarized (--reduce with each file), e.g.
+	WWF Analyzer --no-prompt --input reports --partial east.wwfp
+	WWF Analyzer --no-prompt --reduce east.wwfp --reduce west.wwfp --output summary
+
+Reports which arrive through the night can be analyzed as they land, so the summary is ready when the last one is, e.g.
+	WWF Analyzer --input /share/reports --watch
+
+The merged results can also be kept in memory by a server, to answer questions without rerunning anything, e.g.
+	WWF Analyzer --serve /var/run/wwf.sock --reduce east.wwfp --reduce west.wwfp
+	WWF Analyzer --query /var/run/wwf.sock critical server01 alice
+
 */
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <cstdlib>
 #include <cctype>
 #include <limits>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <list>
+#include <map>
+#include <set>
 #include <iterator>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <chrono>
 #include "data structs.h"
 #include "FileClassifier.h"
+#include "WWFStore.h"
+#include "BoundedHeap.h"
+#include "CriticalFiles.h"
+#include "MemoryCounter.h"
+#include "ReportAnalysis.h"
+#include "ReportCache.h"
+#include "PartialResults.h"
+#include "ResultsExporter.h"
+#include "QueryServer.h"
+#include "DirectoryIndex.h"
+#include "ClassificationCache.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "ReportParser.h"
+#include "DirectoryScanner.h"
+#include "ReportWatcher.h"
+#include "ApproximateSummary.h"
+#include "FingerprintSet.h"
+#include "Encoding.h"
+#include "ReportWriter.h"
+#include "RunStats.h"
 using namespace std;
 
 void pause(void);
 string trim(const string str);
-unsigned long analyze(ifstream& file, string directory, string server_name, list<WWF_data>& lst_WWF);
-void summarize(ofstream& report, list<WWF_data>& lst_WWF);
+unsigned long analyze(string_view contents, ReportAnalysis& analysis, report_stats& stats, unsigned threads, const string& spill_directory);
+void analyze_chunk(string_view contents, report_format format, ReportAnalysis& analysis, report_stats& stats, FingerprintSet* seen, vector<string_view>* counted_directories);
+template<class Format> void analyze_lines(string_view contents, ReportAnalysis& analysis, report_stats& stats, FingerprintSet* seen, vector<string_view>* counted_directories);
+fingerprint path_fingerprint(const string& server_name, string_view file_name);
+unsigned long collapse_duplicates(ReportAnalysis& analysis, FingerprintSet& counted, report_stats& stats, const vector<string_view>* counted_directories);
+void write_details_report(string file_name, const ReportAnalysis& analysis, ReportWriter& writer);
+void summarize(ReportBuffer& report, const WWFStore& store, const vector<directory_count>& directories);
+void summarize_approximate(ReportBuffer& report, const ApproximateSummary& summary, const vector<directory_count>& directories);
+void summarize_directories(ReportBuffer& report, const vector<directory_count>& directories);
+string estimated(const estimated_count& count);
+void keep_top_directories(vector<directory_count>& directories);
 string get_server_name(string file_name);
-bool set_prefs(void);
+size_t max_directories();
+unsigned long analysis_max_critical();
+void add_top_directories(const ReportAnalysis& analysis, vector<directory_count>& directories);
+//what happened when loading the preferences file
+enum prefs_result {PREFS_LOADED, PREFS_CREATED, PREFS_INVALID};
+prefs_result set_prefs(string pref_file);
+void analyze_reports(string directory, string output_directory, const vector<report_file>& reports, ReportCache* cache, ReportWriter& writer, WWFStore& store, vector<directory_count>& directories, vector<report_stats>& stats, PartialResults* partial, ResultsExporter* exporter, map<string, unique_ptr<report_contribution> >* contributions, ApproximateSummary* approximate);
+bool find_reports(string directory, vector<report_file>& reports);
+bool watch_reports(string directory, string output_directory, ReportCache* cache, ReportWriter& writer, WWFStore& store, map<string, unique_ptr<report_contribution> >& contributions);
+bool parse_export_format(const string& name, export_format& format);
+//which files are counted once when they're found more than once
+enum dedup_scope {DEDUP_NONE, DEDUP_SERVER, DEDUP_ALL};
+bool parse_dedup_scope(const string& name, dedup_scope& scope);
 
 const int COL_WIDTH = 16; //the width of the columns in the reports
 
+const size_t MIN_CHUNK_BYTES = 32 * 1024 * 1024; //a report is only split into chunks to analyze in parallel if they'd be at least this big
+
+//when watching, the summary report is rewritten once no report has been written for SUMMARY_DELAY_SECONDS,
+//but no later than SUMMARY_MAX_DELAY_SECONDS after the first report since it was last written, so a steady stream of reports doesn't hold it up
+const int SUMMARY_DELAY_SECONDS = 5;
+const int SUMMARY_MAX_DELAY_SECONDS = 60;
+
 //user preferences
 //summary report max items to show (default is unlimited)
 static int SUMMARY_SERVERS = numeric_limits<int>::max(); //max number of servers to show
@@ -39,111 +148,480 @@ static int HIGH_VOLUME = numeric_limits<int>::max(); //max number of the highest
 
 static unsigned long MAX_CRITICAL = numeric_limits<unsigned long>::max(); //max number of critical files to show (default is unlimited)
 
+static int TOP_DIRECTORIES = 10; //max number of directories to show in the summary and details reports
+static int DIRECTORY_DEPTH = 3; //the number of path components of the directories shown, deeper directories are counted in these (0 for whole paths)
+
+static size_t MEMORY_BUDGET = numeric_limits<size_t>::max(); //bytes of critical files to hold for a report before spilling them to disk (default is unlimited)
+
+static size_t APPROXIMATE_MEMORY = 0; //bytes to make an approximate summary in (default is 0, for an exact summary)
+
+static dedup_scope DEDUP = DEDUP_NONE; //which duplicate files are counted once (default is none, every line is counted)
+static vector<pair<string, string> > SHARED_MOUNTS; //the directory where a shared file system is mounted -> its name, for DEDUP=all
+
 static FileClassifier ignore_files_classifier;
 static FileClassifier critical_files_classifier;
 
+static int WORKERS = 1; //number of reports to analyze at the same time (0 to use one per processor)
+
+static export_format EXPORT = EXPORT_NONE; //the format to export the results in, if any
+
+static bool CACHE = false; //whether to keep the results for each report in a cache file, so that unchanged reports aren't reanalyzed
+
+const string CACHE_FILE_NAME = "WWF Analyzer.cache"; //the name of the cache file, in the output directory (which is the directory with the reports unless --output is given)
+
+const string STATS_FILE_NAME = "WWF Summary Report.json"; //the name of the file with the statistics of the run, next to the summary report
+
+static bool PROMPT = true; //whether to wait for the user, false when run from scripts
+static bool RECURSIVE = false; //whether to analyze the reports in subdirectories too
+
+static mutex console_mutex; //held while writing to the console, so that output from different workers is not interleaved
+
+
+int main(int argc, char* argv[]){
+
+	string directory; //the directory where the files are located
+	string output_directory; //the directory where the reports are created
+	string pref_file = "WWF Analyzer.pref";
+
+	int workers = -1; //the number of workers given on the command line, if any
+	int use_cache = -1; //whether to use the cache as given on the command line, if it is
+	long memory_budget = -1; //the memory budget in MB given on the command line, if any
+	long approximate_memory = -1; //the memory for an approximate summary in MB given on the command line, if any
+	string export_name; //the export format given on the command line, if any
+	string dedup_name; //the dedup scope given on the command line, if any
+
+	string partial_file; //the partial results file to save the results to, if any
+	vector<string> reduce_files; //the partial results files to merge instead of analyzing reports
+
+	bool watch = false; //whether to keep watching the input directory for reports after the analysis
+
+	string serve_socket; //the socket to answer queries on, if the results are to be served
+	string query_socket; //the socket of the server to send the query to, if this run is a query
+	string query; //the words of the query, separated by tabs
+
+	for(int arg = 1; arg < argc; arg++){
+		const string option = argv[arg];
+
+		if(((option == "-j") || (option == "--workers")) && (arg + 1 < argc)){
+			workers = atoi(argv[++arg]);
+		}
+		else if(option.compare(0,10,"--workers=") == 0){
+			workers = atoi(option.substr(10).c_str());
+		}
+		else if(option == "--cache"){
+			use_cache = 1;
+		}
+		else if(option == "--no-cache"){
+			use_cache = 0;
+		}
+		else if((option == "--input") && (arg + 1 < argc)){
+			directory = argv[++arg];
+		}
+		else if((option == "--output") && (arg + 1 < argc)){
+			output_directory = argv[++arg];
+		}
+		else if((option == "--prefs") && (arg + 1 < argc)){
+			pref_file = argv[++arg];
+		}
+		else if(option == "--recursive"){
+			RECURSIVE = true;
+		}
+		else if(option == "--no-prompt"){
+			PROMPT = false;
+		}
+		else if((option == "--memory-budget") && (arg + 1 < argc)){
+			memory_budget = atol(argv[++arg]);
+		}
+		else if((option == "--approximate") && (arg + 1 < argc)){
+			approximate_memory = atol(argv[++arg]);
+		}
+		else if((option == "--export") && (arg + 1 < argc)){
+			export_name = argv[++arg];
+		}
+		else if((option == "--dedup") && (arg + 1 < argc)){
+			dedup_name = argv[++arg];
+		}
+		else if((option == "--partial") && (arg + 1 < argc)){
+			partial_file = argv[++arg];
+		}
+		else if((option == "--reduce") && (arg + 1 < argc)){
+			reduce_files.push_back(argv[++arg]);
+		}
+		else if(option == "--watch"){
+			watch = true;
+			PROMPT = false; //it runs until it's stopped, so there's no user to wait for
+		}
+		else if((option == "--serve") && (arg + 1 < argc)){
+			serve_socket = argv[++arg];
+			PROMPT = false; //there's no user to wait for
+		}
+		else if((option == "--query") && (arg + 2 < argc)){
+			//the rest of the arguments are the query
+			query_socket = argv[++arg];
+			while(++arg < argc){
+				if(!query.empty()) query += '\t';
+				query += argv[arg];
+			}
+		}
+		else{
+			cerr << "Error: Unknown option \"" << option << "\"." << endl
+				<< "The options are --input <directory>, --output <directory>, --prefs <file>," << endl
+				<< "--recursive, --no-prompt, -j <workers>, --cache, --no-cache," << endl
+				<< "--memory-budget <MB>, --approximate <MB>, --dedup <none|server|all>," << endl
+				<< "--export <csv|jsonl>, --partial <file>," << endl
+				<< "--reduce <file>, --watch, --serve <socket> and --query <socket> <query>." << endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	//a query just prints the answer, so that it can be used in scripts
+	if(!query_socket.empty()){
+		string answer, error;
+		if(!send_query(query_socket, query, answer, error)){
+			cerr << "Error: " << error << "." << endl;
+			return EXIT_FAILURE;
+		}
+
+		//the answer is "OK <n>" and then the lines, or "ERROR <message>"
+		if(answer.compare(0, 3, "OK ") != 0){
+			cerr << "Error: " << trim(answer.compare(0, 6, "ERROR ") == 0 ? answer.substr(6) : answer) << "." << endl;
+			return EXIT_FAILURE;
+		}
 
-int main(void){
+		cout << answer.substr(answer.find('\n') + 1);
+		return EXIT_SUCCESS;
+	}
 
 	cout << "WWF Analyzer" << endl
 		<< "This program analyzes the world writable files reports" << endl
 		<< "and summarizes the results." << endl << endl;
 
+	if(!serve_socket.empty() && reduce_files.empty()){
+		cerr << "Error: The partial results files to serve must be given with --reduce when --serve is used." << endl;
+		return EXIT_FAILURE;
+	}
+
+	if(watch && (directory.empty() || !reduce_files.empty() || !partial_file.empty() || !export_name.empty())){
+		cerr << "Error: --watch needs the input directory to be given with --input," << endl
+			<< "and can't be used with --reduce, --partial or --export." << endl;
+		return EXIT_FAILURE;
+	}
+
+	if(!reduce_files.empty() && !directory.empty()){
+		cerr << "Error: --input and --reduce can't be used together." << endl;
+		return EXIT_FAILURE;
+	}
+
+	export_format command_line_export = EXPORT_NONE;
+	if(!export_name.empty() && !parse_export_format(export_name, command_line_export)){
+		cerr << "Error: The export format must be csv or jsonl." << endl;
+		return EXIT_FAILURE;
+	}
+
+	dedup_scope command_line_dedup = DEDUP_NONE;
+	if(!dedup_name.empty() && !parse_dedup_scope(dedup_name, command_line_dedup)){
+		cerr << "Error: The dedup scope must be none, server or all." << endl;
+		return EXIT_FAILURE;
+	}
+
+	if(!PROMPT && directory.empty() && reduce_files.empty()){
+		cerr << "Error: The input directory must be given with --input when --no-prompt is used." << endl;
+		return EXIT_FAILURE;
+	}
+
 	//load the user's preferences, if the file does not exist, create it and have the user rerun the program
-	if(!set_prefs()) return EXIT_SUCCESS;
+	//(when there's no user to rerun it, the analysis is done with the defaults)
+	//if any of the rules in it are not valid, the user needs to fix them before anything is analyzed
+	const prefs_result prefs = set_prefs(pref_file);
+	if(prefs == PREFS_INVALID) return EXIT_FAILURE;
+	if((prefs == PREFS_CREATED) && PROMPT) return EXIT_SUCCESS;
+
+	//the options given on the command line take precedence over the preferences file
+	if(workers >= 0) WORKERS = workers;
+	if(use_cache >= 0) CACHE = (use_cache != 0);
+	if(memory_budget >= 0) MEMORY_BUDGET = (memory_budget > 0) ? (size_t)memory_budget * 1024 * 1024 : numeric_limits<size_t>::max();
+	if(!export_name.empty()) EXPORT = command_line_export;
+	if(approximate_memory >= 0) APPROXIMATE_MEMORY = (size_t)approximate_memory * 1024 * 1024;
+	if(!dedup_name.empty()) DEDUP = command_line_dedup;
+
+	//the files counted so far are only known while the reports are analyzed in one run
+	if((DEDUP != DEDUP_NONE) && watch){
+		cerr << "Error: Duplicates can't be collapsed with --watch." << endl;
+		return EXIT_FAILURE;
+	}
+
+	//the approximate summary doesn't keep the pairs, which the other ways of using the results need
+	if((APPROXIMATE_MEMORY > 0) && serve_socket.empty() && (watch || !partial_file.empty() || (EXPORT != EXPORT_NONE))){
+		cerr << "Error: An approximate summary can't be made with --watch, --partial or --export." << endl;
+		return EXIT_FAILURE;
+	}
 
-	//these are for finding the files to be analyzed
-	WIN32_FIND_DATA file_data;
-	HANDLE hFind;
+	//answer queries about the partial results instead of summarizing them
+	if(!serve_socket.empty()){
+		QueryServer server (reduce_files, MAX_CRITICAL);
 
-	string directory; //the directory where the files are located
-	const string file_name_pattern = "*.*"; //the structure of the file name (we will allow any file name)
+		string error;
+		if(!server.load(error)){
+			cerr << "Error: " << error << "." << endl;
+			return EXIT_FAILURE;
+		}
+
+		cout << "Answering queries about the results on " << serve_socket << "." << endl;
+
+		if(!server.serve(serve_socket, error)){
+			cerr << "Error: " << error << "." << endl;
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
 
-	//loop until we get a valid directory
-	do{
-		cout << "Enter the directory containing the files:" << endl;
+	vector<report_file> reports; //the reports to analyze, in directory order
 
-		do{
-		    getline(cin,directory);
-		} while(directory.empty());
+	RunStats run_stats; //the statistics of this run, written next to the summary report
 
-		//add trailing backslash if the user did not
+	if(!directory.empty()){
+
+		//add trailing slash if the user did not
 		if((directory.at(directory.length() - 1) != '\\') && (directory.at(directory.length() - 1) != '/')){
-			directory += '\\';
+			directory += '/';
+		}
+
+		StageTimer scan_timer;
+		if(!find_reports(directory, reports)){
+			cerr << "Error: The directory " << directory << " could not be read." << endl;
+			return EXIT_FAILURE;
 		}
+		scan_timer.stop(run_stats.scan);
+	}
+	else if(reduce_files.empty()){
+		//loop until we get a valid directory
+		while(true){
+			cout << "Enter the directory containing the files:" << endl;
+
+			do{
+			    getline(cin,directory);
+			} while(directory.empty() && cin.good());
+
+			if(directory.empty()) return EXIT_FAILURE;
+
+			//add trailing backslash if the user did not
+			if((directory.at(directory.length() - 1) != '\\') && (directory.at(directory.length() - 1) != '/')){
+				directory += '\\';
+			}
 
-		//get the first file in the given directory
-		hFind = FindFirstFile((directory + file_name_pattern).c_str(), &file_data);
+			StageTimer scan_timer;
+			if(find_reports(directory, reports)){
+				scan_timer.stop(run_stats.scan);
+				break;
+			}
 
-		//if no such file can be found
-		if(hFind == INVALID_HANDLE_VALUE){
 			cerr << "Error: The directory could not be found." << endl << endl;
+			reports.clear();
+		}
+	}
+
+	//the reports are created with the analyzed files unless another directory is given
+	//(when merging partial results, that's the current directory)
+	if(output_directory.empty()){
+		output_directory = directory;
+	}
+	else{
+		if((output_directory.at(output_directory.length() - 1) != '\\') && (output_directory.at(output_directory.length() - 1) != '/')){
+			output_directory += '/';
 		}
 
-	} while(hFind == INVALID_HANDLE_VALUE);
+		vector<scanned_file> existing;
+		if(!scan_directory(output_directory, false, existing)){
+			cerr << "Error: The output directory " << output_directory << " could not be found." << endl;
+			return EXIT_FAILURE;
+		}
+	}
 
 
 	cout << endl << endl << "Beginning analysis." << endl << endl;
 
-	list<WWF_data> lst_WWF; //list of WWF
+	//the cache is only valid for the preferences which affect the results of analyzing a report
+	//(the cache doesn't keep the paths of the files, so it isn't used when duplicates are collapsed)
+	unique_ptr<ReportCache> cache;
+	if(CACHE && reduce_files.empty() && (DEDUP != DEDUP_NONE)){
+		cout << "The cache is not used when duplicates are collapsed, every report will be analyzed." << endl << endl;
+	}
+	else if(CACHE && reduce_files.empty()){
+		unsigned long long preferences = hash_combine(ignore_files_classifier.fingerprint(), critical_files_classifier.fingerprint());
+		preferences = hash_combine(preferences, MAX_CRITICAL);
+		preferences = hash_combine(preferences, hash_combine(TOP_DIRECTORIES, DIRECTORY_DEPTH));
 
-	//for each file in the directory
-    do{
-		//ignore directories and hidden files
-		if ((file_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-			|(file_data.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN)) continue;
+		cache.reset(new ReportCache(preferences, watch));
+		cache->load(output_directory + CACHE_FILE_NAME);
+	}
 
-		//determine the name of the server for the file that we're opening
-		string server_name = get_server_name(file_data.cFileName);
+	ReportWriter writer; //writes the reports in the background
 
-		//if the file is a previously generated report, ignore it
-		string cmp1 = server_name;
-		cmp1 += " WWF Details Report.txt";
-		const string cmp2 = "WWF Summary Report.txt";
-		if((cmp1.compare(file_data.cFileName) == 0) || (cmp2.compare(file_data.cFileName) == 0)) continue;
+	//the exported results are written as each report is merged, and the totals once every report has been
+	unique_ptr<ResultsExporter> exporter;
+	if(EXPORT != EXPORT_NONE){
+		exporter.reset(new ResultsExporter(writer, output_directory, EXPORT));
+
+		if(!exporter->is_open()){
+			cerr << "Error: Unable to create the export files." << endl << endl;
+			exporter.reset();
+		}
+	}
+
+	WWFStore store; //the WWF data for every owner/server pair
+	vector<directory_count> directories; //the directories with the most WWFs on each server
+	map<string, unique_ptr<report_contribution> > contributions; //what each report added to the results, when watching
+
+	//when the memory for the summary is limited, the results are added to sketches instead of the store
+	unique_ptr<ApproximateSummary> approximate;
+	if(APPROXIMATE_MEMORY > 0){
+		approximate.reset(new ApproximateSummary(APPROXIMATE_MEMORY));
+	}
+	PartialResults partial (MAX_CRITICAL, MEMORY_BUDGET, output_directory); //the results for each server, when they are saved or were merged from files
+	StageTimer analyze_timer;
+
+	if(reduce_files.empty()){
+		analyze_reports(directory, output_directory, reports, cache.get(), writer, store, directories, run_stats.reports, partial_file.empty() ? NULL : &partial, exporter.get(), watch ? &contributions : NULL, approximate.get());
+	}
+	else{
+		//merge the partial results, then make the details reports for each server from the merged results
+		for(vector<string>::iterator i = reduce_files.begin(); i != reduce_files.end(); i++){
+
+			cout << "Merging the results in " << *i << "..." << endl;
+
+			string error;
+			if(!partial.load(*i, error)){
+				cerr << "Error: The results in " << *i << " could not be merged, " << error << "." << endl;
+				pause();
+				return EXIT_FAILURE;
+			}
+		}
+
+		if(!approximate){
+			partial.merge_into(store);
+		}
+
+		const map<string, unique_ptr<ReportAnalysis> >& results = partial.results();
+		for(map<string, unique_ptr<ReportAnalysis> >::const_iterator i = results.begin(); i != results.end(); i++){
+			if(approximate){
+				approximate->add(i->second->store);
+			}
+
+			if(partial_file.empty() && i->second->readable){
+				write_details_report(output_directory + i->first + " WWF Details Report.txt", *i->second, writer);
+			}
+
+			if(exporter){
+				exporter->add_report(*i->second);
+			}
+
+			add_top_directories(*i->second, directories);
+			if(approximate) keep_top_directories(directories);
+		}
 
-        //open the file
-		ifstream file ((directory + file_data.cFileName).c_str());
-		if(file.is_open()){
+		cout << endl << "Done merging the results of " << partial.results().size() << " servers." << endl;
+	}
+
+	if(exporter){
+		exporter->add_totals(store);
+		exporter->close();
+	}
+
+	analyze_timer.stop(run_stats.analyze);
+	run_stats.workers = (WORKERS > 0) ? WORKERS : thread::hardware_concurrency();
 
-			unsigned long WWF_found; //stores the number of WWFs found from the analysis
+	if(cache && !cache->save(output_directory + CACHE_FILE_NAME)){
+		cerr << "Error: Unable to save the cache (" << CACHE_FILE_NAME << ")." << endl << endl;
+	}
 
-			cout << "Analyzing WWFs on " << server_name << "..." << endl;
-			WWF_found = analyze(file, directory, server_name, lst_WWF);
-			cout << "Done analyzing " << server_name << ". " << WWF_found << " WWFs have been found." << endl << endl;
+	//save the results to be merged elsewhere, instead of summarizing them
+	if(!partial_file.empty()){
+		writer.finish();
 
-        }
-        else{
-            cerr << "Error: " << file_data.cFileName << " could not be opened." << endl;
-        }
+		if(!partial.save(partial_file)){
+			cerr << "Error: Unable to save the partial results (" << partial_file << ")." << endl << endl;
+			pause();
+			return EXIT_FAILURE;
+		}
 
-    } while(FindNextFile(hFind, &file_data));
+		cout << endl << "Analysis has finished." << endl << endl
+			<< "The results have been saved to " << partial_file << endl << endl;
 
-    //if the reason that we stopped is something other than running out of files, something went wrong
-	if(GetLastError() != ERROR_NO_MORE_FILES){
-        cerr << "Error: The directory was not searched successfully." << endl;
 		pause();
-		return EXIT_FAILURE;
+		return EXIT_SUCCESS;
 	}
 
 	//make summary report
-	ofstream report;
-	report.open ((directory + "WWF Summary Report.txt").c_str());
+	ReportBuffer report (writer, output_directory + "WWF Summary Report.txt");
 
 	if(report.is_open()){
 
-		summarize(report, lst_WWF);
+		StageTimer summarize_timer;
+		if(approximate){
+			summarize_approximate(report, *approximate, directories);
+		}
+		else{
+			summarize(report, store, directories);
+		}
+
+		//how many files were found more than once and counted only once
+		if((DEDUP != DEDUP_NONE) && reduce_files.empty()){
+			unsigned long long duplicates = 0;
+			for(vector<report_stats>::iterator i = run_stats.reports.begin(); i != run_stats.reports.end(); i++){
+				duplicates += i->duplicates;
+			}
+
+			report << "\n\n\n" << duplicates << " duplicate files have been collapsed, so each file is counted once for each server"
+				<< ((DEDUP == DEDUP_ALL) ? ", and a file on a shared mount once for all of them." : ".");
+		}
+		summarize_timer.stop(run_stats.summarize);
 
+		//wait for all of the reports to be written
+		StageTimer write_timer;
 		report.close();
+		writer.finish();
+		write_timer.stop(run_stats.write);
+
+		//write the statistics of the run
+		ReportBuffer stats_report (writer, output_directory + STATS_FILE_NAME);
+		if(stats_report.is_open()){
+			stats_report << run_stats.to_json();
+			stats_report.close();
+			writer.finish();
+		}
+		else{
+			cerr << "Error: Unable to create the statistics file (" << STATS_FILE_NAME << ")." << endl << endl;
+		}
 
-		cout << endl << "Analysis has finished." << endl << endl
-			<< "The WWF Summary Report has been created in the" << endl
-			<< "same directory as the analyzed files." << endl << endl;
+		cout << endl << "Analysis has finished." << endl << endl;
+
+		if(output_directory == directory){
+			cout << "The WWF Summary Report has been created in the" << endl
+				<< "same directory as the analyzed files." << endl << endl;
+		}
+		else{
+			cout << "The WWF Summary Report has been created in" << endl
+				<< output_directory << endl << endl;
+		}
+
+		const memory_counts memory = get_memory_counts();
+		cout << "Memory: " << memory.allocations << " allocations, peak of "
+			<< ((memory.peak_bytes + 1023) / 1024) << " KB in use." << endl << endl;
+
+		//keep the summary report up to date as more reports arrive
+		if(watch && !watch_reports(directory, output_directory, cache.get(), writer, store, contributions)){
+			return EXIT_FAILURE;
+		}
 
 		pause();
 
+#ifdef _WIN32
 		//open the Summary Report before the termination of this program
-		ShellExecute(NULL, "open", (directory + "WWF Summary Report.txt").c_str(), NULL, NULL, 1);
+		if(PROMPT){
+			ShellExecute(NULL, "open", (output_directory + "WWF Summary Report.txt").c_str(), NULL, NULL, 1);
+		}
+#endif
 
 	}
 	else{
@@ -159,8 +637,10 @@ int main(void){
 	return EXIT_SUCCESS;
 }
 
-//prompts the user to press enter to continue
+//prompts the user to press enter to continue (unless there's no user to prompt)
 void pause(void){
+	if(!PROMPT) return;
+
 	cout << "Press enter to continue." << endl;
 	cin.ignore();
 	return;
@@ -202,22 +682,244 @@ string get_server_name(string file_name){
 	return server_name;
 }
 
-//get the user's preferences from the preferences file
-//returns false if no preferences file exists, true otherwise
-bool set_prefs(void){
+//find the reports in the directory (and its subdirectories if RECURSIVE), in directory order
+//returns false if the directory could not be searched
+bool find_reports(string directory, vector<report_file>& reports){
+
+	vector<scanned_file> files;
+	if(!scan_directory(directory, RECURSIVE, files)) return false;
+
+	reports.reserve(files.size());
+
+	//for each file in the directory
+	for(vector<scanned_file>::iterator i = files.begin(); i != files.end(); i++){
+
+		//determine the name of the server for the file that we're opening
+		string server_name = get_server_name(i->name);
+
+		//if the file is a previously generated report, ignore it
+		string cmp1 = server_name;
+		cmp1 += " WWF Details Report.txt";
+		const string cmp2 = "WWF Summary Report.txt";
+		if((cmp1 == i->name) || (cmp2 == i->name) || (STATS_FILE_NAME == i->name)) continue;
+
+		//the cache is not a report either
+		if((CACHE_FILE_NAME == i->name) || ((CACHE_FILE_NAME + ".tmp") == i->name)) continue;
+
+		//nor are the exported results
+		if(i->name.compare(0, 11, "WWF Export ") == 0) continue;
+
+		//nor are the critical files spilled to disk while another run analyzes the reports
+		if(i->name.compare(0, SPILL_FILE_PREFIX.size(), SPILL_FILE_PREFIX) == 0) continue;
+
+		report_file new_report;
+
+		new_report.file_name = i->path;
+		new_report.server_name = server_name;
+		new_report.size = i->size;
+		new_report.modified = i->modified;
+
+		reports.push_back(new_report);
+	}
+
+	return true;
+}
+
+//keep watching the directory for reports, analyzing each one as it's written and keeping the summary report up to date
+//a replaced or removed report's contribution is taken out of store first, so the summary is always that of the reports in the directory
+//contributions has what each report in the directory added to store when this starts
+//returns false if the directory could not be watched, otherwise it runs until the program is stopped
+bool watch_reports(string directory, string output_directory, ReportCache* cache, ReportWriter& writer, WWFStore& store, map<string, unique_ptr<report_contribution> >& contributions){
+
+	ReportWatcher watcher (directory, RECURSIVE);
+
+	string error;
+	if(!watcher.start(error)){
+		cerr << "Error: " << error << "." << endl;
+		return false;
+	}
+
+	cout << "Watching " << directory << " for reports (stop with Ctrl+C)." << endl << endl;
+
+	//a report may have been written while the others were being analyzed, before the watch started,
+	//so every report is checked once to begin with
+	vector<string> written;
+	bool changed = true;
+	{
+		vector<report_file> reports;
+		find_reports(directory, reports);
+		for(vector<report_file>::iterator i = reports.begin(); i != reports.end(); i++){
+			written.push_back(i->file_name);
+		}
+	}
+
+	bool summary_due = false; //whether the results have changed since the summary report was written
+	chrono::steady_clock::time_point first_change, last_change;
+
+	while(true){
+
+		if(changed){
+			vector<report_file> reports;
+			if(!find_reports(directory, reports)){
+				lock_guard<mutex> lock(console_mutex);
+				cerr << "Error: The directory " << directory << " could not be read." << endl;
+			}
+
+			sort(written.begin(), written.end());
 
-	const string pref_file = "WWF Analyzer.pref";
+			//the reports which have been written since they were analyzed
+			vector<report_file> new_reports;
+			set<string> listed;
+			for(vector<report_file>::iterator i = reports.begin(); i != reports.end(); i++){
+				listed.insert(i->file_name);
+
+				if(!binary_search(written.begin(), written.end(), i->file_name)) continue;
+
+				map<string, unique_ptr<report_contribution> >::iterator contribution = contributions.find(i->file_name);
+				if((contribution != contributions.end()) && (contribution->second->size == i->size) && (contribution->second->modified == i->modified)) continue;
+
+				new_reports.push_back(*i);
+			}
+
+			bool updated = false;
+
+			//take the results of the reports which are gone out of the summary
+			for(map<string, unique_ptr<report_contribution> >::iterator i = contributions.begin(); i != contributions.end(); ){
+				if(listed.find(i->first) == listed.end()){
+					store.subtract(i->second->store);
+
+					lock_guard<mutex> lock(console_mutex);
+					cout << i->first << " has been removed." << endl << endl;
+
+					contributions.erase(i++);
+					updated = true;
+				}
+				else{
+					i++;
+				}
+			}
+
+			//and the old results of the reports which have been replaced, before the new ones are added
+			for(vector<report_file>::iterator i = new_reports.begin(); i != new_reports.end(); i++){
+				map<string, unique_ptr<report_contribution> >::iterator contribution = contributions.find(i->file_name);
+				if(contribution != contributions.end()){
+					store.subtract(contribution->second->store);
+					contributions.erase(contribution);
+				}
+			}
+
+			if(!new_reports.empty()){
+				vector<directory_count> directories; //(the summary's directories are taken from the contributions)
+				vector<report_stats> stats;
+				analyze_reports(directory, output_directory, new_reports, cache, writer, store, directories, stats, NULL, NULL, &contributions, NULL);
+				updated = true;
+			}
+
+			if(updated){
+				last_change = chrono::steady_clock::now();
+				if(!summary_due) first_change = last_change;
+				summary_due = true;
+			}
+		}
+
+		//rewrite the summary report once the reports have stopped arriving for a while
+		int timeout = -1;
+		if(summary_due){
+			const chrono::steady_clock::time_point now = chrono::steady_clock::now();
+			const chrono::steady_clock::time_point due = min(last_change + chrono::seconds(SUMMARY_DELAY_SECONDS), first_change + chrono::seconds(SUMMARY_MAX_DELAY_SECONDS));
+
+			if(now >= due){
+				//the directories of every report, in directory order like when the reports are all analyzed at once
+				vector<directory_count> directories;
+				for(map<string, unique_ptr<report_contribution> >::iterator i = contributions.begin(); i != contributions.end(); i++){
+					directories.insert(directories.end(), i->second->directories.begin(), i->second->directories.end());
+				}
+
+				ReportBuffer report (writer, output_directory + "WWF Summary Report.txt");
+				if(report.is_open()){
+					summarize(report, store, directories);
+					report.close();
+					writer.finish();
+
+					lock_guard<mutex> lock(console_mutex);
+					cout << "The WWF Summary Report has been updated." << endl << endl;
+				}
+				else{
+					lock_guard<mutex> lock(console_mutex);
+					cerr << "Error: Unable to update the summary report." << endl << endl;
+				}
+
+				if((cache != NULL) && !cache->save(output_directory + CACHE_FILE_NAME)){
+					cerr << "Error: Unable to save the cache (" << CACHE_FILE_NAME << ")." << endl << endl;
+				}
+
+				summary_due = false;
+			}
+			else{
+				timeout = (int)chrono::duration_cast<chrono::milliseconds>(due - now).count() + 1;
+			}
+		}
+
+		written.clear();
+		changed = watcher.wait(timeout, written);
+	}
+}
+
+//get the export format for its name (csv or jsonl)
+//returns false if the name is not a format
+bool parse_export_format(const string& name, export_format& format){
+
+	if(name == "csv"){
+		format = EXPORT_CSV;
+	}
+	else if(name == "jsonl"){
+		format = EXPORT_JSON_LINES;
+	}
+	else{
+		return false;
+	}
+
+	return true;
+}
+
+//get the dedup scope for its name (none, server or all)
+//returns false if the name is not a scope
+bool parse_dedup_scope(const string& name, dedup_scope& scope){
+
+	if(name == "none"){
+		scope = DEDUP_NONE;
+	}
+	else if(name == "server"){
+		scope = DEDUP_SERVER;
+	}
+	else if(name == "all"){
+		scope = DEDUP_ALL;
+	}
+	else{
+		return false;
+	}
+
+	return true;
+}
+
+//get the user's preferences from the preferences file
+//returns PREFS_CREATED if no preferences file exists, PREFS_INVALID if any of its rules are not valid
+prefs_result set_prefs(string pref_file){
 
 	//open the preferences file and load the contents
 	ifstream file (pref_file.c_str());
 	if(file.is_open()){
 
+		unsigned long line_number = 0;
+		bool valid = true; //false once a rule which is not valid has been found
+
 		//while we still have lines to read
 		while(file.good()){
 
 			//read the line
 			string line;
 			getline(file,line);
+			line_number++;
 
 			//get values
 			if((line.compare(0,16,"SUMMARY_SERVERS=") == 0) || (line.compare(0,17,"SUMMARY_SERVERS =") == 0)){
@@ -264,43 +966,173 @@ bool set_prefs(void){
 					MAX_CRITICAL = val;
 				}
 			}
-			else if(line.compare(0,2,"i.") == 0){
-				string val = trim(line.substr(2));
+			else if((line.compare(0,16,"TOP_DIRECTORIES=") == 0) || (line.compare(0,17,"TOP_DIRECTORIES =") == 0)){
+				istringstream ss;
+				ss.str(line.substr(line.find_last_of('=') + 1));
 
-				if(val != ""){
-					ignore_files_classifier.add_extension(val);
-				}
-			}
-			else if(line.compare(0,2,"i:") == 0){
-				string val = trim(line.substr(2));
+				int val;
+				ss >> val;
 
-				if(val != ""){
-					ignore_files_classifier.add_substring(val);
+				if(!ss.fail()){
+					TOP_DIRECTORIES = val;
 				}
 			}
-			else if(line.compare(0,2,"c.") == 0){
-				string val = trim(line.substr(2));
+			else if((line.compare(0,16,"DIRECTORY_DEPTH=") == 0) || (line.compare(0,17,"DIRECTORY_DEPTH =") == 0)){
+				istringstream ss;
+				ss.str(line.substr(line.find_last_of('=') + 1));
+
+				int val;
+				ss >> val;
+
+				if(!ss.fail() && (val >= 0)){
+					DIRECTORY_DEPTH = val;
+				}
+			}
+			else if((line.compare(0,14,"MEMORY_BUDGET=") == 0) || (line.compare(0,15,"MEMORY_BUDGET =") == 0)){
+				istringstream ss;
+				ss.str(line.substr(line.find_last_of('=') + 1));
 
-				if(val != ""){
-					critical_files_classifier.add_extension(val);
+				unsigned long val;
+				ss >> val;
+
+				if(!ss.fail()){
+					MEMORY_BUDGET = (val > 0) ? (size_t)val * 1024 * 1024 : numeric_limits<size_t>::max();
 				}
 			}
-			else if(line.compare(0,2,"c:") == 0){
+			else if((line.compare(0,19,"APPROXIMATE_MEMORY=") == 0) || (line.compare(0,20,"APPROXIMATE_MEMORY =") == 0)){
+				istringstream ss;
+				ss.str(line.substr(line.find_last_of('=') + 1));
+
+				unsigned long val;
+				ss >> val;
+
+				if(!ss.fail()){
+					APPROXIMATE_MEMORY = (size_t)val * 1024 * 1024;
+				}
+			}
+			else if((line.compare(0,7,"EXPORT=") == 0) || (line.compare(0,8,"EXPORT =") == 0)){
+				export_format val;
+
+				if(parse_export_format(trim(line.substr(line.find_last_of('=') + 1)), val)){
+					EXPORT = val;
+				}
+			}
+			else if((line.compare(0,6,"DEDUP=") == 0) || (line.compare(0,7,"DEDUP =") == 0)){
+				dedup_scope val;
+
+				if(parse_dedup_scope(trim(line.substr(line.find_last_of('=') + 1)), val)){
+					DEDUP = val;
+				}
+			}
+			else if(line.compare(0,2,"m:") == 0){
+				const size_t equals = line.find('=');
+				string mount, name;
+				if(equals != string::npos){
+					mount = trim(line.substr(2, equals - 2));
+					name = trim(line.substr(equals + 1));
+				}
+
+				if(mount.empty() || name.empty()){
+					cerr << "Error in " << pref_file << " line " << line_number << ": a shared mount must be m:[directory]=[name]" << endl
+						<< "  " << trim(line) << endl;
+					valid = false;
+				}
+				else{
+					//so that /nfs/home/ doesn't match /nfs/homes/
+					if(mount[mount.size() - 1] != '/') mount += '/';
+					if(name[name.size() - 1] != '/') name += '/';
+
+					SHARED_MOUNTS.push_back(pair<string, string>(mount, name));
+				}
+			}
+			else if((line.compare(0,8,"WORKERS=") == 0) || (line.compare(0,9,"WORKERS =") == 0)){
+				istringstream ss;
+				ss.str(line.substr(line.find_last_of('=') + 1));
+
+				int val;
+				ss >> val;
+
+				if(!ss.fail()){
+					WORKERS = val;
+				}
+			}
+			else if((line.compare(0,6,"CACHE=") == 0) || (line.compare(0,7,"CACHE =") == 0)){
+				istringstream ss;
+				ss.str(line.substr(line.find_last_of('=') + 1));
+
+				int val;
+				ss >> val;
+
+				if(!ss.fail()){
+					CACHE = (val != 0);
+				}
+			}
+			else if((line.size() >= 2) && ((line[0] == 'i') || (line[0] == 'c'))){
+				FileClassifier& classifier = (line[0] == 'i') ? ignore_files_classifier : critical_files_classifier;
 				string val = trim(line.substr(2));
 
-				if(val != ""){
-					critical_files_classifier.add_substring(val);
+				if(line[1] == '.'){
+					if(val != "") classifier.add_extension(val);
+				}
+				else if(line[1] == ':'){
+					if(val != "") classifier.add_substring(val);
+				}
+				else if((line[1] == '~') || (line[1] == '%')){
+					string error;
+
+					if(val == ""){
+						error = "the pattern is empty";
+					}
+					else if(line[1] == '~'){
+						classifier.add_glob(val, error, line_number);
+					}
+					else{
+						classifier.add_regex(val, error, line_number);
+					}
+
+					if(!error.empty()){
+						cerr << "Error in " << pref_file << " line " << line_number << ": " << error << endl
+							<< "  " << trim(line) << endl;
+						valid = false;
+					}
 				}
 			}
 		}
+
+		//prepare the rules for classifying files
+		//a rule which makes the combined rules too complex is checked on its own, which works but is slower, so say which one it is
+		ignore_files_classifier.compile();
+		critical_files_classifier.compile();
+
+		for(int kind = 0; kind < 2; kind++){
+			const FileClassifier& classifier = (kind == 0) ? ignore_files_classifier : critical_files_classifier;
+			const list<pair<unsigned long, string> >& uncombined = classifier.uncombined_rules();
+
+			for(list<pair<unsigned long, string> >::const_iterator i = uncombined.begin(); i != uncombined.end(); i++){
+				cout << "In " << pref_file << " line " << i->first << ", " << i->second << " is too complex to combine" << endl
+					<< "with the other " << ((kind == 0) ? "ignore" : "critical") << " rules, so it will be checked on its own, which is slower." << endl << endl;
+			}
+		}
+
+		if(!valid){
+			cerr << endl << "Fix the rules in the preferences file and then rerun this program." << endl;
+			pause();
+			return PREFS_INVALID;
+		}
     }
 
 	//if the preferences file does not exist, we create a new one and ask the user to rerun the program
 	else{
         cout << "The preferences file (" << pref_file << ") does not exist." << endl
 			<< "A default preferences file will be created in the directory" << endl
-			<< "where this program is located." << endl << endl
-			<< "Take a look at the file, make any changes you want, and then rerun this program.";
+			<< "where this program is located." << endl << endl;
+
+		if(PROMPT){
+			cout << "Take a look at the file, make any changes you want, and then rerun this program.";
+		}
+		else{
+			cout << "The analysis will be done with the default preferences." << endl << endl;
+		}
 
 		ofstream pref;
 		pref.open (pref_file.c_str());
@@ -319,6 +1151,29 @@ bool set_prefs(void){
 				<< "#HIGH_VOLUME=X" << endl
 				<< "# Where X is the desired value." << endl
 				<< "# If the corresponding value is not set here, the program will default to not limiting the number shown." << endl << endl
+				<< "# The summary and details reports show the directories with the most WWFs." << endl
+				<< "# For the max number of directories to show (default is 10, 0 to leave them out):" << endl
+				<< "#TOP_DIRECTORIES=X" << endl
+				<< "# For the depth of the directories shown, e.g. 2 for /home/user/ (default is 3, 0 for the whole paths):" << endl
+				<< "#DIRECTORY_DEPTH=X" << endl
+				<< "# Files in deeper directories are counted in the directory at that depth above them." << endl << endl
+				<< "# When there are too many owner/server pairs to keep them all in memory (e.g. a scan of every server)," << endl
+				<< "# the summary can be made in a fixed amount of memory instead, with estimated counts, by including:" << endl
+				<< "#APPROXIMATE_MEMORY=X" << endl
+				<< "# Where X is the memory in MB to use for it (default is 0, for the exact summary)." << endl
+				<< "# Each count is shown as the range which it is sure to be in, and the number of owners on each server is estimated." << endl
+				<< "# This can also be given on the command line with --approximate X." << endl << endl
+				<< "# Files which are found more than once, e.g. listed twice in a report or in two reports for the same server," << endl
+				<< "# or on a file system which is mounted on several servers, can be counted only once by including:" << endl
+				<< "#DEDUP=X" << endl
+				<< "# Where X is server to count each file once for each server, or all to also count each file on a shared mount" << endl
+				<< "# once for all of the servers (default is none, to count every line)." << endl
+				<< "# The file is counted for the first report it's found in, and how many were collapsed is shown in the reports." << endl
+				<< "# The shared mounts are given as m:[directory]=[name], for the directory where it's mounted on the servers," << endl
+				<< "# and a name for the file system, which can be given to more than one directory if it's mounted in different places." << endl
+				<< "# e.x. for the home directories which the servers mount from a file server at /nfs/home/:" << endl
+				<< "#m:/nfs/home/=fileserver:/export/home/" << endl
+				<< "# This can also be given on the command line with --dedup X." << endl << endl
 				<< "# Ignoring files:" << endl
 				<< "# To ignore a certain file extension, type i.[extension] on a new line." << endl
 				<< "# e.x. to ignore log files:" << endl
@@ -332,9 +1187,19 @@ bool set_prefs(void){
 				<< "# Note that this will ignore */tmp/*, so you may want to specify" << endl
 				<< "# the entire path upto that directory, if there are multiple directories with the same name" << endl
 				<< "# but with different parent directories." << endl << endl
+				<< "# To ignore any file whose whole path matches a glob pattern, type i~[pattern] on a new line." << endl
+				<< "# In a pattern, * matches any characters except /, ** matches any characters including /," << endl
+				<< "# ? matches one character except /, and [abc] or [!abc] matches one of (or none of) the characters." << endl
+				<< "# e.x. to ignore the log files in every directory under /var/:" << endl
+				<< "#i~/var/**/*.log" << endl
+				<< "# To ignore any file whose path contains a match for a regular expression, type i%[regex] on a new line." << endl
+				<< "# The supported syntax is . [...] [^...] \\d \\w \\s * + ? {m,n} | and ( ), with ^ and $ for the start and end of the path." << endl
+				<< "# e.x. to ignore the numbered backups of any file:" << endl
+				<< "#i%\\.[0-9]+$" << endl
+				<< "# A pattern which is not valid is reported with its line number, and nothing is analyzed until it is fixed." << endl << endl
 				<< "# Critical files:" << endl
 				<< "# To have the program flag certain files as critical," << endl
-				<< "# use the same method for ignoring extensions and substrings, but with \"c\" instead of \"i\"" << endl
+				<< "# use the same methods for ignoring extensions, substrings and patterns, but with \"c\" instead of \"i\"" << endl
 				<< "# e.x. to flag sh files:" << endl
 				<< "#c.sh" << endl
 				<< "# e.x. to flag all files in the \"home\" directory:" << endl
@@ -342,7 +1207,31 @@ bool set_prefs(void){
 				<< "# The program will default to not limiting the number of critical files shown in the details reports." << endl
 				<< "# To limit the number shown, include:" << endl
 				<< "#MAX_CRITICAL=X" << endl
-				<< "# Where X is the desired value." << endl;
+				<< "# Where X is the desired value." << endl
+				<< "# When there are a huge number of critical files, they can be kept from using up the memory with:" << endl
+				<< "#MEMORY_BUDGET=X" << endl
+				<< "# Where X is the most memory in MB to use for the critical files of each report being analyzed." << endl
+				<< "# The rest are sorted into temporary files in the output directory, which are removed afterwards." << endl
+				<< "# This can also be given on the command line with --memory-budget X." << endl << endl
+				<< "# Analyzing reports in parallel:" << endl
+				<< "# The program will default to analyzing one report at a time." << endl
+				<< "# To analyze several reports at the same time, include:" << endl
+				<< "#WORKERS=X" << endl
+				<< "# Where X is the number of reports to analyze at once, or 0 for one per processor." << endl
+				<< "# A very large report is split into chunks which are analyzed at the same time too." << endl
+				<< "# This can also be given on the command line with -j X." << endl << endl
+				<< "# Reusing results:" << endl
+				<< "# To keep the results for each report in a cache file (" << CACHE_FILE_NAME << ")" << endl
+				<< "# in the output directory (the directory with the reports, unless --output is given)," << endl
+				<< "# so that reports which have not changed since the last run are not analyzed again, include:" << endl
+				<< "#CACHE=1" << endl
+				<< "# This can also be turned on or off on the command line with --cache or --no-cache." << endl << endl
+				<< "# Exporting the results:" << endl
+				<< "# To also save the owner/server pairs, the totals for each server and owner, and the critical files" << endl
+				<< "# as files which other programs can load (WWF Export *.csv or WWF Export *.jsonl), include:" << endl
+				<< "#EXPORT=X" << endl
+				<< "# Where X is csv or jsonl (for JSON Lines)." << endl
+				<< "# This can also be given on the command line with --export X." << endl;
 
 		}
 		else{
@@ -351,159 +1240,640 @@ bool set_prefs(void){
 		}
 
 		pause();
-		return false;
+		return PREFS_CREATED;
     }
 
-	return true;
+	return PREFS_LOADED;
+}
+
+//analyze each of the reports and store the data in the store of WWFs
+//up to WORKERS reports are analyzed at the same time, each into its own store,
+//and the stores are merged in directory order so the result is the same as analyzing the reports one after another
+//if there is a cache, reports which haven't changed since it was saved are loaded from it instead of being analyzed
+//the directories with the most WWFs on each server are added to directories, for the summary
+//if partial is given, the results for each report are added to it too, and if exporter is given, they're exported
+//if contributions is given, what each report adds to store is kept in it by file name, so it can be taken out again
+//(that's when the directory is being watched, so the reports are read rather than mapped, since one may be rewritten while it's analyzed)
+//if approximate is given, the results are added to it instead of store, and only the top directories of every server are kept
+void analyze_reports(string directory, string output_directory, const vector<report_file>& reports, ReportCache* cache, ReportWriter& writer, WWFStore& store, vector<directory_count>& directories, vector<report_stats>& stats, PartialResults* partial, ResultsExporter* exporter, map<string, unique_ptr<report_contribution> >* contributions, ApproximateSummary* approximate){
+
+	vector<unique_ptr<ReportAnalysis> > analyses(reports.size()); //the results for each report
+	stats.assign(reports.size(), report_stats());
+
+	unsigned threads = (WORKERS > 0) ? WORKERS : thread::hardware_concurrency(); //the number of threads to analyze with
+	if(threads == 0) threads = 1;
+
+	unsigned workers = threads;
+	if(workers > reports.size()) workers = reports.size();
+	if(workers == 0) workers = 1;
+
+	//the order in which the reports are handed out to the workers
+	//in parallel, the largest reports go first so that a large report started last does not leave the other workers idle
+	vector<size_t> order(reports.size());
+	for(size_t i = 0; i < order.size(); i++){
+		order[i] = i;
+	}
+	if(workers > 1){
+		stable_sort(order.begin(), order.end(),
+			[&reports](size_t r1, size_t r2){ return reports[r1].size > reports[r2].size; });
+	}
+
+	//the number of bytes in the reports from each one in the order to the end
+	//a large report is split among as many threads as its share of the bytes left, so a huge report doesn't hold up the run
+	vector<unsigned long long> bytes_left(order.size() + 1, 0);
+	for(size_t i = order.size(); i > 0; i--){
+		bytes_left[i - 1] = bytes_left[i] + reports[order[i - 1]].size;
+	}
+
+	//the results are merged in directory order as soon as every report before them has finished, and then freed,
+	//so only the results of the reports still waiting for an earlier one are held at once
+	vector<bool> finished(reports.size(), false);
+	size_t next_merge = 0;
+	mutex merge_mutex; //held while merging
+
+	//the WWFs counted so far, when duplicates are collapsed, so a file is counted for the first report it's in
+	FingerprintSet counted;
+
+	auto merge_finished = [&](size_t report){
+		lock_guard<mutex> lock(merge_mutex);
+		finished[report] = true;
+
+		while((next_merge < analyses.size()) && finished[next_merge]){
+			if(analyses[next_merge]){
+				if(DEDUP != DEDUP_NONE){
+					analyses[next_merge]->earlier_duplicates = collapse_duplicates(*analyses[next_merge], counted, stats[next_merge], NULL);
+					analyses[next_merge]->critical_files.limit(MAX_CRITICAL);
+
+					//the fingerprints aren't needed once they've been counted
+					vector<counted_WWF>().swap(analyses[next_merge]->counted);
+
+					//the details report is written now, so that it has the same counts as the summary
+					if(analyses[next_merge]->readable){
+						const chrono::steady_clock::time_point write_start = chrono::steady_clock::now();
+						write_details_report(output_directory + reports[next_merge].server_name + " WWF Details Report.txt", *analyses[next_merge], writer);
+						stats[next_merge].write_seconds = chrono::duration<double>(chrono::steady_clock::now() - write_start).count();
+					}
+				}
+
+				if(approximate != NULL){
+					approximate->add(analyses[next_merge]->store);
+				}
+				else{
+					store.merge(analyses[next_merge]->store);
+				}
+
+				add_top_directories(*analyses[next_merge], directories);
+				if(approximate != NULL) keep_top_directories(directories);
+
+				if(partial != NULL){
+					partial->add(*analyses[next_merge]);
+				}
+
+				if(exporter != NULL){
+					exporter->add_report(*analyses[next_merge]);
+				}
+
+				if(contributions != NULL){
+					unique_ptr<report_contribution> contribution(new report_contribution);
+					contribution->size = reports[next_merge].size;
+					contribution->modified = reports[next_merge].modified;
+					contribution->store.merge(analyses[next_merge]->store);
+					add_top_directories(*analyses[next_merge], contribution->directories);
+
+					(*contributions)[reports[next_merge].file_name] = move(contribution);
+				}
+
+				analyses[next_merge].reset();
+			}
+
+			next_merge++;
+		}
+	};
+
+	atomic<size_t> next_report(0);
+
+	//each worker takes the next report from the order until there are none left
+	auto worker = [&](){
+		for(size_t n = next_report++; n < order.size(); n = next_report++){
+
+			const report_file& report = reports[order[n]];
+			const string details_report = output_directory + report.server_name + " WWF Details Report.txt";
+
+			report_stats& report_statistics = stats[order[n]];
+			report_statistics.server_name = report.server_name;
+			report_statistics.file_name = report.file_name;
+			report_statistics.bytes = report.size;
+
+			const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			const double cpu_start = thread_cpu_seconds();
+			const unsigned long long allocations_start = get_thread_allocations();
+
+			unique_ptr<ReportAnalysis> analysis(new ReportAnalysis(report.server_name, analysis_max_critical(), MEMORY_BUDGET, output_directory));
+			unsigned long long content_hash = 0;
+
+			//if the report hasn't changed since it was cached, use the cached results
+			//(only what's in the results is known, the lines of the report aren't counted)
+			if((cache != NULL) && cache->find(directory, report, *analysis, content_hash)){
+
+				cache->keep(report);
+
+				report_statistics.cached = true;
+				report_statistics.WWFs = analysis->WWFs;
+				report_statistics.critical = analysis->critical_files.count();
+				report_statistics.analyze_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+				report_statistics.analyze_cpu_seconds = thread_cpu_seconds() - cpu_start;
+				report_statistics.allocations = get_thread_allocations() - allocations_start;
+
+				{
+					lock_guard<mutex> lock(console_mutex);
+					cout << "Using the cached analysis of " << report.server_name << ". "
+						<< analysis->WWFs << " WWFs have been found." << endl << endl;
+				}
+
+				//recreate the details report if it's been removed
+				if(!ifstream(details_report.c_str()).is_open()){
+					write_details_report(details_report, *analysis, writer);
+				}
+
+				analyses[order[n]] = move(analysis);
+				merge_finished(order[n]);
+				continue;
+			}
+
+			//the cached results may have been partly loaded before being found to be invalid
+			analysis.reset(new ReportAnalysis(report.server_name, analysis_max_critical(), MEMORY_BUDGET, output_directory));
+
+			//open the file
+			MappedFile file (directory + report.file_name, contributions != NULL);
+			if(file.is_open()){
+
+				{
+					lock_guard<mutex> lock(console_mutex);
+					cout << "Analyzing WWFs on " << report.server_name << "..." << endl;
+				}
+
+				unsigned report_threads = 1;
+				if(bytes_left[n] > 0){
+					report_threads = (unsigned)((double)threads * report.size / bytes_left[n] + 0.5);
+					if(report_threads == 0) report_threads = 1;
+				}
+
+				analyze(file.contents(), *analysis, report_statistics, report_threads, output_directory);
+
+				//(the chunks analyzed by other threads have already been counted)
+				report_statistics.analyze_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+				report_statistics.analyze_cpu_seconds += thread_cpu_seconds() - cpu_start;
+				report_statistics.allocations += get_thread_allocations() - allocations_start;
+
+				if(analysis->readable){
+
+					//(when duplicates are collapsed, it's written once the files which earlier reports have counted are taken out)
+					if(DEDUP == DEDUP_NONE){
+						const chrono::steady_clock::time_point write_start = chrono::steady_clock::now();
+						write_details_report(details_report, *analysis, writer);
+						report_statistics.write_seconds = chrono::duration<double>(chrono::steady_clock::now() - write_start).count();
+					}
+
+					{
+						lock_guard<mutex> lock(console_mutex);
+						cout << "Done analyzing " << report.server_name << ". " << analysis->WWFs << " WWFs have been found." << endl << endl;
+					}
+
+					//the cache holds the results of every report in memory until it's saved,
+					//so results whose critical files took more than the memory budget aren't cached
+					if((cache != NULL) && analysis->critical_files.spilled()){
+						lock_guard<mutex> lock(console_mutex);
+						cout << "The analysis of " << report.server_name << " is not cached, since its critical files are larger than the memory budget." << endl << endl;
+					}
+					else if(cache != NULL){
+						cache->update(report, hash_bytes(file.contents()), *analysis);
+					}
+				}
+				else{
+					lock_guard<mutex> lock(console_mutex);
+					cout << "Done analyzing " << report.server_name << ". 0 WWFs have been found." << endl << endl;
+				}
+
+				analyses[order[n]] = move(analysis);
+			}
+			else{
+				lock_guard<mutex> lock(console_mutex);
+				cerr << "Error: " << report.file_name << " could not be opened." << endl;
+			}
+
+			merge_finished(order[n]);
+		}
+	};
+
+	if(workers == 1){
+		worker();
+	}
+	else{
+		vector<thread> pool;
+		for(unsigned i = 0; i < workers; i++){
+			pool.push_back(thread(worker));
+		}
+		for(unsigned i = 0; i < workers; i++){
+			pool[i].join();
+		}
+	}
+
+	if(DEDUP != DEDUP_NONE){
+		cout << counted.size() << " distinct WWFs have been kept track of in "
+			<< ((counted.memory() + 1023) / 1024) << " KB, to find the duplicates." << endl << endl;
+	}
 }
 
-//analyze the file for the given server and store the data in the list of WWFs
+//analyze the contents of a report and store the results in analysis
+//the number of lines of each kind and of calls to the classifiers are counted in stats
+//a large report is split into chunks at newlines, which are analyzed by up to threads threads,
+//and the results of the chunks are merged in file order, so they're the same as analyzing the report in one go
 //returns the number of WWFs found
-unsigned long analyze(ifstream& file, string directory, string server_name, list<WWF_data>& lst_WWF){
-
-	unsigned long WWFs = 0;
-	unsigned long ignored_files = 0;
-	unsigned long critical_files = 0;
-
-	list<critical_file_owner> lst_critical_files;
-
-	//check if the first character in the file is non-ascii
-	//if so, then the file likely contains formatted text, which we can't read easily
-	if(file.good() && (file.peek() != EOF)){
-		if(!__isascii(file.peek())){
-			cerr << endl << "Error:" << endl
-				<< "The contents of this file are unintelligible." << endl
-				<< "This is probably due to formatting being applied to the text." << endl
-				<< "Try copying the text into a new text file and redo the analysis." << endl
-				<< "If you chose to continue, the analysis of the remaining files will be done," << endl
-				<< "but this file will not be analyzed and no WWFs will be recorded." << endl << endl;
-			pause();
-			return 0;
+unsigned long analyze(string_view contents, ReportAnalysis& analysis, report_stats& stats, unsigned threads, const string& spill_directory){
+
+	//the server is in the results even if it has no WWFs
+	analysis.store.intern_server(analysis.server_name);
+
+	//a report saved as UTF-16 (e.g. by PowerShell) is decoded to UTF-8 first, so the lines are parsed the same way
+	//if the file doesn't start with text in any encoding, then it likely contains formatted text, which we can't read easily
+	size_t bom_length;
+	const text_encoding encoding = detect_encoding(contents, bom_length);
+	stats.encoding = encoding_name(encoding);
+
+	contents.remove_prefix(bom_length);
+
+	unique_ptr<char[]> decoded;
+	if((encoding == ENCODING_UTF16_LE) || (encoding == ENCODING_UTF16_BE)){
+		decoded.reset(new char[utf8_capacity(contents.size())]);
+		contents = string_view(decoded.get(), utf16_to_utf8(contents, encoding == ENCODING_UTF16_BE, decoded.get()));
+	}
+	else if(encoding == ENCODING_UNKNOWN){
+		lock_guard<mutex> lock(console_mutex);
+		cerr << endl << "Error:" << endl
+			<< "The contents of this file are unintelligible." << endl
+			<< "This is probably due to formatting being applied to the text." << endl
+			<< "Try copying the text into a new text file and redo the analysis." << endl
+			<< "If you chose to continue, the analysis of the remaining files will be done," << endl
+			<< "but this file will not be analyzed and no WWFs will be recorded." << endl << endl;
+		pause();
+		analysis.readable = false;
+		stats.readable = false;
+		return 0;
+	}
+
+	//the format is the same for the whole report, so it's found once, from the first lines
+	const report_format format = ReportParser::detect_format(contents);
+	stats.format = ReportParser::format_name(format);
+
+	size_t num_chunks = contents.size() / MIN_CHUNK_BYTES;
+	if(num_chunks > threads) num_chunks = threads;
+
+	if(num_chunks <= 1){
+		//when duplicates are collapsed, the files seen in the report
+		unique_ptr<FingerprintSet> seen;
+		if(DEDUP != DEDUP_NONE) seen.reset(new FingerprintSet);
+
+		analyze_chunk(contents, format, analysis, stats, seen.get(), NULL);
+	}
+	else{
+		//split the contents at the first newline after each chunk's share of the bytes
+		//the newline between two chunks is in neither, so they have the same lines as the whole report
+		vector<string_view> chunks;
+		size_t start = 0;
+
+		for(size_t i = 1; i < num_chunks; i++){
+			const size_t target = (size_t)((double)contents.size() * i / num_chunks);
+			if(target < start) continue;
+
+			const size_t newline = contents.find('\n', target);
+			if(newline == string_view::npos) break;
+
+			chunks.push_back(contents.substr(start, newline - start));
+			start = newline + 1;
 		}
+		chunks.push_back(contents.substr(start));
+
+		//each chunk has its own results, with its share of the memory budget for critical files
+		const size_t memory_budget = (MEMORY_BUDGET == numeric_limits<size_t>::max()) ? MEMORY_BUDGET : (MEMORY_BUDGET / chunks.size());
+
+		vector<unique_ptr<ReportAnalysis> > results(chunks.size());
+		vector<report_stats> chunk_stats(chunks.size());
+		for(size_t i = 0; i < chunks.size(); i++){
+			results[i].reset(new ReportAnalysis(analysis.server_name, analysis_max_critical(), memory_budget, spill_directory));
+		}
+
+		//when duplicates are collapsed, each chunk has its own files seen, so what it finds doesn't depend on how fast the others are
+		//a file which is in more than one chunk is found when they're merged, and taken out of the directory it was counted in
+		vector<unique_ptr<FingerprintSet> > seen(chunks.size());
+		vector<vector<string_view> > counted_directories(chunks.size());
+		if(DEDUP != DEDUP_NONE){
+			for(size_t i = 0; i < chunks.size(); i++){
+				seen[i].reset(new FingerprintSet);
+			}
+		}
+
+		//this thread analyzes the first chunk, and a thread is started for each of the others
+		//the time and allocations of the other threads are counted with their chunks
+		auto analyze_other_chunk = [&](size_t i){
+			const double cpu_start = thread_cpu_seconds();
+			const unsigned long long allocations_start = get_thread_allocations();
+
+			analyze_chunk(chunks[i], format, *results[i], chunk_stats[i], seen[i].get(), &counted_directories[i]);
+
+			chunk_stats[i].analyze_cpu_seconds = thread_cpu_seconds() - cpu_start;
+			chunk_stats[i].allocations = get_thread_allocations() - allocations_start;
+		};
+
+		vector<thread> pool;
+		for(size_t i = 1; i < chunks.size(); i++){
+			pool.push_back(thread(analyze_other_chunk, i));
+		}
+
+		analyze_chunk(chunks[0], format, *results[0], chunk_stats[0], seen[0].get(), &counted_directories[0]);
+
+		for(size_t i = 0; i < pool.size(); i++){
+			pool[i].join();
+		}
+
+		//merge the results in file order, so the owners are found in the same order as by one thread
+		//and a file which is in several chunks is counted for the first of them, as it is by one thread
+		for(size_t i = 0; i < chunks.size(); i++){
+			if((DEDUP != DEDUP_NONE) && (i > 0)){
+				collapse_duplicates(*results[i], *seen[0], chunk_stats[i], &counted_directories[i]);
+				seen[i].reset();
+			}
+
+			analysis.merge(*results[i]);
+			stats.add(chunk_stats[i]);
+			results[i].reset();
+		}
+
+		stats.threads = chunks.size();
 	}
 
+	//every critical file has been found, so the kept ones can be put in order for the reports
+	analysis.critical_files.sort();
+
+	return analysis.WWFs;
+}
+
+//analyze the lines of contents (a whole report, or a chunk of one) in the format and add the results to analysis
+//the number of lines of each kind and of calls to the classifiers are added to stats
+//if seen is given, a world writable file which is already in it is a duplicate, and isn't counted
+//if counted_directories is given too, the directory of each WWF counted is added to it, in the same order as the results' counted WWFs
+void analyze_chunk(string_view contents, report_format format, ReportAnalysis& analysis, report_stats& stats, FingerprintSet* seen, vector<string_view>* counted_directories){
+
+	//the lines are analyzed by a loop compiled for the format, so the format isn't checked for each line
+	if(format == FORMAT_FIND){
+		analyze_lines<find_format>(contents, analysis, stats, seen, counted_directories);
+	}
+	else if(format == FORMAT_STAT){
+		analyze_lines<stat_format>(contents, analysis, stats, seen, counted_directories);
+	}
+	else{
+		analyze_lines<ls_format>(contents, analysis, stats, seen, counted_directories);
+	}
+}
+
+//analyze the lines of contents, which are in Format, and add the results to analysis
+template<class Format>
+void analyze_lines(string_view contents, ReportAnalysis& analysis, report_stats& stats, FingerprintSet* seen, vector<string_view>* counted_directories){
+
+	WWFStore& store = analysis.store;
+
+	const symbol server = store.intern_server(analysis.server_name);
+
+	ReportParser parser(contents);
+	string_view line;
+
+	unsigned long long lines = 0, valid_lines = 0, world_writable = 0, duplicates = 0, WWFs = 0, critical = 0;
+
+	//the files of a report are clustered in a few directories, so what the rules have read for each directory is remembered
+	ClassificationCache ignore_files (ignore_files_classifier);
+	ClassificationCache critical_files (critical_files_classifier);
+
 	//while we still have lines to read
-	while(file.good()){
+	while(parser.next_line(line)){
 
-		//read the line
-		string line;
-		getline(file,line);
+		lines++;
 
 		//we extract the permissions, owner, and file name from each line and discard the rest
-		istringstream ss;
-		ss.str(line);
-		string permissions, owner, file_name, discard;
-		ss >> permissions >> discard >> owner >> discard >> discard >> discard >> discard >> discard;
-		//the file name is just the rest of the line
-		getline(ss,file_name);
-		file_name = trim(file_name);
-
 		//only continue to process the line if the line contains valid data
-		//we expect the permissions symbolic notation to be 10 characters long
-		//the first character in permissions must be one of the following:
-		//'-' for regular file, 'd' for directory, or 'l' for link, or b, c, p, s
-		//else, we have an invalid line
-		if(!ss.fail() && (file_name != "") && (permissions.size() == 10) && (permissions.at(0) == '-'
-			|| permissions.at(0) == 'd' || permissions.at(0) == 'l'
-			|| permissions.at(0) == 'b' || permissions.at(0) == 'c'
-			|| permissions.at(0) == 'p' || permissions.at(0) == 's')){
-			//if the file is world writable then the second last char will be "w", not "-"
-			//also we make sure that the file is not one of the ones to be ignored
-			if((permissions.at(8) == 'w') && (!ignore_files_classifier.satisfies(file_name))){
-
-				//stores whether or not we can add an occurrence to an existing owner/server pair
-				bool existing_element = false;
-
-				//check if there is an element for this owner on this server
-				for (list<WWF_data>::iterator i = lst_WWF.begin(); i != lst_WWF.end(); i++){
-					if((i->owner == owner) && (i->server == server_name)){
-						//increment the number of occurrences of this owner on this server
-						i->count += 1;
-
-						//if the file is critical
-						if(critical_files_classifier.satisfies(file_name)){
-							//count it
-							i->critical += 1;
-							critical_files++;
-
-							//include the file in the list of critical files
-							critical_file_owner new_critical_file;
-
-							new_critical_file.owner = owner;
-							new_critical_file.file = file_name;
-
-							lst_critical_files.push_back(new_critical_file);
-						}
-
-						existing_element = true; //we added to an existing pair
-						break; //we can stop searching
-					}
-				}
+		report_line fields;
+		if(ReportParser::parse_line<Format>(line, fields)){
 
-				//if there were no existing pairs, we add a new one to the list
-				if(!existing_element){
-					WWF_data new_WWF;
+			valid_lines++;
 
-					new_WWF.server = server_name;
-					new_WWF.owner = owner;
-					new_WWF.count = 1;
+			const bool is_world_writable = ReportParser::world_writable<Format>(fields);
+			if(is_world_writable) world_writable++;
 
-					if(critical_files_classifier.satisfies(file_name)){
-						new_WWF.critical = 1;
-						critical_files++;
+			//we make sure that the file is world writable and is not one of the ones to be ignored
+			if(is_world_writable && (!ignore_files.satisfies(fields.file_name))){
 
-						critical_file_owner new_critical_file;
+				//a file which has already been found is left out, when duplicates are collapsed
+				fingerprint path = fingerprint();
+				if(seen != NULL){
+					path = path_fingerprint(analysis.server_name, fields.file_name);
 
-						new_critical_file.owner = owner;
-						new_critical_file.file = file_name;
-
-						lst_critical_files.push_back(new_critical_file);
-					}
-					else{
-						new_WWF.critical = 0;
+					if(!seen->insert(path)){
+						duplicates++;
+						continue;
 					}
+				}
+
+				//get the pair for this owner on this server and increment the number of occurrences
+				const symbol owner = store.intern_owner(fields.owner);
+				WWF_data& WWF = store.entry(server, owner);
+				WWF.count += 1;
 
+				//count it in its directory
+				const string_view directory = fields.file_name.substr(0, fields.file_name.rfind('/') + 1);
+				analysis.directories.add(directory);
 
-					lst_WWF.push_front(new_WWF);
+				//if the file is critical
+				const bool is_critical = critical_files.satisfies(fields.file_name);
+				if(is_critical){
+					//count it
+					WWF.critical += 1;
+
+					//include the file in the list of critical files
+					analysis.critical_files.add(store.owner_name(owner), fields.file_name);
+					critical++;
+				}
+
+				//remember it, in case an earlier report has the same file
+				if(seen != NULL){
+					const counted_WWF counted = {path, owner, is_critical};
+					analysis.counted.push_back(counted);
+
+					if(counted_directories != NULL) counted_directories->push_back(directory);
 				}
 
 				WWFs++;
 			}
 			else{
-				ignored_files++;
+				analysis.ignored_files++;
+			}
+		}
+	}
+
+	analysis.WWFs += WWFs;
+	analysis.duplicates += duplicates;
+
+	//every world writable file is checked against the ignored files, and every WWF (which isn't a duplicate) against the critical files
+	stats.lines += lines;
+	stats.valid_lines += valid_lines;
+	stats.not_world_writable += valid_lines - world_writable;
+	stats.ignore_checks += world_writable;
+	stats.ignore_hits += world_writable - duplicates - WWFs;
+	stats.ignored += world_writable - duplicates - WWFs;
+	stats.duplicates += duplicates;
+	stats.critical_checks += WWFs;
+	stats.WWFs += WWFs;
+	stats.critical_hits += critical;
+	stats.critical += critical;
+	stats.ignore_cache_hits += ignore_files.hit_count();
+	stats.ignore_decided += ignore_files.decided_count();
+	stats.critical_cache_hits += critical_files.hit_count();
+	stats.critical_decided += critical_files.decided_count();
+}
+
+//the fingerprint of a file on a server, to find the files which have been found before
+//with DEDUP=all, a file on a shared mount is fingerprinted by the mount's name instead of the server, so it's the same on every server
+fingerprint path_fingerprint(const string& server_name, string_view file_name){
+
+	if(DEDUP == DEDUP_ALL){
+		for(vector<pair<string, string> >::const_iterator i = SHARED_MOUNTS.begin(); i != SHARED_MOUNTS.end(); i++){
+			if(file_name.compare(0, i->first.size(), i->first) == 0){
+				return FingerprintSet::make(i->second, file_name.substr(i->first.size()));
+			}
+		}
+	}
+
+	return FingerprintSet::make(server_name, file_name);
+}
+
+//take the WWFs which have already been counted (by an earlier report, or an earlier chunk of the report) out of the results,
+//and count them as duplicates, in file order, the rest are added to counted and stay in the results' counted WWFs
+//the critical files are taken out of the list of critical files too, and if the directories of the counted WWFs are given,
+//out of their directories (or else the directories are left as they are, since they're what was found on its server)
+//returns the number of duplicates found
+unsigned long collapse_duplicates(ReportAnalysis& analysis, FingerprintSet& counted, report_stats& stats, const vector<string_view>* counted_directories){
+
+	WWFStore duplicates;
+	const symbol server = duplicates.intern_server(analysis.server_name);
+	unsigned long found = 0, critical = 0;
+
+	//the critical files to take out, by their path and owner, with how many of each
+	map<pair<pair<unsigned long long, unsigned long long>, string_view>, unsigned long> critical_duplicates;
+
+	vector<counted_WWF>::iterator kept = analysis.counted.begin();
+	for(vector<counted_WWF>::const_iterator i = analysis.counted.begin(); i != analysis.counted.end(); i++){
+		if(counted.insert(i->path)){
+			*kept++ = *i;
+		}
+		else{
+			WWF_data& WWF = duplicates.entry(server, duplicates.intern_owner(analysis.store.owner_name(i->owner)));
+			WWF.count += 1;
+			found++;
+
+			if(i->critical){
+				WWF.critical += 1;
+				critical++;
+
+				critical_duplicates[make_pair(make_pair(i->path.high, i->path.low), analysis.store.owner_name(i->owner))]++;
+			}
+
+			if(counted_directories != NULL){
+				analysis.directories.remove((*counted_directories)[i - analysis.counted.begin()]);
 			}
 		}
 	}
 
-	lst_WWF.sort(greater<WWF_data>());
+	if(found > 0) analysis.store.subtract(duplicates);
+
+	//the critical files are matched by their fingerprints, since their paths aren't kept with the counted WWFs
+	if(critical > 0){
+		const string& server_name = analysis.server_name;
+		analysis.critical_files.remove_files([&critical_duplicates, &server_name](string_view owner, string_view file){
+			const fingerprint path = path_fingerprint(server_name, file);
 
-	//create server details report
-	ofstream report;
-	report.open ((directory + server_name + " WWF Details Report.txt").c_str());
+			map<pair<pair<unsigned long long, unsigned long long>, string_view>, unsigned long>::iterator duplicate
+				= critical_duplicates.find(make_pair(make_pair(path.high, path.low), owner));
+			if((duplicate == critical_duplicates.end()) || (duplicate->second == 0)) return false;
+
+			duplicate->second--;
+			return true;
+		}, critical);
+	}
+
+	analysis.WWFs -= found;
+	analysis.duplicates += found;
+	stats.WWFs -= found;
+	stats.critical -= critical;
+	stats.duplicates += found;
+
+	analysis.counted.erase(kept, analysis.counted.end());
+
+	return found;
+}
+
+//create the details report for the server of an analyzed report
+//the report is formatted here and written to the file by the writer, while the next report is analyzed
+void write_details_report(string file_name, const ReportAnalysis& analysis, ReportWriter& writer){
+
+	const WWFStore& store = analysis.store;
+	const unsigned long WWFs = analysis.WWFs;
+	const unsigned long ignored_files = analysis.ignored_files;
+	const unsigned long long critical_files = analysis.critical_files.count();
+
+	ReportBuffer report (writer, file_name);
 
 	if(report.is_open()){
 
-		report << server_name << " WWF Details Report" << endl << endl;
+		report << analysis.server_name << " WWF Details Report" << "\n\n";
+
+		report << "Files Found:\t" << (WWFs + ignored_files + analysis.duplicates) << '\n'
+		<< "Files Ignored:\t" << ignored_files << '\n';
 
-		report << "Files Found:\t" << (WWFs + ignored_files) << endl
-		<< "Files Ignored:\t" << ignored_files << endl
-		<< "# of WWFs:\t" << WWFs << endl
-		<< "Critical Files:\t" << critical_files << endl << endl << endl;
+		//the files which were found more than once, when duplicates are collapsed
+		if(analysis.duplicates > 0){
+			report << "Duplicates:\t" << analysis.duplicates << '\n';
+		}
+
+		report << "# of WWFs:\t" << WWFs << '\n'
+		<< "Critical Files:\t" << critical_files << "\n\n\n";
 
 		if(WWFs > 0){
-			report << ' ' << setw(COL_WIDTH) << left << "Owner" << "# of Files (# Critical)" << endl
-				<< setfill('-') << setw(COL_WIDTH) << right << "+" << setw(COL_WIDTH + COL_WIDTH/2) << "" << setfill(' ') << endl;
+			report << ' ' << align_left("Owner", COL_WIDTH) << "# of Files (# Critical)" << '\n'
+				<< align_right("+", COL_WIDTH, '-') << align_right("", COL_WIDTH + COL_WIDTH/2, '-') << '\n';
 
 			//for each element for the current server, print the owner and the number of files (and any critical files)
-			for (list<WWF_data>::iterator i = lst_WWF.begin(); i != lst_WWF.end(); i++){
-				if(i->server == server_name){
-					report << ' ' << setw(COL_WIDTH - 2)  << left << i->owner << "| " << i->count;
+			vector<const WWF_data*> server_pairs = store.sorted_server_pairs(store.server_id(analysis.server_name));
+			for (vector<const WWF_data*>::iterator i = server_pairs.begin(); i != server_pairs.end(); i++){
+				report << ' ' << align_left(store.owner_name((*i)->owner), COL_WIDTH - 2) << "| " << (*i)->count;
 
-					if(i->critical > 0){
-						report << " (" << i->critical << ")";
-					}
+				if((*i)->critical > 0){
+					report << " (" << (*i)->critical << ")";
+				}
+
+				report << '\n';
+			}
+
+			//display the directories with the most files
+			vector<directory_count> top_directories = analysis.directories.top_directories(max_directories(), DIRECTORY_DEPTH);
+			if(!top_directories.empty()){
+
+				report << "\n\n" << ' ' << align_left("# of Files", COL_WIDTH) << "Directory" << '\n'
+					<< align_right("+", COL_WIDTH, '-') << align_right("", COL_WIDTH + COL_WIDTH/2, '-') << '\n';
 
-					report << endl;
+				for(vector<directory_count>::iterator i = top_directories.begin(); i != top_directories.end(); i++){
+					report << ' ' << align_left(i->files, COL_WIDTH - 2) << "| " << i->directory << '\n';
+				}
+
+				//the paths of the files which earlier reports counted aren't kept, so they're still in their directories
+				if(analysis.earlier_duplicates > 0){
+					report << "(the directories also count the " << analysis.earlier_duplicates << " files collapsed against earlier reports)" << '\n';
 				}
 			}
 
@@ -516,221 +1886,357 @@ unsigned long analyze(ifstream& file, string directory, string server_name, list
 		//display the critical files
 		if(critical_files > 0){
 
-			lst_critical_files.sort();
+			report << "\n\n\n" << "Critical files:";
 
-			report << endl << endl << endl << "Critical files:";
-
-			//for each critical file, or until the max number to display is reached...
-			list<critical_file_owner>::iterator i = lst_critical_files.begin();
-			unsigned long num_file = 0;
-			for(; (num_file < MAX_CRITICAL) && (i != lst_critical_files.end()); num_file++, i++){
-				report << endl << ' ' << setw(COL_WIDTH - 2)  << left << i->owner << i->file;
-			}
+			//for each critical file, up to the max number to display...
+			//(if they were spilled to disk, they're merged back in order as they're written)
+			analysis.critical_files.for_each_sorted([&report](string_view owner, string_view file){
+				report << '\n' << ' ' << align_left(owner, COL_WIDTH - 2) << file;
+			});
 
 			//if we've hit the max number to display but there are still more files, inform the user there are too many critical files
-			if((num_file == MAX_CRITICAL) && (i != lst_critical_files.end())){
-				report << endl << endl << MAX_CRITICAL
-					<< " critical files have been displayed. However, there are more critical files than this." << endl
+			if(analysis.critical_files.omitted()){
+				report << "\n\n" << analysis.critical_files.kept_count()
+					<< " critical files have been displayed. However, there are more critical files than this." << '\n'
 					<< "They have been omitted as per the value of the \"MAX_CRITICAL\" setting.";
 			}
 		}
 
 	}
 	else{
+		lock_guard<mutex> lock(console_mutex);
 		cerr << "Error: Unable create report." << endl
 			<< "Make sure that you have write access for the directory" << endl
 			<< "and that any previously created reports are not in use," << endl
 			<< "so that they can be overwritten." << endl << endl;
 	}
+}
+
+//the max number of directories to show in the reports, a negative preference shows none
+size_t max_directories(){
+	return (TOP_DIRECTORIES > 0) ? TOP_DIRECTORIES : 0;
+}
+
+//the max number of critical files a report's analysis keeps while it's analyzed
+//when duplicates are collapsed, they're all kept until the duplicates are taken out, and then limited to MAX_CRITICAL,
+//since a duplicate taken out of the first MAX_CRITICAL would leave room for a file which was dropped
+unsigned long analysis_max_critical(){
+	return (DEDUP == DEDUP_NONE) ? MAX_CRITICAL : numeric_limits<unsigned long>::max();
+}
+
+//add the directories with the most WWFs on the analysis's server to directories
+//only the top directories of each server are needed to find the top directories of every server
+void add_top_directories(const ReportAnalysis& analysis, vector<directory_count>& directories){
+
+	vector<directory_count> top_directories = analysis.directories.top_directories(max_directories(), DIRECTORY_DEPTH);
 
-	return WWFs;
+	for(vector<directory_count>::iterator i = top_directories.begin(); i != top_directories.end(); i++){
+		i->server = analysis.server_name;
+		directories.push_back(*i);
+	}
 }
 
-void summarize(ofstream& report, list<WWF_data>& lst_WWF){
+//keep only the directories which could be shown in the summary, when memory is bounded
+//the top directories of every server are the top ones of those kept and the ones added later, so none that would be shown are lost
+void keep_top_directories(vector<directory_count>& directories){
 
-	lst_WWF.sort(greater<WWF_data>());
+	if(directories.size() <= 2 * max_directories()) return;
 
-	report << "WWF Summary Report" << endl << endl;
+	BoundedHeap<directory_count, more_files> top_directories(max_directories());
+	for(vector<directory_count>::const_iterator i = directories.begin(); i != directories.end(); i++){
+		top_directories.push(*i);
+	}
+
+	directories = top_directories.sorted();
+}
+
+void summarize(ReportBuffer& report, const WWFStore& store, const vector<directory_count>& directories){
+
+	report << "WWF Summary Report" << "\n\n";
 
 	//if there are no WWFs
-	if(lst_WWF.size() == 0){
+	if(store.empty()){
 		report << "There are no WWFs to report.";
 		return;
 	}
 
-	report << " Most Files by Server" << endl
-		<< setfill('-') << setw(25) << "" << setfill(' ') << endl << endl
-		<< ' ' << setw(COL_WIDTH) << left << "Server"
-		<< ' ' << setw(COL_WIDTH) << left << "# of Files"
-		<< "Top Owners" << endl
-		<< setfill('-') << setw(COL_WIDTH) << right << "+"
-		<< setw(COL_WIDTH) << right << "+"
-		<< setw(COL_WIDTH + COL_WIDTH/2 + 1) << "" << setfill(' ') << endl;
+	//sum the number of files for each server and owner, and the number of critical files for each server
+	vector<unsigned long> server_files, owner_files, server_critical;
+	store.totals(server_files, owner_files, server_critical);
+
+	//the max number of items to show, negative preferences show nothing
+	const size_t max_servers = (SUMMARY_SERVERS > 0) ? SUMMARY_SERVERS : 0;
+	const size_t max_owners = (SUMMARY_OWNERS > 0) ? SUMMARY_OWNERS : 0;
+	const size_t max_high_volume = (HIGH_VOLUME > 0) ? HIGH_VOLUME : 0;
+
+	report << " Most Files by Server" << '\n'
+		<< align_right("", 25, '-') << "\n\n"
+		<< ' ' << align_left("Server", COL_WIDTH)
+		<< ' ' << align_left("# of Files", COL_WIDTH)
+		<< "Top Owners" << '\n'
+		<< align_right("+", COL_WIDTH, '-')
+		<< align_right("+", COL_WIDTH, '-')
+		<< align_right("", COL_WIDTH + COL_WIDTH/2 + 1, '-') << '\n';
+
+	//determine the servers with the most files, only keeping as many as will be displayed
+	BoundedHeap<occurrences, greater<occurrences> > top_servers(max_servers);
+	for(symbol s = 0; s < server_files.size(); s++){
+		if(server_files[s] > 0){
+			occurrences new_server;
 
-	list<occurrences> lst_servers; //list of servers by number of WWFs
+			new_server.entity = store.server_name(s);
+			new_server.count = server_files[s];
 
-	//determine order of the servers based on number of files
-	for(list<WWF_data>::iterator i = lst_WWF.begin(); i != lst_WWF.end(); i++){
+			top_servers.push(new_server);
+		}
+	}
 
-		//for each server/owner pair, we look for the sum of the files for the server and update it with the new files
-		bool existing_element = false;
-		for (list<occurrences>::iterator j = lst_servers.begin(); j != lst_servers.end(); j++){
-			if(i->server == j->entity){
-				j->count += i->count;
+	vector<occurrences> lst_servers = top_servers.sorted(); //list of servers by number of WWFs
 
-				existing_element = true;
-				break;
-			}
-		}
+	//for each server, up to the max number of servers to display...
+	for(vector<occurrences>::iterator i = lst_servers.begin(); i != lst_servers.end(); i++){
 
-		//if the server does not have a sum yet, we add it
-		if(!existing_element){
-			occurrences new_server;
+		//display the total number of WWFs for the server
+		report << ' ' << align_left(i->entity, COL_WIDTH - 2)
+			<< "| " << align_left(i->count, COL_WIDTH - 2) << "| " << '\n';
 
-			new_server.entity = i->server;
-			new_server.count = i->count;
+		//for each owner on the server, up to the max number of top owners to display...
+		vector<const WWF_data*> server_pairs = store.sorted_server_pairs(store.server_id(i->entity), max_high_volume);
+		for(vector<const WWF_data*>::iterator j = server_pairs.begin(); j != server_pairs.end(); j++){
 
-			lst_servers.push_front(new_server);
+			//display the number of WWFs for the owner
+			report << align_right("|", COL_WIDTH) << align_right(" | ", COL_WIDTH + 1)
+				<< align_left(store.owner_name((*j)->owner), COL_WIDTH)
+				<< align_right((*j)->count, COL_WIDTH/2) << '\n';
 		}
+		report << align_right("|", COL_WIDTH) << align_right(" | ", COL_WIDTH + 1) << '\n';
 	}
 
-	lst_servers.sort(greater<occurrences>());
+	report << "\n\n\n";
 
-	//for each server, or until the max number of servers to display is reached...
-	list<occurrences>::iterator i = lst_servers.begin();
-	int server = 0;
-	for(; (server < SUMMARY_SERVERS) && (i != lst_servers.end()); server++, i++){
 
-		//display the total number of WWFs for the server
-		report << ' ' << setw(COL_WIDTH - 2) << left << i->entity
-			<< "| " << setw(COL_WIDTH - 2) << left << i->count << "| " << endl;
+	report << " Most Files by Owner" << '\n'
+		<< align_right("", 25, '-') << "\n\n"
+		<< ' ' << align_left("Owner", COL_WIDTH)
+		<< ' ' << align_left("# of Files", COL_WIDTH)
+		<< "Servers" << '\n'
+		<< align_right("+", COL_WIDTH, '-')
+		<< align_right("+", COL_WIDTH, '-')
+		<< align_right("", COL_WIDTH + COL_WIDTH/2 + 1, '-') << '\n';
 
-		//for each owner on the server, or until the max number of top owners to display is reached...
-		list<WWF_data>::iterator j = lst_WWF.begin();
-		int top_owner = 0;
-		for(; (top_owner < HIGH_VOLUME) && (j != lst_WWF.end()); j++){
-			if(j->server == i->entity){
+	//determine the owners with the most files, only keeping as many as will be displayed
+	BoundedHeap<occurrences, greater<occurrences> > top_owners(max_owners);
+	for(symbol o = 0; o < owner_files.size(); o++){
+		if(owner_files[o] > 0){
+			occurrences new_owner;
 
-				//display the number of WWFs for the owner
-				report << setw(COL_WIDTH) << right << '|' << setw(COL_WIDTH + 1) << right << " | "
-					<< setw(COL_WIDTH) << left << j->owner
-					<< setw(COL_WIDTH/2) << right << j->count << endl;
+			new_owner.entity = store.owner_name(o);
+			new_owner.count = owner_files[o];
 
-				top_owner++;
-			}
+			top_owners.push(new_owner);
 		}
-		report << setw(COL_WIDTH) << right << '|' << setw(COL_WIDTH + 1) << right << " | " << endl;
 	}
 
-	report << endl << endl << endl;
+	vector<occurrences> lst_owners = top_owners.sorted(); //list of owners by number of WWFs
 
+	//for each owner, up to the max number of owners to display...
+	for(vector<occurrences>::iterator k = lst_owners.begin(); k != lst_owners.end(); k++){
 
-	report << " Most Files by Owner" << endl
-		<< setfill('-') << setw(25) << "" << setfill(' ') << endl << endl
-		<< ' ' << setw(COL_WIDTH) << left << "Owner"
-		<< ' ' << setw(COL_WIDTH) << left << "# of Files"
-		<< "Servers" << endl
-		<< setfill('-') << setw(COL_WIDTH) << right << "+"
-		<< setw(COL_WIDTH) << right << "+"
-		<< setw(COL_WIDTH + COL_WIDTH/2 + 1) << "" << setfill(' ') << endl;
+		//display the total number of WWFs for the owner
+		report << ' ' << align_left(k->entity, COL_WIDTH - 2)
+			<< "| " << align_left(k->count, COL_WIDTH - 2) << "| " << '\n';
 
-	list<occurrences> lst_owners; //list of owners by number of WWFs
+		//for each server which has the owner, up to the max number of top servers to display...
+		vector<const WWF_data*> owner_pairs = store.sorted_owner_pairs(store.owner_id(k->entity), max_high_volume);
+		for(vector<const WWF_data*>::iterator j = owner_pairs.begin(); j != owner_pairs.end(); j++){
 
-	//determine order of the owners based on number of files
-	for(list<WWF_data>::iterator k = lst_WWF.begin(); k != lst_WWF.end(); k++){
+			//display the number of WWFs for the server
+			report << align_right("|", COL_WIDTH) << align_right(" | ", COL_WIDTH + 1)
+				<< align_left(store.server_name((*j)->server), COL_WIDTH)
+				<< align_right((*j)->count, COL_WIDTH/2) << '\n';
+		}
+		report << align_right("|", COL_WIDTH) << align_right(" | ", COL_WIDTH + 1) << '\n';
+	}
 
-		//for each server/owner pair, we look for the sum of the files for the owner and update it with the new files
-		bool existing_element = false;
-		for (list<occurrences>::iterator j = lst_owners.begin(); j != lst_owners.end(); j++){
-			if(k->owner == j->entity){
-				j->count += k->count;
 
-				existing_element = true;
-				break;
-			}
+	summarize_directories(report, directories);
+
+
+	list<occurrences> lst_num_critical; //list of the number of critical files per server
+
+	//every server with critical files is displayed
+	for(symbol s = 0; s < server_critical.size(); s++){
+		if(server_critical[s] > 0){
+			occurrences new_server;
+
+			new_server.entity = store.server_name(s);
+			new_server.count = server_critical[s];
+
+			lst_num_critical.push_front(new_server);
 		}
+	}
 
-		//if the owner does not have a sum yet, we add it
-		if(!existing_element){
-			occurrences new_owner;
+	lst_num_critical.sort(greater<occurrences>());
 
-			new_owner.entity = k->owner;
-			new_owner.count = k->count;
+	//display the servers with critical files
+	if(lst_num_critical.size() > 0){
 
-			lst_owners.push_front(new_owner);
+		report << "\n\n\n" << "Critical files have been found on the following servers:";
+
+		for(list<occurrences>::iterator i = lst_num_critical.begin(); i != lst_num_critical.end(); i++){
+			report << '\n' << i->entity << " (" << i->count << ")";
 		}
 	}
 
-	lst_owners.sort(greater<occurrences>());
+	return;
+}
 
-	//for each server, or until the max number of owners to display is reached...
-	list<occurrences>::iterator k = lst_owners.begin();
-	int owner = 0;
-	for(; (owner < SUMMARY_OWNERS) && (k != lst_owners.end()); owner++, k++){
+//add the directories with the most files on any server to the summary
+void summarize_directories(ReportBuffer& report, const vector<directory_count>& directories){
 
-		//display the total number of WWFs for the owner
-		report << ' ' << setw(COL_WIDTH - 2) << left << k->entity
-			<< "| " << setw(COL_WIDTH - 2) << left << k->count << "| " << endl;
+	//determine the directories with the most files on any server
+	BoundedHeap<directory_count, more_files> top_directories(max_directories());
+	for(vector<directory_count>::const_iterator i = directories.begin(); i != directories.end(); i++){
+		top_directories.push(*i);
+	}
 
-		//for each server which has the owner, or until the max number of top servers to display is reached...
-		list<WWF_data>::iterator j = lst_WWF.begin();
-		int top_server = 0;
-		for(; (top_server < HIGH_VOLUME) && (j != lst_WWF.end()); j++){
-			if(j->owner == k->entity){
+	vector<directory_count> lst_directories = top_directories.sorted(); //list of directories by number of WWFs
 
-				//display the number of WWFs for the server
-				report << setw(COL_WIDTH) << right << '|' << setw(COL_WIDTH + 1) << right << " | "
-					<< setw(COL_WIDTH) << left << j->server
-					<< setw(COL_WIDTH/2) << right << j->count << endl;
+	if(!lst_directories.empty()){
 
-				top_server++;
-			}
+		report << "\n\n\n" << " Most Files by Directory" << '\n'
+			<< align_right("", 25, '-') << "\n\n"
+			<< ' ' << align_left("Server", COL_WIDTH)
+			<< ' ' << align_left("# of Files", COL_WIDTH)
+			<< "Directory" << '\n'
+			<< align_right("+", COL_WIDTH, '-')
+			<< align_right("+", COL_WIDTH, '-')
+			<< align_right("", COL_WIDTH + COL_WIDTH/2 + 1, '-') << '\n';
+
+		//for each directory, up to the max number of directories to display...
+		for(vector<directory_count>::iterator i = lst_directories.begin(); i != lst_directories.end(); i++){
+			report << ' ' << align_left(i->server, COL_WIDTH - 2)
+				<< "| " << align_left(i->files, COL_WIDTH - 2) << "| " << i->directory << '\n';
 		}
-		report << setw(COL_WIDTH) << right << '|' << setw(COL_WIDTH + 1) << right << " | " << endl;
 	}
 
 
-	list<occurrences> lst_num_critical; //list of the number of critical files per server
+}
 
-	//count the number of critical files an each server
-	for(list<WWF_data>::iterator i = lst_WWF.begin(); i != lst_WWF.end(); i++){
+//the count as it's shown in the approximate summary, e.g. "1316" or "1290..1316" when only its range is known
+string estimated(const estimated_count& count){
 
-		//if this entry has no critical files, move on
-		if(i->critical == 0) continue;
+	ostringstream text;
+	if(count.low < count.high){
+		text << count.low << "..";
+	}
+	text << count.high;
 
-		//for each server/owner pair, we look for the sum of the critical files for the server and update it with the new files
-		bool existing_element = false;
-		for (list<occurrences>::iterator j = lst_num_critical.begin(); j != lst_num_critical.end(); j++){
-			if(i->server == j->entity){
-				j->count += i->critical;
+	return text.str();
+}
 
-				existing_element = true;
-				break;
-			}
+//make the summary from the estimates in summary, with the same sections as the exact summary
+void summarize_approximate(ReportBuffer& report, const ApproximateSummary& summary, const vector<directory_count>& directories){
+
+	report << "WWF Summary Report" << "\n\n";
+
+	if(summary.empty()){
+		report << "There are no WWFs to report.";
+		return;
+	}
+
+	report << "The counts are estimates, made in " << (summary.memory() / (1024 * 1024)) << " MB (APPROXIMATE_MEMORY)." << '\n'
+		<< "A count shown as low..high is somewhere in that range, and the other counts are exact." << '\n'
+		<< "The number of owners on each server is estimated to within about "
+		<< (unsigned long long)(summary.owners_error() * 100) << '.' << ((unsigned long long)(summary.owners_error() * 1000 + 0.5) % 10)
+		<< "% (one standard error)." << "\n\n"
+		<< summary.total_files() << " WWFs were found on about " << (unsigned long long)(summary.distinct_servers() + 0.5)
+		<< " servers, owned by about " << (unsigned long long)(summary.distinct_owners() + 0.5) << " owners." << "\n\n\n";
+
+	//the max number of items to show, negative preferences show nothing
+	const size_t max_servers = (SUMMARY_SERVERS > 0) ? SUMMARY_SERVERS : 0;
+	const size_t max_owners = (SUMMARY_OWNERS > 0) ? SUMMARY_OWNERS : 0;
+	const size_t max_high_volume = (HIGH_VOLUME > 0) ? HIGH_VOLUME : 0;
+
+	report << " Most Files by Server" << '\n'
+		<< align_right("", 25, '-') << "\n\n"
+		<< ' ' << align_left("Server", COL_WIDTH)
+		<< ' ' << align_left("# of Files", COL_WIDTH)
+		<< "Top Owners" << '\n'
+		<< align_right("+", COL_WIDTH, '-')
+		<< align_right("+", COL_WIDTH, '-')
+		<< align_right("", COL_WIDTH + COL_WIDTH/2 + 1, '-') << '\n';
+
+	vector<estimated_count> lst_servers; //list of servers by number of WWFs
+	vector<vector<estimated_count> > server_owners; //the top owners of each of them
+	summary.top_servers(max_servers, max_high_volume, lst_servers, server_owners);
+
+	//for each server, up to the max number of servers to display...
+	for(size_t i = 0; i < lst_servers.size(); i++){
+
+		//display the total number of WWFs and the number of owners for the server
+		report << ' ' << align_left(lst_servers[i].name, COL_WIDTH - 2)
+			<< "| " << align_left(estimated(lst_servers[i]), COL_WIDTH - 2) << "| "
+			<< "about " << (unsigned long long)(lst_servers[i].owners + 0.5) << " owners" << '\n';
+
+		//for each owner on the server, up to the max number of top owners to display...
+		for(vector<estimated_count>::iterator j = server_owners[i].begin(); j != server_owners[i].end(); j++){
+
+			//display the number of WWFs for the owner
+			report << align_right("|", COL_WIDTH) << align_right(" | ", COL_WIDTH + 1)
+				<< align_left(j->name, COL_WIDTH)
+				<< align_right(estimated(*j), COL_WIDTH/2) << '\n';
 		}
+		report << align_right("|", COL_WIDTH) << align_right(" | ", COL_WIDTH + 1) << '\n';
+	}
 
-		//if the server does not have a sum yet, we add it
-		if(!existing_element){
-			occurrences new_server;
+	report << "\n\n\n";
 
-			new_server.entity = i->server;
-			new_server.count = i->critical;
 
-			lst_num_critical.push_front(new_server);
+	report << " Most Files by Owner" << '\n'
+		<< align_right("", 25, '-') << "\n\n"
+		<< ' ' << align_left("Owner", COL_WIDTH)
+		<< ' ' << align_left("# of Files", COL_WIDTH)
+		<< "Servers" << '\n'
+		<< align_right("+", COL_WIDTH, '-')
+		<< align_right("+", COL_WIDTH, '-')
+		<< align_right("", COL_WIDTH + COL_WIDTH/2 + 1, '-') << '\n';
+
+	vector<estimated_count> lst_owners; //list of owners by number of WWFs
+	vector<vector<estimated_count> > owner_servers; //the top servers of each of them
+	summary.top_owners(max_owners, max_high_volume, lst_owners, owner_servers);
+
+	//for each owner, up to the max number of owners to display...
+	for(size_t k = 0; k < lst_owners.size(); k++){
+
+		//display the total number of WWFs for the owner
+		report << ' ' << align_left(lst_owners[k].name, COL_WIDTH - 2)
+			<< "| " << align_left(estimated(lst_owners[k]), COL_WIDTH - 2) << "| " << '\n';
+
+		//for each server which has the owner, up to the max number of top servers to display...
+		for(vector<estimated_count>::iterator j = owner_servers[k].begin(); j != owner_servers[k].end(); j++){
+
+			//display the number of WWFs for the server
+			report << align_right("|", COL_WIDTH) << align_right(" | ", COL_WIDTH + 1)
+				<< align_left(j->name, COL_WIDTH)
+				<< align_right(estimated(*j), COL_WIDTH/2) << '\n';
 		}
+		report << align_right("|", COL_WIDTH) << align_right(" | ", COL_WIDTH + 1) << '\n';
 	}
 
-	lst_num_critical.sort(greater<occurrences>());
+
+	summarize_directories(report, directories);
+
 
 	//display the servers with critical files
+	vector<estimated_count> lst_num_critical = summary.critical_servers();
+
 	if(lst_num_critical.size() > 0){
 
-		report << endl << endl << endl << "Critical files have been found on the following servers:";
+		report << "\n\n\n" << "Critical files have been found on the following servers:";
 
-		for(list<occurrences>::iterator i = lst_num_critical.begin(); i != lst_num_critical.end(); i++){
-			report << endl << i->entity << " (" << i->count << ")";
+		for(vector<estimated_count>::iterator i = lst_num_critical.begin(); i != lst_num_critical.end(); i++){
+			report << '\n' << i->name << " (" << estimated(*i) << ")";
 		}
 	}
-
-	return;
 }
@@ -0,0 +1,709 @@
+/*
+
+WWF Benchmark.cpp
+
+This program measures the throughput of the parts of WWF Analyzer,
+comparing them against the way they were previously done where there is one.
+
+Build it with the sources it uses, e.g.:
+g++ -std=c++17 -O2 "WWF Benchmark.cpp" ReportParser.cpp MappedFile.cpp FileClassifier.cpp RuleAutomaton.cpp ClassificationCache.cpp Hash.cpp Serialization.cpp WWFStore.cpp SymbolTable.cpp Arena.cpp CriticalFiles.cpp Encoding.cpp "data structs.cpp" -o "WWF Benchmark"
+
+Reports to measure can be made with WWF Report Generator.cpp
+
+Usage:
+WWF Benchmark parse <report file>
+	parses the report with getline + istringstream (the old way) and with ReportParser over the mapped file
+WWF Benchmark classify [report file]
+	classifies the world writable files in the report (or generated paths if no report is given)
+	with 10, 100 and 1000 rules, using list scans (the old way), the compiled FileClassifier and a ClassificationCache
+WWF Benchmark pipeline <preferences file> <report file>...
+	analyzes the reports with the given preferences one stage at a time (parse, classify, aggregate, summarize, write),
+	and shows the time, lines/s and MB/s of each stage and the peak memory used by the process
+
+*/
+
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <list>
+#include <vector>
+#include <random>
+#include <limits>
+#include <memory>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include "MappedFile.h"
+#include "ReportParser.h"
+#include "FileClassifier.h"
+#include "ClassificationCache.h"
+#include "WWFStore.h"
+#include "CriticalFiles.h"
+#include "BoundedHeap.h"
+using namespace std;
+
+//the results of parsing a report, used to check that both ways of parsing agree
+struct parse_result{
+	unsigned long lines; //the number of lines read
+	unsigned long valid; //the number of lines with valid data
+	unsigned long world_writable; //the number of valid lines for world writable files
+	unsigned long long checksum; //a hash of the owners and file names of the world writable files
+};
+
+static void print_throughput(const string& name, double seconds, unsigned long long bytes, const parse_result& result);
+static int benchmark_parse(const string& file_name);
+static int benchmark_classify(const string& file_name);
+static int benchmark_pipeline(const string& pref_file, const vector<string>& file_names);
+
+
+int main(int argc, char* argv[]){
+
+	if(argc < 2){
+		cerr << "Usage: " << argv[0] << " parse <report file>" << endl
+			<< "       " << argv[0] << " classify [report file]" << endl
+			<< "       " << argv[0] << " pipeline <preferences file> <report file>..." << endl;
+		return EXIT_FAILURE;
+	}
+
+	const string mode = argv[1];
+
+	if((mode == "parse") && (argc > 2)){
+		return benchmark_parse(argv[2]);
+	}
+	else if(mode == "classify"){
+		return benchmark_classify((argc > 2) ? argv[2] : "");
+	}
+	else if((mode == "pipeline") && (argc > 3)){
+		return benchmark_pipeline(argv[2], vector<string>(argv + 3, argv + argc));
+	}
+
+	cerr << "Error: Unknown benchmark \"" << mode << "\"." << endl;
+	return EXIT_FAILURE;
+}
+
+//add the characters of str to a running FNV-1a hash
+static unsigned long long hash_add(unsigned long long hash, string_view str){
+	for(size_t i = 0; i < str.size(); i++){
+		hash = (hash ^ (unsigned char)str[i]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+//remove leading and trailing white space from str (as WWF Analyzer used to)
+static string trim(const string str){
+
+	const string whitespaces = " \t\n\r";
+
+	size_t first = str.find_first_not_of(whitespaces);
+	if(first == string::npos) return "";
+
+	size_t last = str.find_last_not_of(whitespaces);
+	return str.substr(first, (last - first + 1));
+}
+
+//parse the report the way that analyze() used to: getline, istringstream and trim
+static parse_result parse_old(const string& file_name){
+
+	parse_result result = {0, 0, 0, 14695981039346656037ULL};
+
+	ifstream file (file_name.c_str());
+
+	while(file.good()){
+
+		string line;
+		getline(file,line);
+		result.lines++;
+
+		istringstream ss;
+		ss.str(line);
+		string permissions, owner, name, discard;
+		ss >> permissions >> discard >> owner >> discard >> discard >> discard >> discard >> discard;
+		getline(ss,name);
+		name = trim(name);
+
+		if(!ss.fail() && (name != "") && (permissions.size() == 10) && (permissions.at(0) == '-'
+			|| permissions.at(0) == 'd' || permissions.at(0) == 'l'
+			|| permissions.at(0) == 'b' || permissions.at(0) == 'c'
+			|| permissions.at(0) == 'p' || permissions.at(0) == 's')){
+
+			result.valid++;
+
+			if(permissions.at(8) == 'w'){
+				result.world_writable++;
+				result.checksum = hash_add(hash_add(result.checksum, owner), name);
+			}
+		}
+	}
+
+	return result;
+}
+
+//parse the report with ReportParser over the mapped file
+static parse_result parse_new(const string& file_name){
+
+	parse_result result = {0, 0, 0, 14695981039346656037ULL};
+
+	MappedFile file (file_name);
+	ReportParser parser(file.contents());
+	string_view line;
+
+	while(parser.next_line(line)){
+
+		result.lines++;
+
+		report_line fields;
+		if(ReportParser::parse_line(line, fields)){
+
+			result.valid++;
+
+			if(ReportParser::world_writable(fields)){
+				result.world_writable++;
+				result.checksum = hash_add(hash_add(result.checksum, fields.owner), fields.file_name);
+			}
+		}
+	}
+
+	return result;
+}
+
+static void print_throughput(const string& name, double seconds, unsigned long long bytes, const parse_result& result){
+	cout << ' ' << setw(24) << left << name
+		<< setw(12) << right << fixed << setprecision(3) << seconds << " s"
+		<< setw(14) << right << setprecision(1) << (bytes / seconds / 1e6) << " MB/s"
+		<< setw(14) << right << setprecision(0) << (result.lines / seconds) << " lines/s" << endl;
+}
+
+static int benchmark_parse(const string& file_name){
+
+	unsigned long long bytes;
+	{
+		MappedFile file (file_name);
+		if(!file.is_open()){
+			cerr << "Error: " << file_name << " could not be opened." << endl;
+			return EXIT_FAILURE;
+		}
+		bytes = file.contents().size();
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	const parse_result old_result = parse_old(file_name);
+	const double old_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	const parse_result new_result = parse_new(file_name);
+	const double new_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "Parsing " << file_name << " (" << bytes << " bytes, " << new_result.lines << " lines)" << endl;
+	print_throughput("getline + istringstream", old_seconds, bytes, old_result);
+	print_throughput("ReportParser (mapped)", new_seconds, bytes, new_result);
+	cout << " Speedup: " << setprecision(2) << (old_seconds / new_seconds) << "x" << endl;
+
+	//both ways must find the same data
+	if((old_result.valid != new_result.valid) || (old_result.world_writable != new_result.world_writable)
+		|| (old_result.checksum != new_result.checksum)){
+		cerr << "Error: The parsers disagree ("
+			<< old_result.valid << " vs " << new_result.valid << " valid lines, "
+			<< old_result.world_writable << " vs " << new_result.world_writable << " world writable)." << endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+
+//FileClassifier as it was before the rules were compiled: a find() per substring and a comparison per extension
+class ListClassifier{
+
+	list<string> extensions;
+	list<string> substrings;
+
+public:
+	void add_extension(string extension){
+		extensions.push_front(extension);
+	}
+	void add_substring(string substring){
+		substrings.push_front(substring);
+	}
+
+	bool satisfies(string file_name){
+
+		for(list<string>::iterator i = substrings.begin(); i != substrings.end(); i++){
+			if(file_name.find(*i) != string::npos){
+				return true;
+			}
+		}
+
+		const string file_extension = file_name.substr(file_name.find_last_of("\\/.") + 1);
+
+		for(list<string>::iterator i = extensions.begin(); i != extensions.end(); i++){
+			if(file_extension == *i){
+				return true;
+			}
+		}
+
+		return false;
+	}
+};
+
+//get the paths to classify: the world writable files in the report, or generated paths if there is no report
+static vector<string> get_paths(const string& file_name){
+
+	vector<string> paths;
+
+	if(file_name != ""){
+		MappedFile file (file_name);
+		ReportParser parser(file.contents());
+		string_view line;
+
+		while(parser.next_line(line)){
+			report_line fields;
+			if(ReportParser::parse_line(line, fields) && ReportParser::world_writable(fields)){
+				paths.push_back(string(fields.file_name));
+			}
+		}
+	}
+	else{
+		mt19937 random(1);
+		const char* const roots[] = {"/home/", "/tmp/", "/var/", "/opt/", "/srv/", "/data/"};
+		const char* const extensions[] = {"log", "txt", "sh", "c", "cfg", "tmp", "dat", "out"};
+
+		for(int i = 0; i < 500000; i++){
+			string path = roots[random() % 6];
+			const unsigned depth = 1 + random() % 6;
+			for(unsigned d = 0; d < depth; d++){
+				path += "dir" + to_string(random() % 2000) + "/";
+			}
+			path += "file" + to_string(random() % 100000) + "." + extensions[random() % 8];
+			paths.push_back(path);
+		}
+	}
+
+	return paths;
+}
+
+//make num_rules rules, half extensions and half substrings
+//some of the substrings are directories taken from the paths, so that a realistic share of the paths match
+static void make_rules(unsigned num_rules, const vector<string>& paths, FileClassifier& compiled, ListClassifier& listed){
+
+	mt19937 random(num_rules);
+
+	for(unsigned i = 0; i < num_rules; i++){
+
+		string rule;
+
+		if(i % 2 == 0){
+			rule = "ext" + to_string(i);
+			if(i % 8 == 0) rule = (i % 16 == 0) ? "sh" : "cfg";
+
+			compiled.add_extension(rule);
+			listed.add_extension(rule);
+		}
+		else{
+			rule = "/dir" + to_string(random() % 100000) + "/";
+			if((i % 5 == 1) && !paths.empty()){
+				const string& path = paths[random() % paths.size()];
+				const size_t last_slash = path.find_last_of('/');
+				if(last_slash != string::npos && last_slash > 0){
+					rule = path.substr(path.find_last_of('/', last_slash - 1), last_slash + 1 - path.find_last_of('/', last_slash - 1));
+				}
+			}
+
+			compiled.add_substring(rule);
+			listed.add_substring(rule);
+		}
+	}
+
+	compiled.compile();
+}
+
+static int benchmark_classify(const string& file_name){
+
+	const vector<string> paths = get_paths(file_name);
+
+	cout << "Classifying " << paths.size() << " paths" << endl
+		<< ' ' << setw(8) << left << "Rules" << setw(18) << right << "List scan (s)"
+		<< setw(18) << right << "Compiled (s)" << setw(18) << right << "Cached (s)" << setw(12) << right << "Speedup"
+		<< setw(12) << right << "Hit rate" << setw(12) << right << "Matched" << endl;
+
+	const unsigned rule_counts[] = {10, 100, 1000};
+
+	for(int r = 0; r < 3; r++){
+
+		FileClassifier compiled;
+		ListClassifier listed;
+		make_rules(rule_counts[r], paths, compiled, listed);
+
+		unsigned long listed_matches = 0;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for(vector<string>::const_iterator i = paths.begin(); i != paths.end(); i++){
+			if(listed.satisfies(*i)) listed_matches++;
+		}
+		const double listed_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		unsigned long compiled_matches = 0;
+		start = chrono::steady_clock::now();
+		for(vector<string>::const_iterator i = paths.begin(); i != paths.end(); i++){
+			if(compiled.satisfies(*i)) compiled_matches++;
+		}
+		const double compiled_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		ClassificationCache cached (compiled);
+		unsigned long cached_matches = 0;
+		start = chrono::steady_clock::now();
+		for(vector<string>::const_iterator i = paths.begin(); i != paths.end(); i++){
+			if(cached.satisfies(*i)) cached_matches++;
+		}
+		const double cached_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		cout << ' ' << setw(8) << left << rule_counts[r]
+			<< setw(18) << right << fixed << setprecision(4) << listed_seconds
+			<< setw(18) << right << compiled_seconds
+			<< setw(18) << right << cached_seconds
+			<< setw(11) << right << setprecision(1) << (listed_seconds / cached_seconds) << 'x'
+			<< setw(11) << right << (100.0 * cached.hit_count() / paths.size()) << '%'
+			<< setw(12) << right << compiled_matches << endl;
+
+		//every way must classify the same paths
+		ClassificationCache check (compiled);
+		for(vector<string>::const_iterator i = paths.begin(); i != paths.end(); i++){
+			const bool listed_result = listed.satisfies(*i);
+			if((listed_result != compiled.satisfies(*i)) || (listed_result != check.satisfies(*i))){
+				cerr << "Error: The classifiers disagree on " << *i << endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+
+//the preferences which affect the analysis, read the same way as WWF Analyzer reads them
+struct pipeline_prefs{
+	FileClassifier ignore_files;
+	FileClassifier critical_files;
+	unsigned long max_critical;
+	size_t summary_servers;
+	size_t summary_owners;
+	size_t high_volume;
+};
+
+//a report which has been mapped and parsed
+struct pipeline_report{
+	string server_name;
+	unique_ptr<MappedFile> file;
+	vector<report_line> lines; //the lines with valid data
+	vector<char> classes; //for each line, 0 if it's ignored (or not world writable), 1 if it's a WWF, 2 if it's a critical WWF
+	unsigned long WWFs;
+	unique_ptr<CriticalFiles> critical_files;
+};
+
+//the time taken by each stage
+struct pipeline_times{
+	double parse;
+	double classify;
+	double aggregate;
+	double summarize;
+	double write;
+};
+
+//the peak resident set size of the process in KB, or 0 if it can't be found
+static unsigned long long peak_rss_kb(){
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))){
+		return counters.PeakWorkingSetSize / 1024;
+	}
+	return 0;
+#else
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024; //bytes on macOS
+#else
+	return usage.ru_maxrss; //KB on Linux
+#endif
+#endif
+}
+
+static double seconds_since(chrono::steady_clock::time_point start){
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+//load the rules and limits from a WWF Analyzer preferences file
+static bool load_pipeline_prefs(const string& pref_file, pipeline_prefs& prefs){
+
+	prefs.max_critical = numeric_limits<unsigned long>::max();
+	prefs.summary_servers = prefs.summary_owners = prefs.high_volume = numeric_limits<size_t>::max();
+
+	ifstream file (pref_file.c_str());
+	if(!file.is_open()){
+		cerr << "Error: " << pref_file << " could not be opened." << endl;
+		return false;
+	}
+
+	string line, error;
+	while(getline(file, line)){
+
+		const string value = trim(line.size() > 2 ? line.substr(2) : "");
+		const long long number = atoll(line.substr(line.find_last_of('=') + 1).c_str());
+
+		if(line.compare(0,12,"MAX_CRITICAL") == 0) prefs.max_critical = (number > 0) ? number : 0;
+		else if(line.compare(0,15,"SUMMARY_SERVERS") == 0) prefs.summary_servers = (number > 0) ? number : 0;
+		else if(line.compare(0,14,"SUMMARY_OWNERS") == 0) prefs.summary_owners = (number > 0) ? number : 0;
+		else if(line.compare(0,11,"HIGH_VOLUME") == 0) prefs.high_volume = (number > 0) ? number : 0;
+		else if((line.compare(0,2,"i.") == 0) && (value != "")) prefs.ignore_files.add_extension(value);
+		else if((line.compare(0,2,"i:") == 0) && (value != "")) prefs.ignore_files.add_substring(value);
+		else if((line.compare(0,2,"c.") == 0) && (value != "")) prefs.critical_files.add_extension(value);
+		else if((line.compare(0,2,"c:") == 0) && (value != "")) prefs.critical_files.add_substring(value);
+		else if(((line.compare(0,2,"i~") == 0) && !prefs.ignore_files.add_glob(value, error))
+			|| ((line.compare(0,2,"i%") == 0) && !prefs.ignore_files.add_regex(value, error))
+			|| ((line.compare(0,2,"c~") == 0) && !prefs.critical_files.add_glob(value, error))
+			|| ((line.compare(0,2,"c%") == 0) && !prefs.critical_files.add_regex(value, error))){
+			cerr << "Error: " << line << ": " << error << endl;
+			return false;
+		}
+	}
+
+	prefs.ignore_files.compile();
+	prefs.critical_files.compile();
+
+	return true;
+}
+
+//map and parse the reports
+static bool pipeline_parse(const vector<string>& file_names, vector<pipeline_report>& reports,
+	unsigned long long& bytes, unsigned long long& lines){
+
+	for(vector<string>::const_iterator i = file_names.begin(); i != file_names.end(); i++){
+
+		pipeline_report report;
+
+		//the server name is everything before the first non-alphanumeric character of the file name
+		const string base_name = i->substr(i->find_last_of("\\/") + 1);
+		size_t end = 0;
+		while((end < base_name.size()) && isalnum((unsigned char)base_name[end])) end++;
+		report.server_name = base_name.substr(0, end);
+
+		report.file.reset(new MappedFile(*i));
+		if(!report.file->is_open()){
+			cerr << "Error: " << *i << " could not be opened." << endl;
+			return false;
+		}
+		bytes += report.file->contents().size();
+
+		ReportParser parser(report.file->contents());
+		string_view line;
+		report_line fields;
+		while(parser.next_line(line)){
+			lines++;
+			if(ReportParser::parse_line(line, fields)){
+				report.lines.push_back(fields);
+			}
+		}
+
+		reports.push_back(move(report));
+	}
+
+	return true;
+}
+
+//classify the world writable files of each report as ignored, WWFs or critical WWFs
+static void pipeline_classify(const pipeline_prefs& prefs, vector<pipeline_report>& reports){
+
+	for(vector<pipeline_report>::iterator r = reports.begin(); r != reports.end(); r++){
+
+		r->classes.resize(r->lines.size());
+
+		ClassificationCache ignore_files (prefs.ignore_files);
+		ClassificationCache critical_files (prefs.critical_files);
+
+		for(size_t l = 0; l < r->lines.size(); l++){
+			const report_line& fields = r->lines[l];
+
+			if(ReportParser::world_writable(fields) && !ignore_files.satisfies(fields.file_name)){
+				r->classes[l] = critical_files.satisfies(fields.file_name) ? 2 : 1;
+			}
+			else{
+				r->classes[l] = 0;
+			}
+		}
+	}
+}
+
+//count the WWFs of each owner/server pair and collect the critical files
+static void pipeline_aggregate(const pipeline_prefs& prefs, vector<pipeline_report>& reports, WWFStore& store){
+
+	for(vector<pipeline_report>::iterator r = reports.begin(); r != reports.end(); r++){
+
+		const symbol server = store.intern_server(r->server_name);
+		r->WWFs = 0;
+		r->critical_files.reset(new CriticalFiles(prefs.max_critical));
+
+		for(size_t l = 0; l < r->lines.size(); l++){
+			if(r->classes[l] == 0) continue;
+
+			const symbol owner = store.intern_owner(r->lines[l].owner);
+			WWF_data& WWF = store.entry(server, owner);
+			WWF.count += 1;
+			r->WWFs++;
+
+			if(r->classes[l] == 2){
+				WWF.critical += 1;
+				r->critical_files->add(store.owner_name(owner), r->lines[l].file_name);
+			}
+		}
+	}
+}
+
+//the data shown in the summary report
+struct pipeline_summary{
+	vector<occurrences> top_servers;
+	vector<occurrences> top_owners;
+	vector<vector<const WWF_data*> > server_high_volume; //for each of the top servers
+	vector<vector<const WWF_data*> > owner_high_volume; //for each of the top owners
+};
+
+//find the top servers and owners and their highest volume pairs, as summarize() does
+static void pipeline_summarize(const pipeline_prefs& prefs, const WWFStore& store, pipeline_summary& summary){
+
+	vector<unsigned long> server_files, owner_files, server_critical;
+	store.totals(server_files, owner_files, server_critical);
+
+	BoundedHeap<occurrences, greater<occurrences> > top_servers(prefs.summary_servers);
+	for(symbol s = 0; s < server_files.size(); s++){
+		occurrences server = {store.server_name(s), server_files[s]};
+		if(top_servers.would_keep(server)) top_servers.push(server);
+	}
+	summary.top_servers = top_servers.sorted();
+
+	BoundedHeap<occurrences, greater<occurrences> > top_owners(prefs.summary_owners);
+	for(symbol o = 0; o < owner_files.size(); o++){
+		occurrences owner = {store.owner_name(o), owner_files[o]};
+		if(top_owners.would_keep(owner)) top_owners.push(owner);
+	}
+	summary.top_owners = top_owners.sorted();
+
+	for(vector<occurrences>::iterator i = summary.top_servers.begin(); i != summary.top_servers.end(); i++){
+		summary.server_high_volume.push_back(store.sorted_server_pairs(store.server_id(i->entity), prefs.high_volume));
+	}
+	for(vector<occurrences>::iterator i = summary.top_owners.begin(); i != summary.top_owners.end(); i++){
+		summary.owner_high_volume.push_back(store.sorted_owner_pairs(store.owner_id(i->entity), prefs.high_volume));
+	}
+}
+
+//format the details report of each server and the summary report
+//the reports are formatted in memory, so that the disk is not measured
+static unsigned long long pipeline_write(const vector<pipeline_report>& reports, const WWFStore& store, const pipeline_summary& summary){
+
+	unsigned long long bytes = 0;
+	const int width = 16;
+
+	for(vector<pipeline_report>::const_iterator r = reports.begin(); r != reports.end(); r++){
+
+		ostringstream report;
+		report << r->server_name << " WWF Details Report" << endl << endl
+			<< "# of WWFs:\t" << r->WWFs << endl
+			<< "Critical Files:\t" << r->critical_files->count() << endl << endl << endl;
+
+		vector<const WWF_data*> pairs = store.sorted_server_pairs(store.server_id(r->server_name));
+		for(vector<const WWF_data*>::iterator i = pairs.begin(); i != pairs.end(); i++){
+			report << ' ' << setw(width - 2) << left << store.owner_name((*i)->owner) << "| " << (*i)->count;
+			if((*i)->critical > 0) report << " (" << (*i)->critical << ")";
+			report << endl;
+		}
+
+		r->critical_files->for_each_sorted([&report, width](string_view owner, string_view file){
+			report << endl << ' ' << setw(width - 2) << left << owner << file;
+		});
+
+		bytes += report.str().size();
+	}
+
+	ostringstream report;
+	report << "WWF Summary Report" << endl << endl;
+	for(size_t s = 0; s < summary.top_servers.size(); s++){
+		report << ' ' << setw(width) << left << summary.top_servers[s].entity << ' ' << setw(width) << summary.top_servers[s].count;
+		for(size_t i = 0; i < summary.server_high_volume[s].size(); i++){
+			report << store.owner_name(summary.server_high_volume[s][i]->owner) << ' ';
+		}
+		report << endl;
+	}
+	for(size_t o = 0; o < summary.top_owners.size(); o++){
+		report << ' ' << setw(width) << left << summary.top_owners[o].entity << ' ' << setw(width) << summary.top_owners[o].count;
+		for(size_t i = 0; i < summary.owner_high_volume[o].size(); i++){
+			report << store.server_name(summary.owner_high_volume[o][i]->server) << ' ';
+		}
+		report << endl;
+	}
+	bytes += report.str().size();
+
+	return bytes;
+}
+
+static void print_stage(const string& name, double seconds, unsigned long long bytes, unsigned long long lines){
+	cout << ' ' << setw(12) << left << name
+		<< setw(12) << right << fixed << setprecision(3) << seconds << " s"
+		<< setw(14) << right << setprecision(1) << ((seconds > 0) ? bytes / seconds / 1e6 : 0) << " MB/s"
+		<< setw(16) << right << setprecision(0) << ((seconds > 0) ? lines / seconds : 0) << " lines/s" << endl;
+}
+
+static int benchmark_pipeline(const string& pref_file, const vector<string>& file_names){
+
+	pipeline_prefs prefs;
+	if(!load_pipeline_prefs(pref_file, prefs)) return EXIT_FAILURE;
+
+	pipeline_times times;
+	vector<pipeline_report> reports;
+	unsigned long long bytes = 0, lines = 0;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	if(!pipeline_parse(file_names, reports, bytes, lines)) return EXIT_FAILURE;
+	times.parse = seconds_since(start);
+
+	start = chrono::steady_clock::now();
+	pipeline_classify(prefs, reports);
+	times.classify = seconds_since(start);
+
+	WWFStore store;
+	start = chrono::steady_clock::now();
+	pipeline_aggregate(prefs, reports, store);
+	times.aggregate = seconds_since(start);
+
+	pipeline_summary summary;
+	start = chrono::steady_clock::now();
+	pipeline_summarize(prefs, store, summary);
+	times.summarize = seconds_since(start);
+
+	start = chrono::steady_clock::now();
+	const unsigned long long written = pipeline_write(reports, store, summary);
+	times.write = seconds_since(start);
+
+	unsigned long WWFs = 0;
+	for(vector<pipeline_report>::iterator r = reports.begin(); r != reports.end(); r++){
+		WWFs += r->WWFs;
+	}
+
+	const double total = times.parse + times.classify + times.aggregate + times.summarize + times.write;
+
+	cout << "Analyzing " << reports.size() << " reports (" << bytes << " bytes, " << lines << " lines, "
+		<< WWFs << " WWFs, " << store.num_servers() << " servers, " << store.num_owners() << " owners)" << endl;
+	print_stage("parse", times.parse, bytes, lines);
+	print_stage("classify", times.classify, bytes, lines);
+	print_stage("aggregate", times.aggregate, bytes, lines);
+	print_stage("summarize", times.summarize, bytes, lines);
+	print_stage("write", times.write, bytes, lines);
+	print_stage("total", total, bytes, lines);
+	cout << " Reports written: " << written << " bytes" << endl
+		<< " Peak RSS: " << peak_rss_kb() << " KB" << endl;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,296 @@
+/*
+
+WWF Report Generator.cpp
+
+This program generates synthetic world writable files reports, in the "ls -l" format that WWF Analyzer reads,
+so that the analysis can be measured reproducibly (see WWF Benchmark.cpp)
+
+Build it on its own, e.g.:
+g++ -std=c++17 -O2 "WWF Report Generator.cpp" -o "WWF Report Generator"
+
+Usage:
+WWF Report Generator [options]
+	--output <directory>	where to write the reports, it's created if it doesn't exist (default: the current directory)
+	--servers <n>		number of reports to generate, one per server (default: 10)
+	--owners <n>		number of distinct owners across all servers (default: 50)
+	--lines <n>		number of lines in each report (default: 100000)
+	--depth <n>		max number of directories in a path (default: 8)
+	--skew <s>		how unevenly the owners and directories are used, 0 is uniform,
+				1 and above concentrate the files on a few of them (default: 1)
+	--writable <p>		fraction of the files which are world writable (default: 0.5)
+	--rules <n>		also write a preferences file with n ignore/critical rules (default: 0, no file)
+	--prefs <file>		where to write the preferences file (default: "WWF Analyzer.pref" in the current directory,
+				which is where WWF Analyzer looks for it, rather than with the reports where it would be analyzed)
+	--seed <n>		seed for the random numbers, the same seed gives the same reports (default: 1)
+
+*/
+
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+using namespace std;
+
+//the settings for the reports to generate
+struct generator_settings{
+	string output;
+	unsigned servers;
+	unsigned owners;
+	unsigned long lines;
+	unsigned depth;
+	double skew;
+	double writable;
+	unsigned rules;
+	string prefs;
+	unsigned long seed;
+};
+
+//picks integers in [0, n) with a Zipf distribution, so that 0 is the most common
+//with a skew of 0 every integer is equally likely
+class ZipfPicker{
+
+	vector<double> cumulative; //cumulative[i] is the probability of picking an integer <= i
+	uniform_real_distribution<double> uniform;
+
+public:
+	ZipfPicker(unsigned n, double skew) : cumulative(n), uniform(0.0, 1.0){
+
+		double sum = 0;
+		for(unsigned i = 0; i < n; i++){
+			sum += 1.0 / pow(i + 1.0, skew);
+			cumulative[i] = sum;
+		}
+		for(unsigned i = 0; i < n; i++){
+			cumulative[i] /= sum;
+		}
+	}
+
+	unsigned pick(mt19937_64& random){
+		const size_t i = lower_bound(cumulative.begin(), cumulative.end(), uniform(random)) - cumulative.begin();
+		return (i < cumulative.size()) ? i : cumulative.size() - 1;
+	}
+};
+
+static bool parse_settings(int argc, char* argv[], generator_settings& settings);
+static bool write_report(const generator_settings& settings, unsigned server, mt19937_64& random,
+	ZipfPicker& owners, ZipfPicker& directories, const vector<string>& directory_names);
+static bool write_prefs(const generator_settings& settings, const vector<string>& directory_names, mt19937_64& random);
+static string server_name(unsigned server);
+static string owner_name(unsigned owner);
+
+const char* const EXTENSIONS[] = {"log", "txt", "sh", "c", "h", "cfg", "conf", "tmp", "dat", "out", "pl", "py", "so", "bak"};
+const unsigned NUM_EXTENSIONS = sizeof(EXTENSIONS) / sizeof(EXTENSIONS[0]);
+const unsigned MAX_EXTENSION_RULES = NUM_EXTENSIONS / 2; //the rest of the extensions match no rule, so some files are neither ignored nor critical
+
+const char* const ROOTS[] = {"/home", "/tmp", "/var", "/opt", "/srv", "/data", "/usr/local", "/etc"};
+const unsigned NUM_ROOTS = sizeof(ROOTS) / sizeof(ROOTS[0]);
+
+const unsigned NUM_DIRECTORIES = 5000; //the number of distinct directory paths the files are placed in
+
+
+int main(int argc, char* argv[]){
+
+	generator_settings settings;
+	if(!parse_settings(argc, argv, settings)) return EXIT_FAILURE;
+
+	mt19937_64 random(settings.seed);
+
+	//make the directory paths, each from 1 to depth directories deep below one of the roots
+	//paths are built on each other, so that (like real file systems) many of them share prefixes
+	vector<string> directory_names;
+	directory_names.reserve(NUM_DIRECTORIES);
+	for(unsigned d = 0; d < NUM_DIRECTORIES; d++){
+
+		string path;
+		if((d < NUM_ROOTS) || (random() % 4 == 0)){
+			path = ROOTS[random() % NUM_ROOTS];
+		}
+		else{
+			path = directory_names[random() % directory_names.size()];
+		}
+
+		//limit the depth by counting the directories in the path
+		if((unsigned)count(path.begin(), path.end(), '/') >= settings.depth){
+			path = ROOTS[random() % NUM_ROOTS];
+		}
+
+		path += "/dir" + to_string(d);
+		directory_names.push_back(path);
+	}
+
+	ZipfPicker owners(settings.owners, settings.skew);
+	ZipfPicker directories(NUM_DIRECTORIES, settings.skew);
+
+	for(unsigned s = 0; s < settings.servers; s++){
+		if(!write_report(settings, s, random, owners, directories, directory_names)) return EXIT_FAILURE;
+	}
+
+	if(settings.rules > 0){
+		if(!write_prefs(settings, directory_names, random)) return EXIT_FAILURE;
+	}
+
+	cout << "Generated " << settings.servers << " reports of " << settings.lines << " lines in " << settings.output << endl;
+
+	return EXIT_SUCCESS;
+}
+
+//read the settings from the command line
+//returns false (after explaining why) if they're not valid
+static bool parse_settings(int argc, char* argv[], generator_settings& settings){
+
+	settings.output = ".";
+	settings.servers = 10;
+	settings.owners = 50;
+	settings.lines = 100000;
+	settings.depth = 8;
+	settings.skew = 1.0;
+	settings.writable = 0.5;
+	settings.rules = 0;
+	settings.prefs = "WWF Analyzer.pref";
+	settings.seed = 1;
+
+	for(int arg = 1; arg < argc; arg++){
+		const string option = argv[arg];
+
+		if(arg + 1 >= argc){
+			cerr << "Error: " << option << " needs a value." << endl;
+			return false;
+		}
+		const string value = argv[++arg];
+
+		if(option == "--output") settings.output = value;
+		else if(option == "--servers") settings.servers = strtoul(value.c_str(), NULL, 10);
+		else if(option == "--owners") settings.owners = strtoul(value.c_str(), NULL, 10);
+		else if(option == "--lines") settings.lines = strtoul(value.c_str(), NULL, 10);
+		else if(option == "--depth") settings.depth = strtoul(value.c_str(), NULL, 10);
+		else if(option == "--skew") settings.skew = strtod(value.c_str(), NULL);
+		else if(option == "--writable") settings.writable = strtod(value.c_str(), NULL);
+		else if(option == "--rules") settings.rules = strtoul(value.c_str(), NULL, 10);
+		else if(option == "--prefs") settings.prefs = value;
+		else if(option == "--seed") settings.seed = strtoul(value.c_str(), NULL, 10);
+		else{
+			cerr << "Error: Unknown option \"" << option << "\"." << endl;
+			return false;
+		}
+	}
+
+	if((settings.owners == 0) || (settings.depth == 0) || (settings.skew < 0)
+		|| (settings.writable < 0) || (settings.writable > 1)){
+		cerr << "Error: --owners and --depth must be at least 1, --skew must not be negative"
+			<< " and --writable must be from 0 to 1." << endl;
+		return false;
+	}
+
+	//create the output directory if it doesn't exist yet
+	error_code error;
+	filesystem::create_directories(settings.output, error);
+	if(error){
+		cerr << "Error: the output directory " << settings.output << " could not be created (" << error.message() << ")." << endl;
+		return false;
+	}
+
+	//add trailing slash if the user did not
+	if((settings.output.back() != '\\') && (settings.output.back() != '/')){
+		settings.output += '/';
+	}
+
+	return true;
+}
+
+//write the report for a server, with a mix of world writable files, other files and lines which aren't files
+//returns false if the report could not be written
+static bool write_report(const generator_settings& settings, unsigned server, mt19937_64& random,
+	ZipfPicker& owners, ZipfPicker& directories, const vector<string>& directory_names){
+
+	const string file_name = settings.output + server_name(server) + "-WWFiles-01012024.out";
+
+	ofstream report (file_name.c_str(), ios::binary);
+	if(!report.is_open()){
+		cerr << "Error: " << file_name << " could not be created." << endl;
+		return false;
+	}
+
+	const char types[] = "-----------dlbcps"; //mostly regular files
+	const char* const months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+	uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	string line;
+	for(unsigned long l = 0; l < settings.lines; l++){
+
+		//like real reports, there are some lines which don't describe files
+		if(l % 1000 == 0){
+			report << "total " << (random() % 1000000) << '\n';
+			continue;
+		}
+
+		const string owner = owner_name(owners.pick(random));
+
+		line = types[random() % (sizeof(types) - 1)];
+		line += "rw-r--r";
+		line += (uniform(random) < settings.writable) ? 'w' : '-';
+		line += "- ";
+		line += to_string(1 + random() % 4) + ' ';
+		line += owner + ' ';
+		line += ((random() % 8 == 0) ? "staff" : owner) + ' ';
+		line += to_string(random() % 10000000) + ' ';
+		line += months[random() % 12];
+		line += ' ' + to_string(1 + random() % 28) + ' ';
+		line += to_string(random() % 24) + ':' + to_string(10 + random() % 50) + ' ';
+		line += directory_names[directories.pick(random)];
+		line += "/file" + to_string(random() % 100000) + '.' + EXTENSIONS[random() % NUM_EXTENSIONS];
+
+		report << line << '\n';
+	}
+
+	return report.good();
+}
+
+//write a preferences file with the given number of rules, split between ignoring and critical files
+//the substring rules are directories from the reports, so that a realistic share of the files match them
+static bool write_prefs(const generator_settings& settings, const vector<string>& directory_names, mt19937_64& random){
+
+	const string& file_name = settings.prefs;
+
+	ofstream prefs (file_name.c_str());
+	if(!prefs.is_open()){
+		cerr << "Error: " << file_name << " could not be created." << endl;
+		return false;
+	}
+
+	prefs << "# Generated by WWF Report Generator with " << settings.rules << " rules" << endl
+		<< "SUMMARY_SERVERS=10" << endl
+		<< "SUMMARY_OWNERS=10" << endl
+		<< "HIGH_VOLUME=5" << endl
+		<< "MAX_CRITICAL=1000" << endl;
+
+	for(unsigned r = 0; r < settings.rules; r++){
+
+		const char kind = (r % 2 == 0) ? 'i' : 'c';
+
+		//two in four rules are extensions, until half of the extensions have a rule, and the rest are substrings
+		const unsigned extension = (r / 4) * 2 + (r % 2);
+		if((r % 4 < 2) && (extension < MAX_EXTENSION_RULES)){
+			prefs << kind << '.' << EXTENSIONS[extension] << endl;
+		}
+		else{
+			prefs << kind << ':' << directory_names[random() % directory_names.size()] << '/' << endl;
+		}
+	}
+
+	return prefs.good();
+}
+
+static string server_name(unsigned server){
+	string name = to_string(server);
+	return "server" + string((name.size() < 4) ? 4 - name.size() : 0, '0') + name;
+}
+
+static string owner_name(unsigned owner){
+	return (owner == 0) ? "root" : "user" + to_string(owner);
+}
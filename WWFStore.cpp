@@ -0,0 +1,242 @@
+//WWFStore.cpp
+//Implementation of WWFStore class
+
+#include "WWFStore.h"
+#include "BoundedHeap.h"
+
+#include <vector>
+#include <algorithm>
+using std::vector;
+
+
+bool WWFStore::greater_pair::operator()(const WWF_data* WWF1, const WWF_data* WWF2) const{
+	if(WWF1->count != WWF2->count){
+		return (WWF1->count > WWF2->count);
+	}
+	else if(WWF1->owner != WWF2->owner){
+		return (store->owner_name(WWF1->owner) > store->owner_name(WWF2->owner));
+	}
+	else if(WWF1->server != WWF2->server){
+		return (store->server_name(WWF1->server) > store->server_name(WWF2->server));
+	}
+	else{
+		return (WWF1->critical > WWF2->critical);
+	}
+}
+
+
+WWFStore::WWFStore(){
+	num_pairs = 0;
+}
+
+symbol WWFStore::intern_server(string_view server){
+
+	const symbol id = servers.intern(server);
+
+	//a new server gets a partition
+	if(id == partitions.size()){
+		partitions.push_back(server_partition());
+	}
+
+	return id;
+}
+
+symbol WWFStore::intern_owner(string_view owner){
+
+	const symbol id = owners.intern(owner);
+
+	//a new owner gets a list of its pairs
+	if(id == owner_pairs.size()){
+		owner_pairs.push_back(vector<const WWF_data*>());
+	}
+
+	return id;
+}
+
+symbol WWFStore::server_id(string_view server) const{
+	symbol id = 0;
+	servers.find(server, id);
+	return id;
+}
+
+symbol WWFStore::owner_id(string_view owner) const{
+	symbol id = 0;
+	owners.find(owner, id);
+	return id;
+}
+
+bool WWFStore::find_server(string_view server, symbol& id) const{
+	return servers.find(server, id);
+}
+
+bool WWFStore::find_owner(string_view owner, symbol& id) const{
+	return owners.find(owner, id);
+}
+
+WWF_data& WWFStore::entry(symbol server, symbol owner){
+
+	server_partition& partition = partitions[server];
+
+	//if there is already a pair for this owner on this server, use it
+	unordered_map<symbol, size_t>::iterator i = partition.owner_index.find(owner);
+	if(i != partition.owner_index.end()) return partition.pairs[i->second];
+
+	//otherwise add a new one
+	WWF_data new_WWF;
+
+	new_WWF.server = server;
+	new_WWF.owner = owner;
+	new_WWF.count = 0;
+	new_WWF.critical = 0;
+
+	partition.owner_index[owner] = partition.pairs.size();
+	partition.pairs.push_back(new_WWF);
+	owner_pairs[owner].push_back(&partition.pairs.back());
+	num_pairs++;
+
+	return partition.pairs.back();
+}
+
+void WWFStore::merge(const WWFStore& other){
+
+	//for each pair in the other store, add its counts to the matching pair in this one
+	for(symbol s = 0; s < other.num_servers(); s++){
+
+		const deque<WWF_data>& pairs = other.server_pairs(s);
+		if(pairs.empty()) continue;
+
+		const symbol server = intern_server(other.server_name(s));
+
+		for(deque<WWF_data>::const_iterator i = pairs.begin(); i != pairs.end(); i++){
+			WWF_data& WWF = entry(server, intern_owner(other.owner_name(i->owner)));
+			WWF.count += i->count;
+			WWF.critical += i->critical;
+		}
+	}
+}
+
+void WWFStore::subtract(const WWFStore& other){
+
+	//for each pair in the other store, take its counts from the matching pair in this one
+	for(symbol s = 0; s < other.num_servers(); s++){
+
+		const deque<WWF_data>& pairs = other.server_pairs(s);
+		if(pairs.empty()) continue;
+
+		symbol server;
+		if(!find_server(other.server_name(s), server)) continue;
+
+		server_partition& partition = partitions[server];
+
+		for(deque<WWF_data>::const_iterator i = pairs.begin(); i != pairs.end(); i++){
+
+			symbol owner;
+			if(!find_owner(other.owner_name(i->owner), owner)) continue;
+
+			unordered_map<symbol, size_t>::iterator index = partition.owner_index.find(owner);
+			if(index == partition.owner_index.end()) continue;
+
+			WWF_data& WWF = partition.pairs[index->second];
+			WWF.count -= std::min(WWF.count, i->count);
+			WWF.critical -= std::min(WWF.critical, i->critical);
+
+			if(WWF.count == 0){
+				remove_pair(partition, index->second);
+			}
+		}
+	}
+}
+
+//remove the pair at index from the partition
+//the last pair of the partition is moved into its place, so that the pairs don't move otherwise
+void WWFStore::remove_pair(server_partition& partition, size_t index){
+
+	WWF_data& removed = partition.pairs[index];
+	const WWF_data& last = partition.pairs.back();
+
+	//take the pair out of its owner's pairs
+	vector<const WWF_data*>& removed_owner_pairs = owner_pairs[removed.owner];
+	vector<const WWF_data*>::iterator i = std::find(removed_owner_pairs.begin(), removed_owner_pairs.end(), &removed);
+	*i = removed_owner_pairs.back();
+	removed_owner_pairs.pop_back();
+
+	partition.owner_index.erase(removed.owner);
+
+	if(&removed != &last){
+		//the last pair's owner now finds it at index
+		vector<const WWF_data*>& last_owner_pairs = owner_pairs[last.owner];
+		*std::find(last_owner_pairs.begin(), last_owner_pairs.end(), &last) = &removed;
+
+		partition.owner_index[last.owner] = index;
+		removed = last;
+	}
+
+	partition.pairs.pop_back();
+	num_pairs--;
+}
+
+unsigned WWFStore::num_servers() const{
+	return servers.size();
+}
+
+unsigned WWFStore::num_owners() const{
+	return owners.size();
+}
+
+bool WWFStore::empty() const{
+	return (num_pairs == 0);
+}
+
+string_view WWFStore::server_name(symbol server) const{
+	return servers.name(server);
+}
+
+string_view WWFStore::owner_name(symbol owner) const{
+	return owners.name(owner);
+}
+
+vector<const WWF_data*> WWFStore::sorted_server_pairs(symbol server, size_t limit) const{
+
+	const deque<WWF_data>& pairs = partitions[server].pairs;
+
+	BoundedHeap<const WWF_data*, greater_pair> top(limit, greater_pair(*this));
+	for(deque<WWF_data>::const_iterator i = pairs.begin(); i != pairs.end(); i++){
+		top.push(&*i);
+	}
+
+	return top.sorted();
+}
+
+vector<const WWF_data*> WWFStore::sorted_owner_pairs(symbol owner, size_t limit) const{
+
+	const vector<const WWF_data*>& pairs = owner_pairs[owner];
+
+	BoundedHeap<const WWF_data*, greater_pair> top(limit, greater_pair(*this));
+	for(vector<const WWF_data*>::const_iterator i = pairs.begin(); i != pairs.end(); i++){
+		top.push(*i);
+	}
+
+	return top.sorted();
+}
+
+void WWFStore::totals(vector<unsigned long>& server_files, vector<unsigned long>& owner_files, vector<unsigned long>& server_critical) const{
+
+	server_files.assign(servers.size(), 0);
+	owner_files.assign(owners.size(), 0);
+	server_critical.assign(servers.size(), 0);
+
+	for(symbol s = 0; s < partitions.size(); s++){
+
+		const deque<WWF_data>& pairs = partitions[s].pairs;
+
+		for(deque<WWF_data>::const_iterator i = pairs.begin(); i != pairs.end(); i++){
+			server_files[s] += i->count;
+			owner_files[i->owner] += i->count;
+			server_critical[s] += i->critical;
+		}
+	}
+}
+
+const deque<WWF_data>& WWFStore::server_pairs(symbol server) const{
+	return partitions[server].pairs;
+}
@@ -0,0 +1,103 @@
+/*
+
+WWFStore.h
+
+WWFStore is a class which stores the WWF data for every owner/server pair
+
+Owner and server names are interned to integer IDs and the pairs are partitioned by server,
+so finding the pair for a line of a report is a hash lookup instead of a scan of every pair seen so far
+
+*/
+
+#ifndef _WWFSTORE_H_
+#define _WWFSTORE_H_
+
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <limits>
+#include "data structs.h"
+#include "SymbolTable.h"
+using std::string_view;
+using std::vector;
+using std::deque;
+using std::unordered_map;
+
+
+class WWFStore{
+
+	//interned names of the servers and owners
+	SymbolTable servers;
+	SymbolTable owners;
+
+	//the owner/server pairs found on a server
+	struct server_partition{
+		deque<WWF_data> pairs; //a deque so that adding a pair does not move the others
+		unordered_map<symbol, size_t> owner_index; //owner ID -> index of the owner's pair in pairs
+	};
+
+	deque<server_partition> partitions; //indexed by server ID
+	vector<vector<const WWF_data*> > owner_pairs; //indexed by owner ID, the pairs for that owner on every server
+
+	unsigned long num_pairs;
+
+	void remove_pair(server_partition& partition, size_t index);
+
+public:
+	//used to sort pairs of this store
+	//ordered by count, then by owner name, then by server name, then by number of critical files
+	//greater_pair(store)(WWF1, WWF2) is true iff WWF1 comes before WWF2 when sorting descending
+	struct greater_pair{
+		const WWFStore* store;
+		greater_pair(const WWFStore& store) : store(&store) {}
+		bool operator()(const WWF_data* WWF1, const WWF_data* WWF2) const;
+	};
+
+	WWFStore();
+
+	//return the ID for the name, adding it if it has not been seen before
+	symbol intern_server(string_view server);
+	symbol intern_owner(string_view owner);
+
+	//return the ID for a name which has already been interned
+	symbol server_id(string_view server) const;
+	symbol owner_id(string_view owner) const;
+
+	//find the ID for a name which may not have been interned
+	//returns false iff the name has not been interned
+	bool find_server(string_view server, symbol& id) const;
+	bool find_owner(string_view owner, symbol& id) const;
+
+	//return the pair for the owner on the server, adding an empty one if there is none yet
+	WWF_data& entry(symbol server, symbol owner);
+
+	//add the counts of every pair in other to this store
+	void merge(const WWFStore& other);
+
+	//take the counts of every pair in other (which were merged into this store before) out of this store
+	//a pair whose count drops to 0 is removed, as if it had never been merged
+	void subtract(const WWFStore& other);
+
+	unsigned num_servers() const;
+	unsigned num_owners() const;
+	bool empty() const; //returns true iff there are no owner/server pairs
+
+	//the interned names, which stay valid for the life of the store
+	string_view server_name(symbol server) const;
+	string_view owner_name(symbol owner) const;
+
+	//the (at most limit) largest pairs for the server/owner, sorted by greater_pair
+	vector<const WWF_data*> sorted_server_pairs(symbol server, size_t limit = std::numeric_limits<size_t>::max()) const;
+	vector<const WWF_data*> sorted_owner_pairs(symbol owner, size_t limit = std::numeric_limits<size_t>::max()) const;
+
+	//sum the files for each server and owner, and the critical files for each server, in a single pass over the pairs
+	//the sums are indexed by server/owner ID
+	void totals(vector<unsigned long>& server_files, vector<unsigned long>& owner_files, vector<unsigned long>& server_critical) const;
+
+	//the unsorted pairs for the server
+	const deque<WWF_data>& server_pairs(symbol server) const;
+};
+
+
+#endif
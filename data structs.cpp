@@ -3,21 +3,6 @@
 
 #include "data structs.h"
 
-bool operator>(const WWF_data& WWF1, const WWF_data& WWF2){
-	if(WWF1.count != WWF2.count){
-		return (WWF1.count > WWF2.count);
-	}
-	else if(WWF1.owner != WWF2.owner){
-		return (WWF1.owner > WWF2.owner);
-	}
-	else if(WWF1.owner != WWF2.owner){
-		return (WWF1.server > WWF2.server);
-	}
-	else{
-		return (WWF1.critical > WWF2.critical);
-	}
-}
-
 bool operator>(const occurrences& occ1, const occurrences& occ2){
 	if(occ1.count != occ2.count){
 		return (occ1.count > occ2.count);
@@ -10,26 +10,26 @@ Contains the data structures used in WWF Analyzer
 #define _DATA_STRUCTS_H_
 
 #include <string>
+#include <string_view>
 using std::string;
+using std::string_view;
 
 //stores data about a given owner on a given server
+//the owner and server are IDs from the symbol tables of the WWFStore holding the data
 struct WWF_data{
-	string owner; //the owner of the WWF
-	string server; //name of the server where the WWF is found
+	unsigned owner; //the owner of the WWF
+	unsigned server; //the server where the WWF is found
 	unsigned long count; //the number of files
 	unsigned long critical; //the number of files that are critical
 };
 
-//overload > operator for use in sorting
-//ordered by count, then by owner name, then by server name, then by number of critical files
-//.sort(greater<WWF_data>()) to sort descending
-bool operator>(const WWF_data& WWF1, const WWF_data& WWF2);
+//WWF_data is sorted with WWFStore::greater_pair, since the names are needed to order it
 
 
 
 //used to sum all of the files for owners/servers to determine which have the most files
 struct occurrences{
-	string entity; //name of the owner/server
+	string_view entity; //name of the owner/server (interned in a WWFStore)
 	unsigned long count; //the number of files for the owner/server
 };
 
@@ -42,12 +42,22 @@ bool operator>(const occurrences& occ1, const occurrences& occ2);
 
 //used to store owner/file pairs for critical files
 struct critical_file_owner{
-	string owner; //name of the owner
-	string file; //the critical file
+	string_view owner; //name of the owner (interned in a WWFStore)
+	string_view file; //the critical file (stored in the arena of a CriticalFiles)
 };
 
 //overload < operator for use in sorting
 //ordered by owner name, then by file name
 bool operator<(const critical_file_owner& cfo1, const critical_file_owner& cfo2);
 
+
+
+//a WWF report to be analyzed
+struct report_file{
+	string file_name; //name of the report file
+	string server_name; //name of the server that the report is for
+	unsigned long long size; //size of the report file in bytes
+	long long modified; //the time that the report file was last modified
+};
+
 #endif